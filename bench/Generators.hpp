@@ -0,0 +1,56 @@
+#pragma once
+
+
+#include <cstddef>
+#include <string>
+
+
+// synthetic BCC sources of a given size, used by bcc_bench and bcc_stress.
+// Every generator grows its output linearly in `count`, so any super-linear phase time is the pipeline's doing.
+namespace Generators {
+	// `count` small functions, each called once
+	inline std::string functions(const size_t count) {
+		std::string res;
+		for(size_t i = 0; i < count; i++) {
+			const std::string n = std::to_string(i);
+			res += "int f" + n + "(int a, int b) {\n\tint c = a * " + n + " + b;\n\tif(c > 100) return c - 100;\n\treturn c + " + n + ";\n}\n";
+		}
+		res += "int sum = 0;\n";
+		for(size_t i = 0; i < count; i++)
+			res += "sum = sum + f" + std::to_string(i) + "(" + std::to_string(i % 7) + ", sum / 1000);\n";
+		return res;
+	}
+
+	// `count` pairs of global declarations / assignments
+	inline std::string straightLine(const size_t count) {
+		std::string res = "int x0 = 1;\nfloat y = 0.5;\n";
+		for(size_t i = 1; i < count; i++) {
+			const std::string n = std::to_string(i), p = std::to_string(i - 1);
+			res += "int x" + n + " = (x" + p + " * 3 + " + n + ") / 2 - (x" + p + " - 1);\n";
+			res += "y = y * 0.5 + x" + n + ";\n";
+		}
+		return res;
+	}
+
+	// `depth` nested if blocks
+	inline std::string nesting(const size_t depth) {
+		std::string res = "int x = 0;\n";
+		for(size_t i = 0; i < depth; i++) {
+			const std::string tabs(i, '\t');
+			res += tabs + "if(x >= 0) {\n" + tabs + "\tx = x + 1;\n";
+		}
+		for(size_t i = depth; i-- > 0;)
+			res += std::string(i, '\t') + "}\n";
+		return res;
+	}
+
+	// a single expression with `terms` operands
+	inline std::string expression(const size_t terms) {
+		static constexpr const char* ops[] = { " + ", " * ", " - ", " / " };
+
+		std::string res = "int a = 3;\nint x = 1";
+		for(size_t i = 1; i < terms; i++)
+			res += std::string(ops[i % 4]) + (i % 3 == 0 ? "a" : std::to_string(i % 9 + 1));
+		return res + ";\n";
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+
+#include <ostream>
+#include <string>
+
+#include "Lexer.hpp"
+#include "Parser.hpp"
+#include "SemanticAnalyzer.hpp"
+#include "ScopedSymbolTable.hpp"
+#include "Builtins.hpp"
+#include "Inliner.hpp"
+#include "Interpreter.hpp"
+#include "PhaseReport.hpp"
+
+
+// shared by bcc_bench and bcc_stress: runs a source through the whole pipeline and times every phase.
+// The including translation unit defines BCC_ALLOCATION_COUNTER_IMPLEMENTATION.
+
+class NullStream: private std::streambuf, public std::ostream {
+public:
+	inline NullStream(): std::ostream(this) {}
+};
+
+// `reconstruct` adds a "print" phase (ParseTree::Node::toString()) after parsing
+inline PhaseReport runPipeline(const std::string& source, const bool reconstruct = false) {
+	PhaseReport report;
+	NullStream null;
+
+	report.begin("lex");
+	ImmediateLexer lexer(source);
+	report.end().add("tokens", lexer.tokenCount());
+
+	report.begin("parse");
+	const uint32_t parseNodes = ParseTree::Node::count();
+	Parser parser(lexer);
+	const ParseTree::Program* tree = parser.program();
+	report.end().add("nodes", ParseTree::Node::count() - parseNodes);
+
+	if(reconstruct) {
+		report.begin("print");
+		const std::string reconstructed = tree->toString(0);
+		report.end().add("chars", reconstructed.size());
+	}
+
+	ScopedSymbolTable globalScope("Global Scope");
+	globalScope.declare(new Symbol(Symbol::Category::TYPE, "void", "__VOID__"));
+	globalScope.declare(new Symbol(Symbol::Category::TYPE, "bool", "__BOOL__"));
+	globalScope.declare(new Symbol(Symbol::Category::TYPE, "int", "__INT__"));
+	globalScope.declare(new Symbol(Symbol::Category::TYPE, "float", "__FLOAT__"));
+	globalScope.declare(new Symbol(Symbol::Category::TYPE, "string", "__STRING__"));
+	globalScope.declare(new Symbol(Symbol::Category::TYPE, "bool[]", "__BOOL_ARRAY__"));
+	globalScope.declare(new Symbol(Symbol::Category::TYPE, "int[]", "__INT_ARRAY__"));
+	globalScope.declare(new Symbol(Symbol::Category::TYPE, "float[]", "__FLOAT_ARRAY__"));
+
+	BuiltinRegistry builtins;
+	builtins.addStandardLibrary();
+	builtins.declare(&globalScope);
+
+	report.begin("analyze");
+	const uint32_t astNodes = AST::Node::count();
+	const AST::Node* ast = SemanticAnalyzer::visit(tree, &globalScope);
+	report.end().add("nodes", AST::Node::count() - astNodes);
+
+	report.begin("inline");
+	Inliner inliner;
+	ast = inliner.run(ast);
+	AST::Node::number(ast);
+	report.end().add("inlined", inliner.report().inlined.size());
+
+	report.begin("execute");
+	Interpreter interpreter(ast, null);
+	interpreter.run();
+	report.end();
+
+	return report;
+}
@@ -0,0 +1,162 @@
+#include <filesystem>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define BCC_ALLOCATION_COUNTER_IMPLEMENTATION
+#include "Pipeline.hpp"
+#include "Generators.hpp"
+
+
+// bcc_bench [--warmup N] [--reps N] [--out results.json] [--corpus dir]
+//
+// Runs every script of the corpus (*.bcc) plus generated large sources through the whole pipeline
+// and reports min / median / mean time, allocations and counters of every phase.
+// The corpus covers:
+//   fib               recursive calls (call overhead, scope creation, argument binding)
+//   string_concat     string concatenation chains with implicit conversions
+//   deep_expressions  deeply nested int / float arithmetic
+//   small_functions   many small non-recursive functions (inliner, call dispatch)
+//   gen_functions     generated: many function declarations and calls (front end throughput)
+//   gen_straight_line generated: long straight-line code (lexer / parser throughput)
+
+#ifndef BCC_BENCH_CORPUS
+#define BCC_BENCH_CORPUS "bench/scripts"
+#endif
+
+
+struct Workload {
+	std::string name;
+	std::string source;
+};
+
+struct PhaseSummary {
+	std::string name;
+	double minMs, medianMs, meanMs;
+	uint64_t allocations, bytes; // of the last repetition
+	std::vector<std::pair<std::string, uint64_t>> counters;
+};
+
+inline std::vector<Workload> loadCorpus(const std::filesystem::path& dir) {
+	std::vector<Workload> res;
+
+	if(std::filesystem::is_directory(dir)) {
+		for(const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(dir)) {
+			if(entry.path().extension().string() != ".bcc")
+				continue;
+
+			std::ifstream file(entry.path(), std::ios::binary);
+			std::stringstream ss;
+			ss << file.rdbuf();
+			res.push_back({ entry.path().stem().string(), ss.str() });
+		}
+	} else {
+		std::cerr << "warning: corpus directory \"" << dir.string() << "\" not found, only running generated workloads\n";
+	}
+
+	std::sort(res.begin(), res.end(), [](const Workload& a, const Workload& b) { return a.name < b.name; });
+
+	res.push_back({ "gen_functions", Generators::functions(300) });
+	res.push_back({ "gen_straight_line", Generators::straightLine(2000) });
+
+	for(Workload& workload : res)
+		workload.source += "\n"; // the lexer needs a character after the last token
+
+	return res;
+}
+
+inline std::vector<PhaseSummary> summarize(const std::vector<PhaseReport>& runs) {
+	std::vector<PhaseSummary> res;
+
+	for(size_t p = 0; p < runs.front().phases().size(); p++) {
+		std::vector<double> ms;
+		for(const PhaseReport& run : runs)
+			ms.push_back(run.phases()[p].ms);
+		std::sort(ms.begin(), ms.end());
+
+		double sum = 0;
+		for(const double v : ms)
+			sum += v;
+
+		const PhaseReport::Phase& last = runs.back().phases()[p];
+		const double median = ms.size() % 2 ? ms[ms.size() / 2] : (ms[ms.size() / 2 - 1] + ms[ms.size() / 2]) / 2;
+		res.push_back({ last.name, ms.front(), median, sum / ms.size(), last.allocations, last.bytes, last.counters });
+	}
+
+	return res;
+}
+
+inline void writeJSON(std::ostream& out, const size_t warmup, const size_t reps, const std::vector<std::pair<std::string, std::vector<PhaseSummary>>>& results) {
+	out << "{\"warmup\":" << warmup << ",\"repetitions\":" << reps << ",\"workloads\":[";
+	for(size_t w = 0; w < results.size(); w++) {
+		if(w > 0) out << ",";
+		out << "\n{\"name\":\"" << results[w].first << "\",\"phases\":[";
+
+		const std::vector<PhaseSummary>& phases = results[w].second;
+		for(size_t p = 0; p < phases.size(); p++) {
+			const PhaseSummary& s = phases[p];
+			if(p > 0) out << ",";
+			out << "{\"name\":\"" << s.name << "\",\"min_ms\":" << s.minMs << ",\"median_ms\":" << s.medianMs << ",\"mean_ms\":" << s.meanMs
+				<< ",\"allocations\":" << s.allocations << ",\"bytes\":" << s.bytes;
+			for(const auto& [counter, value] : s.counters)
+				out << ",\"" << counter << "\":" << value;
+			out << "}";
+		}
+		out << "]}";
+	}
+	out << "\n]}\n";
+}
+
+int main(int argc, char** argv) {
+	size_t warmup = 2, reps = 10;
+	std::string out = "bcc_bench.json";
+	std::string corpus = BCC_BENCH_CORPUS;
+
+	for(int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if(arg == "--warmup" && hasValue) warmup = std::stoul(argv[++i]);
+		else if(arg == "--reps" && hasValue) reps = std::max<size_t>(1, std::stoul(argv[++i]));
+		else if(arg == "--out" && hasValue) out = argv[++i];
+		else if(arg == "--corpus" && hasValue) corpus = argv[++i];
+		else {
+			std::cerr << "usage: bcc_bench [--warmup N] [--reps N] [--out results.json] [--corpus dir]\n";
+			return 1;
+		}
+	}
+
+	std::vector<std::pair<std::string, std::vector<PhaseSummary>>> results;
+
+	try {
+		for(const Workload& workload : loadCorpus(corpus)) {
+			for(size_t i = 0; i < warmup; i++)
+				runPipeline(workload.source);
+
+			std::vector<PhaseReport> runs;
+			for(size_t i = 0; i < reps; i++)
+				runs.push_back(runPipeline(workload.source));
+
+			results.push_back({ workload.name, summarize(runs) });
+
+			std::cout << workload.name << ":\n";
+			for(const PhaseSummary& s : results.back().second) {
+				std::cout << "  " << s.name << ": median " << s.medianMs << " ms, min " << s.minMs << " ms, " << s.allocations << " allocations";
+				for(const auto& [counter, value] : s.counters)
+					std::cout << ", " << counter << "=" << value;
+				std::cout << "\n";
+			}
+		}
+	} catch(const std::exception& e) {
+		std::cerr << "Exception thrown: " << e.what() << "\n";
+		return 1;
+	}
+
+	std::ofstream file(out);
+	writeJSON(file, warmup, reps, results);
+	std::cout << "results written to " << out << "\n";
+
+	return 0;
+}
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <map>
+
+#define BCC_ALLOCATION_COUNTER_IMPLEMENTATION
+#include "Pipeline.hpp"
+#include "Generators.hpp"
+
+
+// bcc_stress [--steps N] [--reps N] [--threshold X] [--out results.json]
+//
+// Grows generated programs along one axis at a time (statements, nesting depth, expression length, function count),
+// doubling the size `steps` times, and fits every phase's median time against the size on a log-log scale:
+// time ~ size^k. Phases with k above the threshold (default 1.3) are flagged as super-linear
+// and the exit code is 2. Phases that stay below `minMs` at the largest size are too noisy to judge and never flagged.
+
+struct Axis {
+	std::string name;
+	size_t base;
+	std::string (*generate)(size_t);
+};
+
+struct PhaseFit {
+	std::string phase;
+	std::vector<double> ms; // median per size
+	double exponent;
+	bool flagged;
+};
+
+constexpr double minMs = 0.1;
+
+
+inline double median(std::vector<double> v) {
+	std::sort(v.begin(), v.end());
+	return v.size() % 2 ? v[v.size() / 2] : (v[v.size() / 2 - 1] + v[v.size() / 2]) / 2;
+}
+
+// least squares slope of log(ms) over log(size)
+inline double fitExponent(const std::vector<size_t>& sizes, const std::vector<double>& ms) {
+	double sx = 0, sy = 0, sxx = 0, sxy = 0;
+	const double n = static_cast<double>(sizes.size());
+	for(size_t i = 0; i < sizes.size(); i++) {
+		const double x = std::log(static_cast<double>(sizes[i]));
+		const double y = std::log(std::max(ms[i], 1e-6));
+		sx += x; sy += y; sxx += x * x; sxy += x * y;
+	}
+	const double d = n * sxx - sx * sx;
+	return d != 0 ? (n * sxy - sx * sy) / d : 0;
+}
+
+inline std::vector<PhaseFit> measure(const Axis& axis, const std::vector<size_t>& sizes, const size_t reps, const double threshold) {
+	std::map<std::string, std::vector<double>> perPhase;
+	std::vector<std::string> order;
+
+	for(const size_t size : sizes) {
+		const std::string source = axis.generate(size) + "\n";
+		runPipeline(source, true); // warmup
+
+		std::map<std::string, std::vector<double>> samples;
+		for(size_t r = 0; r < reps; r++) {
+			const PhaseReport report = runPipeline(source, true);
+			for(const PhaseReport::Phase& phase : report.phases()) {
+				if(!perPhase.contains(phase.name) && !samples.contains(phase.name))
+					order.push_back(phase.name);
+				samples[phase.name].push_back(phase.ms);
+			}
+		}
+
+		for(const auto& [phase, ms] : samples)
+			perPhase[phase].push_back(median(ms));
+	}
+
+	std::vector<PhaseFit> res;
+	for(const std::string& phase : order) {
+		const std::vector<double>& ms = perPhase[phase];
+		const double exponent = fitExponent(sizes, ms);
+		res.push_back({ phase, ms, exponent, exponent > threshold && ms.back() >= minMs });
+	}
+	return res;
+}
+
+int main(int argc, char** argv) {
+	size_t steps = 5, reps = 5;
+	double threshold = 1.3;
+	std::string out;
+
+	for(int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if(arg == "--steps" && hasValue) steps = std::max<size_t>(2, std::stoul(argv[++i]));
+		else if(arg == "--reps" && hasValue) reps = std::max<size_t>(1, std::stoul(argv[++i]));
+		else if(arg == "--threshold" && hasValue) threshold = std::stod(argv[++i]);
+		else if(arg == "--out" && hasValue) out = argv[++i];
+		else {
+			std::cerr << "usage: bcc_stress [--steps N] [--reps N] [--threshold X] [--out results.json]\n";
+			return 1;
+		}
+	}
+
+	const std::vector<Axis> axes = {
+		{ "statements", 125, &Generators::straightLine },
+		{ "nesting", 16, &Generators::nesting },
+		{ "expression", 64, &Generators::expression },
+		{ "functions", 25, &Generators::functions },
+	};
+
+	std::vector<std::pair<std::vector<size_t>, std::vector<PhaseFit>>> results;
+	bool anyFlagged = false;
+
+	try {
+		for(const Axis& axis : axes) {
+			std::vector<size_t> sizes;
+			for(size_t i = 0; i < steps; i++)
+				sizes.push_back(axis.base << i);
+
+			const std::vector<PhaseFit> fits = measure(axis, sizes, reps, threshold);
+			results.push_back({ sizes, fits });
+
+			std::cout << axis.name << ":\n  " << std::setw(10) << std::left << "phase" << std::right;
+			for(const size_t size : sizes)
+				std::cout << std::setw(11) << size;
+			std::cout << std::setw(10) << "k" << "\n";
+
+			for(const PhaseFit& fit : fits) {
+				anyFlagged |= fit.flagged;
+				std::cout << "  " << std::setw(10) << std::left << fit.phase << std::right << std::fixed << std::setprecision(3);
+				for(const double ms : fit.ms)
+					std::cout << std::setw(11) << ms;
+				std::cout << std::setw(10) << std::setprecision(2) << fit.exponent << (fit.flagged ? "  SUPER-LINEAR" : "") << "\n";
+			}
+			std::cout.unsetf(std::ios::floatfield);
+			std::cout << std::setprecision(6);
+		}
+	} catch(const std::exception& e) {
+		std::cerr << "Exception thrown: " << e.what() << "\n";
+		return 1;
+	}
+
+	if(!out.empty()) {
+		std::ofstream file(out);
+		file << "{\"threshold\":" << threshold << ",\"repetitions\":" << reps << ",\"axes\":[";
+		for(size_t a = 0; a < axes.size(); a++) {
+			if(a > 0) file << ",";
+			file << "\n{\"name\":\"" << axes[a].name << "\",\"sizes\":[";
+			for(size_t i = 0; i < results[a].first.size(); i++)
+				file << (i > 0 ? "," : "") << results[a].first[i];
+			file << "],\"phases\":[";
+			for(size_t p = 0; p < results[a].second.size(); p++) {
+				const PhaseFit& fit = results[a].second[p];
+				file << (p > 0 ? "," : "") << "{\"name\":\"" << fit.phase << "\",\"median_ms\":[";
+				for(size_t i = 0; i < fit.ms.size(); i++)
+					file << (i > 0 ? "," : "") << fit.ms[i];
+				file << "],\"exponent\":" << fit.exponent << ",\"flagged\":" << (fit.flagged ? "true" : "false") << "}";
+			}
+			file << "]}";
+		}
+		file << "\n]}\n";
+		std::cout << "results written to " << out << "\n";
+	}
+
+	return anyFlagged ? 2 : 0;
+}
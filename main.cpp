@@ -1,11 +1,19 @@
 #include <iostream>
 #include <streambuf>
+#include <string>
 
 #include "Lexer.hpp"
 #include "Parser.hpp"
 #include "SemanticAnalyzer.hpp"
 #include "ScopedSymbolTable.hpp"
+#include "Builtins.hpp"
+#include "Inliner.hpp"
 #include "Interpreter.hpp"
+#include "Profiler.hpp"
+#include "LineCounter.hpp"
+#include "Trace.hpp"
+#define BCC_ALLOCATION_COUNTER_IMPLEMENTATION
+#include "PhaseReport.hpp"
 
 
 constexpr const char *const code = R"(
@@ -15,8 +23,16 @@ constexpr const char *const code = R"(
 		return f(x - 1) + f(x - 2);
 	}
 
+	int square(int x) {
+		int y = x * x;
+		return y;
+	}
+
 	int b = f(5);
+	int c = square(b + 1) + square(2);
 	string a = "asdf " + true + b + " ; " + 1 + (2 + 3);
+	float r = sqrt(c) + max(b, 3);
+	print(a + " / " + len(a));
 )";
 
 class DummyLogger: private std::streambuf, public std::ostream {
@@ -24,17 +40,24 @@ public:
 	inline DummyLogger(): std::ostream(this) {}
 };
 
-void run() {
+void run(const bool json, const bool binaryTrace) {
 	DummyLogger dout;
 	// std::ostream& cout = dout;
 	std::ostream& cout = std::cout;
 
-	Lexer lexer(code);
-	Parser parser(lexer);
+	PhaseReport report;
+
+	report.begin("lex");
+	ImmediateLexer lexer(code);
+	report.end().add("tokens", lexer.tokenCount());
 
 	cout << lexer << "\n";
 
+	report.begin("parse");
+	const uint32_t parseNodes = ParseTree::Node::count();
+	Parser parser(lexer);
 	const ParseTree::Program* tree = parser.program();
+	report.end().add("nodes", ParseTree::Node::count() - parseNodes);
 
 	tree->print(cout, "", true);
 
@@ -46,8 +69,27 @@ void run() {
 	globalScope.declare(new Symbol(Symbol::Category::TYPE, "int", "__INT__"));
 	globalScope.declare(new Symbol(Symbol::Category::TYPE, "float", "__FLOAT__"));
 	globalScope.declare(new Symbol(Symbol::Category::TYPE, "string", "__STRING__"));
+	globalScope.declare(new Symbol(Symbol::Category::TYPE, "bool[]", "__BOOL_ARRAY__"));
+	globalScope.declare(new Symbol(Symbol::Category::TYPE, "int[]", "__INT_ARRAY__"));
+	globalScope.declare(new Symbol(Symbol::Category::TYPE, "float[]", "__FLOAT_ARRAY__"));
 
+	BuiltinRegistry builtins;
+	builtins.addStandardLibrary();
+	builtins.declare(&globalScope);
+
+	report.begin("analyze");
+	const uint32_t astNodes = AST::Node::count();
 	const AST::Node* ast = SemanticAnalyzer::visit(tree, &globalScope);
+	report.end().add("nodes", AST::Node::count() - astNodes);
+
+	report.begin("inline");
+	const uint32_t inlinedNodes = AST::Node::count();
+	Inliner inliner;
+	ast = inliner.run(ast);
+	AST::Node::number(ast);
+	report.end().add("nodes", AST::Node::count() - inlinedNodes).add("inlined", inliner.report().inlined.size());
+
+	inliner.report().print(cout);
 
 	cout << "AST: " << ast << "\n";
 	ast->print(cout, "", true);
@@ -55,14 +97,53 @@ void run() {
 
 	globalScope.print(cout);
 
+	Profiler profiler;
 	Interpreter interpreter(ast, cout);
+	interpreter.setProfiler(&profiler);
+	LineCounter lineCounter(code);
+	interpreter.setLineCounter(&lineCounter);
+	TraceBuffer traceBuffer;
+	if(binaryTrace)
+		interpreter.setTrace(TraceMode::BINARY, &traceBuffer);
 	cout << "\nInterpreting:\n";
+	Interpreter::resetStats();
+	report.begin("execute");
 	interpreter.run();
+	report.end();
+	const InterpreterStats stats = Interpreter::stats();
+
+	if(binaryTrace) {
+		cout << "Decoded Trace (" << traceBuffer.pushed() << " events):\n";
+		TraceDecoder(ast).decode(traceBuffer.snapshot(), cout);
+	}
+
+	cout << "\n";
+	profiler.print(cout);
+	cout << "\nFolded stacks:\n";
+	profiler.writeFolded(cout);
+	cout << "\n";
+	lineCounter.print(cout);
+	cout << "\n";
+	stats.print(cout);
+
+	cout << "\n";
+	if(json)
+		report.printJSON(cout);
+	else
+		report.print(cout);
 }
 
-int main() {
+int main(int argc, char** argv) {
+	bool json = false; // phase report as JSON
+	bool binaryTrace = false; // record the execution trace as binary events and decode it afterwards
+	for(int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		if(arg == "--json") json = true;
+		if(arg == "--binary-trace") binaryTrace = true;
+	}
+
 	try {
-		run();
+		run(json, binaryTrace);
 	} catch(const std::exception& e) {
 		std::cout << "Exception thrown: " << e.what() << "\n";
 	}
@@ -2,12 +2,19 @@
 
 
 #include <stdexcept>
+#include <algorithm>
 #include <ostream>
+#include <functional>
+#include <unordered_set>
+#include <atomic>
 #include <cstdint>
 #include <string>
 #include <vector>
 
 #include "ScopedSymbolTable.hpp"
+#include "ObjectPool.hpp"
+#include "Builtins.hpp"
+#include "Record.hpp"
 #include "Tokens.hpp"
 #include "Types.hpp"
 
@@ -33,30 +40,53 @@ namespace AST {
 		};
 
 	protected:
-		ScopedSymbolTable* scope;
+		const ScopedSymbolTable* scope;
 
 	private:
+		inline static std::atomic<uint32_t> nodeCount{ 0 };
+
 		BaseType baseType_;
-		Span span_;
+		mutable Span span_; // source range, set by the SemanticAnalyzer / Inliner after construction
+		mutable uint32_t id_; // node index used to index per-node side tables, dense within a program once number() ran
 
 	public:
-		inline Node(ScopedSymbolTable* scope, const BaseType baseType): scope(scope), baseType_(baseType) {}
-		inline virtual ~Node() {}
+		inline Node(const ScopedSymbolTable* scope, const BaseType baseType): scope(scope), baseType_(baseType), id_(nodeCount++) { ObjectPool::adopt(this); }
+		inline virtual ~Node() { ObjectPool::forget(this); }
 	
 	public:
+		inline static uint32_t count() { return nodeCount; } // number of ids handed out so far
+
+		// constructor ids are unique in the process, so tables indexed by them grow with every program compiled so far.
+		// Renumbers the nodes reachable from root (shared nodes once) to 0 .. n-1 and returns n
+		inline static uint32_t number(const Node* root) {
+			std::unordered_set<const Node*> visited;
+			uint32_t next = 0;
+			const std::function<void(const Node*)> visit = [&](const Node* node) {
+				if(!visited.insert(node).second)
+					return;
+				node->id_ = next++;
+				node->forEachChild(visit);
+			};
+			visit(root);
+			return next;
+		}
 		inline BaseType baseType() const { return baseType_; }
 		inline Span span() const { return span_; }
+		inline void setSpan(const Span& span) const { span_ = span; }
+		inline uint32_t id() const { return id_; }
 		inline const ScopedSymbolTable& getScope() const { return *scope; }
 
 	public:
 		inline virtual void print(std::ostream& console, const std::string& indent = "", const bool isLast = true) const = 0;
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const {} // visits direct children (used by AST passes)
 	};
 
 
 	struct ExpressionNode : public Node {
 	public:
 		enum class Type : uint8_t {
-			LITERAL_EXPRESSION, VARIABLE_EXPRESSION, UNARY_EXPRESSION, BINARY_EXPRESSION, CALL_EXPRESSION,
+			LITERAL_EXPRESSION, VARIABLE_EXPRESSION, UNARY_EXPRESSION, BINARY_EXPRESSION, CALL_EXPRESSION, INLINED_CALL_EXPRESSION, BUILTIN_CALL_EXPRESSION,
+			ARRAY_EXPRESSION, INDEX_EXPRESSION, LENGTH_EXPRESSION, RECORD_EXPRESSION, FIELD_EXPRESSION, CONCAT_EXPRESSION,
 		};
 
 	private:
@@ -64,7 +94,7 @@ namespace AST {
 		EvalType evalType_;
 
 	public:
-		inline ExpressionNode(ScopedSymbolTable* scope_, const Type type, const EvalType& evalType): Node(scope_, BaseType::EXPRESSION), type_(type), evalType_(evalType) {}
+		inline ExpressionNode(const ScopedSymbolTable* scope_, const Type type, const EvalType& evalType): Node(scope_, BaseType::EXPRESSION), type_(type), evalType_(evalType) {}
 		inline Type type() const { return type_; }
 		inline const EvalType& evalType() const { return evalType_; }
 	};
@@ -73,14 +103,15 @@ namespace AST {
 	public:
 		enum class Type : uint8_t {
 			EXPRESSION_STATEMENT, STATEMENT_LIST, RETURN_STATEMENT,
-			IF_STATEMENT, WHILE_STATEMENT, FUNCTION_DECLARATION_STATEMENT, VARIABLE_DECLARATION_STATEMENT, VARIABLE_ASSIGNMENT_STATEMENT,
+			IF_STATEMENT, WHILE_STATEMENT, FOR_STATEMENT, COUNTED_FOR_STATEMENT, SWITCH_STATEMENT, BREAK_STATEMENT, CONTINUE_STATEMENT, FUNCTION_DECLARATION_STATEMENT, VARIABLE_DECLARATION_STATEMENT, VARIABLE_ASSIGNMENT_STATEMENT,
+			ELEMENT_ASSIGNMENT_STATEMENT, FIELD_ASSIGNMENT_STATEMENT, STRUCT_DECLARATION_STATEMENT,
 		};
 
 	private:
 		Type type_;
 	
 	public:
-		inline StatementNode(ScopedSymbolTable* scope_, const Type type): Node(scope_, BaseType::STATEMENT), type_(type) {}
+		inline StatementNode(const ScopedSymbolTable* scope_, const Type type): Node(scope_, BaseType::STATEMENT), type_(type) {}
 		inline Type type() const { return type_; }
 	};
 
@@ -92,7 +123,7 @@ namespace AST {
 		} op; // operation
 		const ExpressionNode *a;
 
-		inline UnaryExpressionNode(ScopedSymbolTable* scope_, const std::string& op_, const ExpressionNode* a):
+		inline UnaryExpressionNode(const ScopedSymbolTable* scope_, const std::string& op_, const ExpressionNode* a):
 			ExpressionNode(scope_, Type::UNARY_EXPRESSION, a->evalType()),
 			a(a) {
 			if(op_ == "+") op = Operation::PLUS;
@@ -108,6 +139,8 @@ namespace AST {
 			throw std::runtime_error("Invalid unary operator enum value");
 		}
 
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { f(a); }
+
 		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
 			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
 			console << opString();
@@ -128,7 +161,7 @@ namespace AST {
 		Operation op; // operation
 		const ExpressionNode *b;
 
-		inline BinaryExpressionNode(ScopedSymbolTable* scope_, const ExpressionNode* a, const std::string& op_, const ExpressionNode* b):
+		inline BinaryExpressionNode(const ScopedSymbolTable* scope_, const ExpressionNode* a, const std::string& op_, const ExpressionNode* b):
 				ExpressionNode(
 					scope_,
 					Type::BINARY_EXPRESSION,
@@ -164,6 +197,8 @@ namespace AST {
 			throw std::runtime_error("Invalid binary operator enum value");
 		}
 
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { f(a); f(b); }
+
 		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
 			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
 			console << opString();
@@ -175,10 +210,36 @@ namespace AST {
 		}
 	};
 
+	// a chain "s + x + y + ..." starting with a string (folded by the SemanticAnalyzer). The parts are evaluated left to
+	// right and appended to one buffer sized for the whole result, instead of copying the prefix at every +.
+	struct ConcatExpressionNode : public ExpressionNode {
+		std::vector<const ExpressionNode*> parts;
+
+		inline ConcatExpressionNode(const ScopedSymbolTable* scope_, const std::vector<const ExpressionNode*>& parts):
+				ExpressionNode(scope_, Type::CONCAT_EXPRESSION, EvalType("string")),
+				parts(parts) {
+			if(parts.size() < 2 || parts.front()->evalType().type() != "string")
+				throw std::runtime_error("ConcatExpressionNode: expected a string followed by at least one part");
+			for(const ExpressionNode* part : parts)
+				binaryExpressionType(evalType(), "+", part->evalType()); // throws for parts that can not be appended to a string
+		}
+
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { for(const ExpressionNode* part : parts) f(part); }
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+			console << RBRANCH << "    ConcatExpression -> " << evalType().type() << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			for(const ExpressionNode* part : parts)
+				part->print(console, subIndent, part == parts.back());
+		}
+	};
+
 	struct IdentifierNode : public ExpressionNode {
 		std::string name;
 
-		inline IdentifierNode(ScopedSymbolTable* scope_, const std::string& name):
+		inline IdentifierNode(const ScopedSymbolTable* scope_, const std::string& name):
 			ExpressionNode(
 				scope_,
 				Type::VARIABLE_EXPRESSION,
@@ -196,7 +257,7 @@ namespace AST {
 		enum class LiteralType : uint8_t {
 			BOOL, INT, FLOAT, STRING
 		} type;
-		inline LiteralNode(ScopedSymbolTable* scope_, const LiteralType type, const EvalType& evalType):
+		inline LiteralNode(const ScopedSymbolTable* scope_, const LiteralType type, const EvalType& evalType):
 			ExpressionNode(scope_, Type::LITERAL_EXPRESSION, evalType),
 			type(type) {}
 	};
@@ -204,7 +265,7 @@ namespace AST {
 	struct BoolLiteralNode : public LiteralNode {
 		bool value;
 
-		inline BoolLiteralNode(ScopedSymbolTable* scope_, const bool value):
+		inline BoolLiteralNode(const ScopedSymbolTable* scope_, const bool value):
 			LiteralNode(scope_, LiteralNode::LiteralType::BOOL, EvalType("bool")),
 			value(value) {}
 
@@ -217,7 +278,7 @@ namespace AST {
 	struct IntLiteralNode : public LiteralNode {
 		int value;
 
-		inline IntLiteralNode(ScopedSymbolTable* scope_, const int value):
+		inline IntLiteralNode(const ScopedSymbolTable* scope_, const int value):
 			LiteralNode(scope_, LiteralNode::LiteralType::INT, EvalType("int")),
 			value(value) {}
 
@@ -230,7 +291,7 @@ namespace AST {
 	struct FloatLiteralNode : public LiteralNode {
 		float value;
 
-		inline FloatLiteralNode(ScopedSymbolTable* scope_, const float value):
+		inline FloatLiteralNode(const ScopedSymbolTable* scope_, const float value):
 			LiteralNode(scope_, LiteralNode::LiteralType::FLOAT, EvalType("float")),
 			value(value) {}
 
@@ -242,10 +303,11 @@ namespace AST {
 
 	struct StringLiteralNode : public LiteralNode {
 		std::string value;
+		StringRef shared; // the same characters, every evaluation of the literal shares them
 
-		inline StringLiteralNode(ScopedSymbolTable* scope_, const std::string& value):
+		inline StringLiteralNode(const ScopedSymbolTable* scope_, const std::string& value):
 			LiteralNode(scope_, LiteralNode::LiteralType::STRING, EvalType("string")),
-			value(value) {}
+			value(value), shared(std::make_shared<const std::string>(value)) {}
 
 		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
 			console << indent << (isLast ? LBRANCH : VBRANCH) << "\"" << value << "\"";
@@ -254,44 +316,141 @@ namespace AST {
 	};
 
 
+	// new array of elementType: "T[length]" with zero initialized elements, or a literal "[a, b, c]" (length is nullptr)
+	struct ArrayExpressionNode : public ExpressionNode {
+		std::string elementType;
+		const ExpressionNode* length;
+		std::vector<const ExpressionNode*> elements;
+
+		inline ArrayExpressionNode(const ScopedSymbolTable* scope_, const std::string& elementType, const ExpressionNode* length, const std::vector<const ExpressionNode*>& elements):
+			ExpressionNode(scope_, Type::ARRAY_EXPRESSION, EvalType(elementType + "[]")),
+			elementType(elementType), length(length), elements(elements) {}
+
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { if(length) f(length); for(const ExpressionNode* element : elements) f(element); }
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+			console << RBRANCH << "    " << (length ? "ArrayAllocation" : "ArrayLiteral") << " -> " << evalType().type() << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			if(length)
+				length->print(console, subIndent, true);
+			for(const ExpressionNode* element : elements)
+				element->print(console, subIndent, element == elements.back());
+		}
+	};
+
+	// array[index]. checked is cleared by the SemanticAnalyzer where it proved the index in bounds.
+	struct IndexExpressionNode : public ExpressionNode {
+		const ExpressionNode* array;
+		const ExpressionNode* index;
+		mutable bool checked;
+
+		inline IndexExpressionNode(const ScopedSymbolTable* scope_, const ExpressionNode* array, const ExpressionNode* index, const bool checked = true):
+			ExpressionNode(scope_, Type::INDEX_EXPRESSION, array->evalType().elementType()),
+			array(array), index(index), checked(checked) {}
+
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { f(array); f(index); }
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+			console << RBRANCH << "    IndexExpression " << (checked ? "" : "unchecked ") << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			array->print(console, subIndent, false);
+			index->print(console, subIndent, true);
+		}
+	};
+
+	// len(array)
+	struct LengthExpressionNode : public ExpressionNode {
+		const ExpressionNode* array;
+
+		inline LengthExpressionNode(const ScopedSymbolTable* scope_, const ExpressionNode* array):
+			ExpressionNode(scope_, Type::LENGTH_EXPRESSION, EvalType("int")),
+			array(array) {}
+
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { f(array); }
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+			console << RBRANCH << "    LengthExpression " << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			array->print(console, subIndent, true);
+		}
+	};
+
+
 	// Statements:
 	struct VariableAssignmentStatement : public StatementNode {
 		std::string varName;
 		const ExpressionNode *expr;
+		Span nameSpan; // source range of the identifier token
 
-		inline VariableAssignmentStatement(ScopedSymbolTable* scope_, const std::string& varName, const ExpressionNode* expr):
+		inline VariableAssignmentStatement(const ScopedSymbolTable* scope_, const std::string& varName, const ExpressionNode* expr, const Span& nameSpan = Span()):
 			StatementNode(scope_, Type::VARIABLE_ASSIGNMENT_STATEMENT),
-			varName(varName), expr(expr) {}
+			varName(varName), expr(expr), nameSpan(nameSpan) {}
+
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { f(expr); }
 
 		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
 			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
 			console << RBRANCH << "    Assignment " << span() << "\n";
 
 			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
-			console << subIndent << VBRANCH << varName << "    Identifier " << "\n";
+			console << subIndent << VBRANCH << varName << "    Identifier " << nameSpan << "\n";
 
 			expr->print(console, subIndent, true);
 		}
 	};
 
+	// varName[index] = expr. checked: see IndexExpressionNode
+	struct ElementAssignmentStatement : public StatementNode {
+		std::string varName;
+		const ExpressionNode* index;
+		const ExpressionNode* expr;
+		mutable bool checked;
+		Span nameSpan; // source range of the identifier token
+
+		inline ElementAssignmentStatement(const ScopedSymbolTable* scope_, const std::string& varName, const ExpressionNode* index, const ExpressionNode* expr, const bool checked = true, const Span& nameSpan = Span()):
+			StatementNode(scope_, Type::ELEMENT_ASSIGNMENT_STATEMENT),
+			varName(varName), index(index), expr(expr), checked(checked), nameSpan(nameSpan) {}
+
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { f(index); f(expr); }
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+			console << RBRANCH << "    ElementAssignment " << (checked ? "" : "unchecked ") << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			console << subIndent << VBRANCH << varName << "    Identifier " << nameSpan << "\n";
+			index->print(console, subIndent, false);
+			expr->print(console, subIndent, true);
+		}
+	};
+
 	struct VariableDeclarationStatement : public StatementNode {
 		std::string typeName;
 		std::string varName;
 		const VariableAssignmentStatement* initialAssignment;
+		Span typeSpan, nameSpan; // source ranges of the typename and identifier tokens
 
-		inline VariableDeclarationStatement(ScopedSymbolTable* scope_, const std::string& typeName, const std::string& varName, const VariableAssignmentStatement* initialAssignment):
+		inline VariableDeclarationStatement(const ScopedSymbolTable* scope_, const std::string& typeName, const std::string& varName, const VariableAssignmentStatement* initialAssignment, const Span& typeSpan = Span(), const Span& nameSpan = Span()):
 			StatementNode(scope_, Type::VARIABLE_DECLARATION_STATEMENT),
-			typeName(typeName), varName(varName), initialAssignment(initialAssignment) {}
-		inline VariableDeclarationStatement(ScopedSymbolTable* scope_, const std::string& typeName, const std::string& varName):
-			VariableDeclarationStatement(scope_, typeName, varName, nullptr) {}
+			typeName(typeName), varName(varName), initialAssignment(initialAssignment), typeSpan(typeSpan), nameSpan(nameSpan) {}
+		inline VariableDeclarationStatement(const ScopedSymbolTable* scope_, const std::string& typeName, const std::string& varName, const Span& typeSpan = Span(), const Span& nameSpan = Span()):
+			VariableDeclarationStatement(scope_, typeName, varName, nullptr, typeSpan, nameSpan) {}
+
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { if(initialAssignment) f(initialAssignment); }
 
 		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
 			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
 			console << RBRANCH << "    Declaration " << span() << "\n";
 
 			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
-			console << subIndent << VBRANCH << typeName << "    Typename " << "\n";
-			console << subIndent << (initialAssignment ? VBRANCH : LBRANCH) << varName << "    Identifier " << "\n";
+			console << subIndent << VBRANCH << typeName << "    Typename " << typeSpan << "\n";
+			console << subIndent << (initialAssignment ? VBRANCH : LBRANCH) << varName << "    Identifier " << nameSpan << "\n";
 
 			if(initialAssignment)
 				initialAssignment->print(console, subIndent, true);
@@ -301,10 +460,12 @@ namespace AST {
 	struct ExpressionStatement : public StatementNode {
 		const ExpressionNode* expr;
 
-		inline ExpressionStatement(ScopedSymbolTable* scope_, const ExpressionNode* expr):
+		inline ExpressionStatement(const ScopedSymbolTable* scope_, const ExpressionNode* expr):
 			StatementNode(scope_, Type::EXPRESSION_STATEMENT),
 			expr(expr) {}
 
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { f(expr); }
+
 		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
 			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
 
@@ -319,10 +480,12 @@ namespace AST {
 	struct StatementList : public StatementNode {
 		std::vector<const StatementNode*> statements;
 
-		inline StatementList(ScopedSymbolTable* scope_, const std::vector<const StatementNode*>& statements):
+		inline StatementList(const ScopedSymbolTable* scope_, const std::vector<const StatementNode*>& statements):
 			StatementNode(scope_, Type::STATEMENT_LIST),
 			statements(statements) {}
 
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { for(const StatementNode* statement : statements) f(statement); }
+
 		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
 			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
 
@@ -338,10 +501,12 @@ namespace AST {
 	struct ReturnStatement : public StatementNode {
 		const ExpressionNode* expr;
 
-		inline ReturnStatement(ScopedSymbolTable* scope_, const ExpressionNode* expr):
+		inline ReturnStatement(const ScopedSymbolTable* scope_, const ExpressionNode* expr):
 			StatementNode(scope_, Type::RETURN_STATEMENT),
 			expr(expr) {}
 
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { f(expr); }
+
 		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
 			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
 
@@ -357,10 +522,12 @@ namespace AST {
 		const ExpressionNode* condition;
 		const StatementNode* body;
 
-		inline IfStatement(ScopedSymbolTable* scope_, const ExpressionNode* condition, const StatementNode* body):
+		inline IfStatement(const ScopedSymbolTable* scope_, const ExpressionNode* condition, const StatementNode* body):
 			StatementNode(scope_, Type::IF_STATEMENT),
 			condition(condition), body(body) {}
 
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { f(condition); f(body); }
+
 		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
 			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
 
@@ -376,10 +543,12 @@ namespace AST {
 		const ExpressionNode* condition;
 		const StatementNode* body;
 
-		inline WhileStatement(ScopedSymbolTable* scope_, const ExpressionNode* condition, const StatementNode* body):
+		inline WhileStatement(const ScopedSymbolTable* scope_, const ExpressionNode* condition, const StatementNode* body):
 			StatementNode(scope_, Type::WHILE_STATEMENT),
 			condition(condition), body(body) {}
 
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { f(condition); f(body); }
+
 		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
 			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
 
@@ -391,21 +560,164 @@ namespace AST {
 		}
 	};
 
+	struct ForStatement : public StatementNode {
+		const StatementNode* init; // may be nullptr
+		const ExpressionNode* condition; // may be nullptr (always true)
+		const VariableAssignmentStatement* step; // may be nullptr
+		const StatementNode* body;
+
+		inline ForStatement(const ScopedSymbolTable* scope_, const StatementNode* init, const ExpressionNode* condition, const VariableAssignmentStatement* step, const StatementNode* body):
+			StatementNode(scope_, Type::FOR_STATEMENT),
+			init(init), condition(condition), step(step), body(body) {}
+
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { if(init) f(init); if(condition) f(condition); if(step) f(step); f(body); }
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+
+			console << RBRANCH << "    ForStatement " << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			if(init) init->print(console, subIndent, false);
+			if(condition) condition->print(console, subIndent, false);
+			if(step) step->print(console, subIndent, false);
+			body->print(console, subIndent, true);
+		}
+	};
+
+	// for loop of the form "for(int i = start; i < bound; i = i + stride)" (or "<=") that does not write i in its body.
+	// The Interpreter runs it with a native int counter instead of evaluating the condition and step expressions.
+	struct CountedForStatement : public StatementNode {
+		const VariableDeclarationStatement* init; // declaration of the induction variable (initial assignment is the start value)
+		const ExpressionNode* bound;
+		bool inclusive; // "<=" instead of "<"
+		int stride; // always > 0
+		bool boundInvariant; // bound is not written in the body, so it is evaluated only once
+		const StatementNode* body;
+
+		inline CountedForStatement(const ScopedSymbolTable* scope_, const VariableDeclarationStatement* init, const ExpressionNode* bound, const bool inclusive, const int stride, const bool boundInvariant, const StatementNode* body):
+			StatementNode(scope_, Type::COUNTED_FOR_STATEMENT),
+			init(init), bound(bound), inclusive(inclusive), stride(stride), boundInvariant(boundInvariant), body(body) {}
+
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { f(init); f(bound); f(body); }
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+
+			console << RBRANCH << "    CountedForStatement " << (inclusive ? "<= " : "< ") << "+" << stride << (boundInvariant ? " invariant-bound " : " ") << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			init->print(console, subIndent, false);
+			bound->print(console, subIndent, false);
+			body->print(console, subIndent, true);
+		}
+	};
+
+	// switch over an int value. The case sections are flattened into one statement list, every label maps to the index
+	// of the first statement it jumps to and execution falls through until a break (like C).
+	// Dense label sets get a jump table indexed by (value - minLabel), sparse ones a sorted vector searched with binary search.
+	struct SwitchStatement : public StatementNode {
+		struct Label { int value; size_t target; };
+
+		const ExpressionNode* value;
+		std::vector<const StatementNode*> statements;
+		std::vector<Label> labels; // sorted by value
+		size_t defaultTarget; // statements.size() if there is no default label
+
+		int minLabel;
+		std::vector<size_t> table; // empty if the labels are too sparse
+
+		inline SwitchStatement(const ScopedSymbolTable* scope_, const ExpressionNode* value, const std::vector<const StatementNode*>& statements, const std::vector<Label>& labels_, const size_t defaultTarget):
+			StatementNode(scope_, Type::SWITCH_STATEMENT),
+			value(value), statements(statements), labels(labels_), defaultTarget(defaultTarget), minLabel(0) {
+			std::sort(labels.begin(), labels.end(), [](const Label& a, const Label& b) { return a.value < b.value; });
+
+			if(labels.empty())
+				return;
+
+			minLabel = labels.front().value;
+			const uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(labels.back().value) - minLabel) + 1;
+
+			if(range > 3 * labels.size()) // at least a third of the table has to be used
+				return;
+
+			table.assign(range, defaultTarget);
+			for(const Label& label : labels)
+				table[static_cast<size_t>(static_cast<int64_t>(label.value) - minLabel)] = label.target;
+		}
+
+		inline bool isDense() const { return !table.empty(); }
+
+		// index of the first statement to execute for the given value (statements.size() if nothing matches)
+		inline size_t target(const int v) const {
+			if(isDense()) {
+				const uint64_t offset = static_cast<uint64_t>(static_cast<int64_t>(v) - minLabel); // values below minLabel wrap around
+				return offset < table.size() ? table[offset] : defaultTarget;
+			}
+
+			const auto it = std::lower_bound(labels.begin(), labels.end(), v, [](const Label& label, const int v) { return label.value < v; });
+			return it != labels.end() && it->value == v ? it->target : defaultTarget;
+		}
+
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { f(value); for(const StatementNode* statement : statements) f(statement); }
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+
+			console << RBRANCH << "    SwitchStatement " << labels.size() << " labels " << (isDense() ? "jump-table " : "binary-search ") << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			value->print(console, subIndent, statements.empty());
+
+			for(size_t i = 0; i < statements.size(); i++) {
+				for(const Label& label : labels)
+					if(label.target == i)
+						console << subIndent << VBRANCH << "case " << label.value << ":\n";
+				if(defaultTarget == i)
+					console << subIndent << VBRANCH << "default:\n";
+
+				statements[i]->print(console, subIndent, i + 1 == statements.size());
+			}
+		}
+	};
+
+	struct BreakStatement : public StatementNode {
+		inline BreakStatement(const ScopedSymbolTable* scope_):
+			StatementNode(scope_, Type::BREAK_STATEMENT) {}
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+			console << "break    BreakStatement " << span() << "\n";
+		}
+	};
+
+	struct ContinueStatement : public StatementNode {
+		inline ContinueStatement(const ScopedSymbolTable* scope_):
+			StatementNode(scope_, Type::CONTINUE_STATEMENT) {}
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+			console << "continue    ContinueStatement " << span() << "\n";
+		}
+	};
+
 	struct FunctionDeclarationStatement : public StatementNode {
-		struct Argument { std::string type, name; };
+		struct Argument { std::string type, name; Span typeSpan, nameSpan; };
 
 		std::string typeName;
 		std::string functionName;
 		std::vector<Argument> args;
-		const StatementNode* body;
+		mutable const StatementNode* body; // mutable: replaced by the Inliner after semantic analysis
+		Span typeSpan, nameSpan, argsSpan; // source ranges of the return type, the name and the parenthesized argument list
 
-		inline FunctionDeclarationStatement(ScopedSymbolTable* scope_, const std::string& typeName, const std::string& functionName, const std::vector<Argument>& args, const StatementNode* body):
+		inline FunctionDeclarationStatement(const ScopedSymbolTable* scope_, const std::string& typeName, const std::string& functionName, const std::vector<Argument>& args, const StatementNode* body,
+			const Span& typeSpan = Span(), const Span& nameSpan = Span(), const Span& argsSpan = Span()):
 			StatementNode(scope_, Type::FUNCTION_DECLARATION_STATEMENT),
-			typeName(typeName), functionName(functionName), args(args), body(body) {}
+			typeName(typeName), functionName(functionName), args(args), body(body), typeSpan(typeSpan), nameSpan(nameSpan), argsSpan(argsSpan) {}
 		
 		inline void printArgs(std::ostream& console, const std::string& indent, const bool isLast) const {
 			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
-			console << RBRANCH << "    ArgumentList " << "\n";
+			console << RBRANCH << "    ArgumentList " << argsSpan << "\n";
 
 			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
 
@@ -415,19 +727,21 @@ namespace AST {
 			}
 
 			for(size_t i = 0; i < args.size(); i++) {
-				console << subIndent << VBRANCH << args[i].type << "    Typename " << "\n";
-				console << subIndent << (i==args.size()-1 ? LBRANCH : VBRANCH) << args[i].name << "    Identifier " << "\n";
+				console << subIndent << VBRANCH << args[i].type << "    Typename " << args[i].typeSpan << "\n";
+				console << subIndent << (i==args.size()-1 ? LBRANCH : VBRANCH) << args[i].name << "    Identifier " << args[i].nameSpan << "\n";
 			}
 		}
 
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { f(body); }
+
 		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
 			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
 
 			console << RBRANCH << "    FunctionDeclarationStatement " << span() << "\n";
 
 			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
-			console << subIndent << VBRANCH << typeName << "    Typename " << "\n";
-			console << subIndent << VBRANCH << functionName << "    Identifier " << "\n";
+			console << subIndent << VBRANCH << typeName << "    Typename " << typeSpan << "\n";
+			console << subIndent << VBRANCH << functionName << "    Identifier " << nameSpan << "\n";
 
 			printArgs(console, subIndent, false);
 			body->print(console, subIndent, true);
@@ -437,8 +751,9 @@ namespace AST {
 	struct FunctionCallExpressionNode : public ExpressionNode {
 		std::string name; // function name
 		std::vector<const ExpressionNode*> args; // function call arguments
+		Span nameSpan; // source range of the function name
 
-		inline FunctionCallExpressionNode(ScopedSymbolTable* scope_, const std::string& name, const std::vector<const ExpressionNode*>& args):
+		inline FunctionCallExpressionNode(const ScopedSymbolTable* scope_, const std::string& name, const std::vector<const ExpressionNode*>& args, const Span& nameSpan = Span()):
 			ExpressionNode(
 				scope_,
 				Type::CALL_EXPRESSION,
@@ -448,16 +763,160 @@ namespace AST {
 					)->typeName
 				)
 			),
-			name(name), args(args) {}
+			name(name), args(args), nameSpan(nameSpan) {}
+
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { for(const ExpressionNode* arg : args) f(arg); }
 
 		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
 			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
 			console << RBRANCH << "    FunctionCall " << span() << "\n";
 
 			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
-			console << subIndent << VBRANCH << name << "    Identifier " << "\n";
+			console << subIndent << VBRANCH << name << "    Identifier " << nameSpan << "\n";
 			for(const ExpressionNode* arg : args)
 				arg->print(console, subIndent, arg == args.back());
 		}
 	};
-};
+
+	// call of a host function from the BuiltinRegistry, resolved (and type checked) by the SemanticAnalyzer
+	struct BuiltinCallExpressionNode : public ExpressionNode {
+		const Builtin* builtin;
+		std::vector<const ExpressionNode*> args;
+		Span nameSpan; // source range of the builtin name
+
+		inline BuiltinCallExpressionNode(const ScopedSymbolTable* scope_, const Builtin* builtin, const std::vector<const ExpressionNode*>& args, const Span& nameSpan = Span()):
+			ExpressionNode(scope_, Type::BUILTIN_CALL_EXPRESSION, EvalType(builtin->returnType)),
+			builtin(builtin), args(args), nameSpan(nameSpan) {}
+
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { for(const ExpressionNode* arg : args) f(arg); }
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+			console << RBRANCH << "    BuiltinCall " << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			console << subIndent << (args.empty() ? LBRANCH : VBRANCH) << builtin->name << "    Identifier " << nameSpan << "\n";
+			for(const ExpressionNode* arg : args)
+				arg->print(console, subIndent, arg == args.back());
+		}
+	};
+
+	// Result of inlining a FunctionCallExpressionNode: the parameters are bound by (renamed) variable declarations
+	// and the callee body is a renamed copy. Both run in a variable scope of their own below the caller's, like a call.
+	struct InlinedCallExpressionNode : public ExpressionNode {
+		const FunctionDeclarationStatement* function; // the inlined function
+		std::string name; // name of the inlined function
+		std::vector<const VariableDeclarationStatement*> bindings; // parameter declarations, initialized with the call arguments
+		const StatementNode* body; // renamed copy of the callee body
+		Span nameSpan; // source range of the function name at the call site
+
+		inline InlinedCallExpressionNode(const ScopedSymbolTable* scope_, const FunctionDeclarationStatement* function, const std::vector<const VariableDeclarationStatement*>& bindings, const StatementNode* body, const Span& nameSpan = Span()):
+			ExpressionNode(scope_, Type::INLINED_CALL_EXPRESSION, EvalType(function->typeName)),
+			function(function), name(function->functionName), bindings(bindings), body(body), nameSpan(nameSpan) {}
+
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { for(const VariableDeclarationStatement* binding : bindings) f(binding); f(body); }
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+			console << RBRANCH << "    InlinedCall " << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			console << subIndent << VBRANCH << name << "    Identifier " << nameSpan << "\n";
+			for(const VariableDeclarationStatement* binding : bindings)
+				binding->print(console, subIndent, false);
+			body->print(console, subIndent, true);
+		}
+	};
+
+
+	// struct name { fields }. Declares a type, executing it does nothing.
+	struct StructDeclarationStatement : public StatementNode {
+		StructLayout layout;
+		Span nameSpan; // source range of the struct name
+
+		inline StructDeclarationStatement(const ScopedSymbolTable* scope_, const StructLayout& layout, const Span& nameSpan = Span()):
+			StatementNode(scope_, Type::STRUCT_DECLARATION_STATEMENT),
+			layout(layout), nameSpan(nameSpan) {}
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+			console << RBRANCH << "    StructDeclaration " << layout.size << " bytes " << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			console << subIndent << (layout.fields.empty() ? LBRANCH : VBRANCH) << layout.name << "    Identifier " << nameSpan << "\n";
+			for(const StructLayout::Field& field : layout.fields)
+				console << subIndent << (&field == &layout.fields.back() ? LBRANCH : VBRANCH) << StructLayout::typeName(field.type) << " " << field.name << " @" << field.offset << "    Field " << "\n";
+		}
+	};
+
+	// new zero initialized record, the value of a struct variable declared without initializer ("Point p;")
+	struct RecordExpressionNode : public ExpressionNode {
+		const StructDeclarationStatement* declaration;
+
+		inline RecordExpressionNode(const ScopedSymbolTable* scope_, const StructDeclarationStatement* declaration):
+			ExpressionNode(scope_, Type::RECORD_EXPRESSION, EvalType(declaration->layout.name)),
+			declaration(declaration) {}
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH) << "<" << declaration->layout.name << ">";
+			console << "    RecordAllocation " << span() << "\n";
+		}
+	};
+
+	// object.field, read at the offset resolved from the declaration
+	struct FieldExpressionNode : public ExpressionNode {
+		const ExpressionNode* object;
+		const StructDeclarationStatement* declaration; // struct type of object
+		std::string fieldName;
+		StructLayout::FieldType fieldType;
+		size_t offset;
+
+		inline FieldExpressionNode(const ScopedSymbolTable* scope_, const ExpressionNode* object, const StructDeclarationStatement* declaration, const std::string& fieldName):
+			ExpressionNode(scope_, Type::FIELD_EXPRESSION, EvalType(StructLayout::typeName(field(declaration, fieldName).type))),
+			object(object), declaration(declaration), fieldName(fieldName), fieldType(field(declaration, fieldName).type), offset(field(declaration, fieldName).offset) {}
+
+		inline static const StructLayout::Field& field(const StructDeclarationStatement* declaration, const std::string& fieldName) {
+			if(const StructLayout::Field* res = declaration->layout.field(fieldName))
+				return *res;
+			throw std::runtime_error("Struct \"" + declaration->layout.name + "\" has no field \"" + fieldName + "\"");
+		}
+
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { f(object); }
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+			console << "." << fieldName << " @" << offset << "    FieldExpression " << " -> " << evalType().type() << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			object->print(console, subIndent, true);
+		}
+	};
+
+	// varName.fieldName = expr
+	struct FieldAssignmentStatement : public StatementNode {
+		std::string varName;
+		const StructDeclarationStatement* declaration; // struct type of the variable
+		std::string fieldName;
+		StructLayout::FieldType fieldType;
+		size_t offset;
+		const ExpressionNode* expr;
+		Span nameSpan; // source range of "varName.fieldName"
+
+		inline FieldAssignmentStatement(const ScopedSymbolTable* scope_, const std::string& varName, const StructDeclarationStatement* declaration, const std::string& fieldName, const ExpressionNode* expr, const Span& nameSpan = Span()):
+			StatementNode(scope_, Type::FIELD_ASSIGNMENT_STATEMENT),
+			varName(varName), declaration(declaration), fieldName(fieldName),
+			fieldType(FieldExpressionNode::field(declaration, fieldName).type), offset(FieldExpressionNode::field(declaration, fieldName).offset),
+			expr(expr), nameSpan(nameSpan) {}
+
+		inline virtual void forEachChild(const std::function<void(const Node*)>& f) const override { f(expr); }
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+			console << RBRANCH << "    FieldAssignment " << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			console << subIndent << VBRANCH << varName << "." << fieldName << " @" << offset << "    Identifier " << nameSpan << "\n";
+			expr->print(console, subIndent, true);
+		}
+	};
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+
+
+// Heap allocations made by the current thread (number of calls to operator new, bytes requested and bytes not yet freed).
+// The counters only move if exactly one translation unit defines BCC_ALLOCATION_COUNTER_IMPLEMENTATION
+// before including this header, which replaces the global operator new / delete and sets installed.
+struct AllocationCounter {
+	inline static thread_local uint64_t count = 0;
+	inline static thread_local uint64_t bytes = 0;
+	inline static thread_local int64_t live = 0; // bytes allocated minus bytes freed by this thread (negative if it frees more than it allocated)
+	inline static bool installed = false;
+};
+
+
+#ifdef BCC_ALLOCATION_COUNTER_IMPLEMENTATION
+namespace AllocationCounterImpl {
+	// every block starts with its size, so operator delete can count the freed bytes without a sized delete
+	constexpr std::size_t header = alignof(std::max_align_t);
+	const bool install = (AllocationCounter::installed = true);
+}
+
+void* operator new(std::size_t size) {
+	char* p = static_cast<char*>(std::malloc(size + AllocationCounterImpl::header));
+	if(!p)
+		throw std::bad_alloc();
+
+	*reinterpret_cast<std::size_t*>(p) = size;
+	AllocationCounter::count++;
+	AllocationCounter::bytes += size;
+	AllocationCounter::live += static_cast<int64_t>(size);
+	return p + AllocationCounterImpl::header;
+}
+
+void operator delete(void* p) noexcept {
+	if(!p)
+		return;
+
+	char* block = static_cast<char*>(p) - AllocationCounterImpl::header;
+	AllocationCounter::live -= static_cast<int64_t>(*reinterpret_cast<std::size_t*>(block));
+	std::free(block);
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, std::size_t) noexcept { operator delete(p); }
+#endif
@@ -0,0 +1,285 @@
+#pragma once
+
+
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define BCC_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+
+// loops over int / float arrays behind the array builtins (see Builtins.hpp).
+// Every kernel has a scalar version. On x86 the widest instruction set the CPU supports (AVX2 or SSE4.1) is picked at
+// runtime, so the binary does not have to be compiled for a specific CPU.
+// int arithmetic wraps around. Vector reductions add floats in a different order than a script loop, so float sums and
+// dot products can differ in the last bits between the levels.
+namespace ArrayKernels {
+	enum class Level : uint8_t {
+		SCALAR, SSE41, AVX2,
+	};
+
+	enum class Op : uint8_t {
+		ADD, MUL, MIN, MAX,
+	};
+
+	inline Level detect() {
+#ifdef BCC_X86_KERNELS
+		__builtin_cpu_init();
+		if(__builtin_cpu_supports("avx2")) return Level::AVX2;
+		if(__builtin_cpu_supports("sse4.1")) return Level::SSE41;
+#endif
+		return Level::SCALAR;
+	}
+
+	// instruction set used by the kernels, detected once. Can be lowered to compare the fallbacks (not while kernels run).
+	inline Level& level() {
+		static Level level = detect();
+		return level;
+	}
+
+	inline const char* levelName(const Level level) {
+		switch(level) {
+			case Level::SCALAR: return "scalar";
+			case Level::SSE41: return "SSE4.1";
+			case Level::AVX2: return "AVX2";
+		}
+		return "<INVALID>";
+	}
+
+
+	namespace Scalar {
+		template<Op op, typename T>
+		inline T apply(const T a, const T b) {
+			if constexpr(op == Op::MIN) return b < a ? b : a;
+			else if constexpr(op == Op::MAX) return b > a ? b : a;
+			else if constexpr(std::is_same_v<T, int>) // wraps like the vector instructions instead of overflowing
+				return static_cast<int>(op == Op::ADD ? static_cast<uint32_t>(a) + static_cast<uint32_t>(b) : static_cast<uint32_t>(a) * static_cast<uint32_t>(b));
+			else
+				return op == Op::ADD ? a + b : a * b;
+		}
+
+		// n > 0 for MIN and MAX
+		template<Op op, typename T>
+		inline T reduce(const T* a, const size_t n) {
+			T acc = op == Op::ADD ? T(0) : a[0];
+			for(size_t i = 0; i < n; i++)
+				acc = apply<op>(acc, a[i]);
+			return acc;
+		}
+
+		template<typename T>
+		inline T dot(const T* a, const T* b, const size_t n) {
+			T acc = T(0);
+			for(size_t i = 0; i < n; i++)
+				acc = apply<Op::ADD>(acc, apply<Op::MUL>(a[i], b[i]));
+			return acc;
+		}
+
+		template<Op op, typename T>
+		inline void zip(const T* a, const T* b, T* out, const size_t n) {
+			for(size_t i = 0; i < n; i++)
+				out[i] = apply<op>(a[i], b[i]);
+		}
+
+		template<Op op, typename T>
+		inline void broadcast(const T* a, const T b, T* out, const size_t n) {
+			for(size_t i = 0; i < n; i++)
+				out[i] = apply<op>(a[i], b);
+		}
+	}
+
+
+#ifdef BCC_X86_KERNELS
+	// the same four kernels for every instruction set, over the Lanes<T> of its namespace. Everything that touches a
+	// vector register carries the target attribute, the rest of the program is compiled for the baseline CPU.
+	#define BCC_ARRAY_KERNELS(TARGET) \
+		template<Op op, typename T> \
+		TARGET inline T reduce(const T* a, const size_t n) { \
+			using L = Lanes<T>; \
+			typename L::Vec acc = L::set1(op == Op::ADD ? T(0) : a[0]); \
+			size_t i = 0; \
+			for(; i + L::width <= n; i += L::width) \
+				acc = L::template apply<op>(acc, L::load(a + i)); \
+			T lanes[L::width]; \
+			L::store(lanes, acc); \
+			T res = lanes[0]; \
+			for(size_t j = 1; j < L::width; j++) \
+				res = Scalar::apply<op>(res, lanes[j]); \
+			for(; i < n; i++) \
+				res = Scalar::apply<op>(res, a[i]); \
+			return res; \
+		} \
+		template<typename T> \
+		TARGET inline T dot(const T* a, const T* b, const size_t n) { \
+			using L = Lanes<T>; \
+			typename L::Vec acc = L::set1(T(0)); \
+			size_t i = 0; \
+			for(; i + L::width <= n; i += L::width) \
+				acc = L::template apply<Op::ADD>(acc, L::template apply<Op::MUL>(L::load(a + i), L::load(b + i))); \
+			T lanes[L::width]; \
+			L::store(lanes, acc); \
+			T res = T(0); \
+			for(size_t j = 0; j < L::width; j++) \
+				res = Scalar::apply<Op::ADD>(res, lanes[j]); \
+			for(; i < n; i++) \
+				res = Scalar::apply<Op::ADD>(res, Scalar::apply<Op::MUL>(a[i], b[i])); \
+			return res; \
+		} \
+		template<Op op, typename T> \
+		TARGET inline void zip(const T* a, const T* b, T* out, const size_t n) { \
+			using L = Lanes<T>; \
+			size_t i = 0; \
+			for(; i + L::width <= n; i += L::width) \
+				L::store(out + i, L::template apply<op>(L::load(a + i), L::load(b + i))); \
+			for(; i < n; i++) \
+				out[i] = Scalar::apply<op>(a[i], b[i]); \
+		} \
+		template<Op op, typename T> \
+		TARGET inline void broadcast(const T* a, const T b, T* out, const size_t n) { \
+			using L = Lanes<T>; \
+			const typename L::Vec v = L::set1(b); \
+			size_t i = 0; \
+			for(; i + L::width <= n; i += L::width) \
+				L::store(out + i, L::template apply<op>(L::load(a + i), v)); \
+			for(; i < n; i++) \
+				out[i] = Scalar::apply<op>(a[i], b); \
+		}
+
+	namespace SSE41 {
+		#define BCC_TARGET __attribute__((target("sse4.1")))
+
+		template<typename T> struct Lanes;
+
+		template<> struct Lanes<float> {
+			using Vec = __m128;
+			static constexpr size_t width = 4;
+			BCC_TARGET inline static Vec load(const float* p) { return _mm_loadu_ps(p); }
+			BCC_TARGET inline static void store(float* p, const Vec v) { _mm_storeu_ps(p, v); }
+			BCC_TARGET inline static Vec set1(const float x) { return _mm_set1_ps(x); }
+			template<Op op>
+			BCC_TARGET inline static Vec apply(const Vec a, const Vec b) {
+				if constexpr(op == Op::ADD) return _mm_add_ps(a, b);
+				else if constexpr(op == Op::MUL) return _mm_mul_ps(a, b);
+				else if constexpr(op == Op::MIN) return _mm_min_ps(a, b);
+				else return _mm_max_ps(a, b);
+			}
+		};
+
+		template<> struct Lanes<int> {
+			using Vec = __m128i;
+			static constexpr size_t width = 4;
+			BCC_TARGET inline static Vec load(const int* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+			BCC_TARGET inline static void store(int* p, const Vec v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+			BCC_TARGET inline static Vec set1(const int x) { return _mm_set1_epi32(x); }
+			template<Op op>
+			BCC_TARGET inline static Vec apply(const Vec a, const Vec b) {
+				if constexpr(op == Op::ADD) return _mm_add_epi32(a, b);
+				else if constexpr(op == Op::MUL) return _mm_mullo_epi32(a, b);
+				else if constexpr(op == Op::MIN) return _mm_min_epi32(a, b);
+				else return _mm_max_epi32(a, b);
+			}
+		};
+
+		BCC_ARRAY_KERNELS(BCC_TARGET)
+		#undef BCC_TARGET
+	}
+
+	namespace AVX2 {
+		#define BCC_TARGET __attribute__((target("avx2")))
+
+		template<typename T> struct Lanes;
+
+		template<> struct Lanes<float> {
+			using Vec = __m256;
+			static constexpr size_t width = 8;
+			BCC_TARGET inline static Vec load(const float* p) { return _mm256_loadu_ps(p); }
+			BCC_TARGET inline static void store(float* p, const Vec v) { _mm256_storeu_ps(p, v); }
+			BCC_TARGET inline static Vec set1(const float x) { return _mm256_set1_ps(x); }
+			template<Op op>
+			BCC_TARGET inline static Vec apply(const Vec a, const Vec b) {
+				if constexpr(op == Op::ADD) return _mm256_add_ps(a, b);
+				else if constexpr(op == Op::MUL) return _mm256_mul_ps(a, b);
+				else if constexpr(op == Op::MIN) return _mm256_min_ps(a, b);
+				else return _mm256_max_ps(a, b);
+			}
+		};
+
+		template<> struct Lanes<int> {
+			using Vec = __m256i;
+			static constexpr size_t width = 8;
+			BCC_TARGET inline static Vec load(const int* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+			BCC_TARGET inline static void store(int* p, const Vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+			BCC_TARGET inline static Vec set1(const int x) { return _mm256_set1_epi32(x); }
+			template<Op op>
+			BCC_TARGET inline static Vec apply(const Vec a, const Vec b) {
+				if constexpr(op == Op::ADD) return _mm256_add_epi32(a, b);
+				else if constexpr(op == Op::MUL) return _mm256_mullo_epi32(a, b);
+				else if constexpr(op == Op::MIN) return _mm256_min_epi32(a, b);
+				else return _mm256_max_epi32(a, b);
+			}
+		};
+
+		BCC_ARRAY_KERNELS(BCC_TARGET)
+		#undef BCC_TARGET
+	}
+
+	#undef BCC_ARRAY_KERNELS
+#endif
+
+
+	// dispatching entry points, T is int or float
+
+	// op(...op(op(a[0], a[1]), a[2])..., a[n-1]), 0 for an empty ADD. MIN and MAX need n > 0.
+	template<Op op, typename T>
+	inline T reduce(const T* a, const size_t n) {
+#ifdef BCC_X86_KERNELS
+		switch(level()) {
+			case Level::AVX2: return AVX2::reduce<op>(a, n);
+			case Level::SSE41: return SSE41::reduce<op>(a, n);
+			case Level::SCALAR: break;
+		}
+#endif
+		return Scalar::reduce<op>(a, n);
+	}
+
+	template<typename T>
+	inline T dot(const T* a, const T* b, const size_t n) {
+#ifdef BCC_X86_KERNELS
+		switch(level()) {
+			case Level::AVX2: return AVX2::dot(a, b, n);
+			case Level::SSE41: return SSE41::dot(a, b, n);
+			case Level::SCALAR: break;
+		}
+#endif
+		return Scalar::dot(a, b, n);
+	}
+
+	// out[i] = op(a[i], b[i]), out may alias a or b
+	template<Op op, typename T>
+	inline void zip(const T* a, const T* b, T* out, const size_t n) {
+#ifdef BCC_X86_KERNELS
+		switch(level()) {
+			case Level::AVX2: return AVX2::zip<op>(a, b, out, n);
+			case Level::SSE41: return SSE41::zip<op>(a, b, out, n);
+			case Level::SCALAR: break;
+		}
+#endif
+		Scalar::zip<op>(a, b, out, n);
+	}
+
+	// out[i] = op(a[i], b), out may alias a
+	template<Op op, typename T>
+	inline void broadcast(const T* a, const T b, T* out, const size_t n) {
+#ifdef BCC_X86_KERNELS
+		switch(level()) {
+			case Level::AVX2: return AVX2::broadcast<op>(a, b, out, n);
+			case Level::SSE41: return SSE41::broadcast<op>(a, b, out, n);
+			case Level::SCALAR: break;
+		}
+#endif
+		Scalar::broadcast<op>(a, b, out, n);
+	}
+}
@@ -0,0 +1,666 @@
+#pragma once
+
+
+#include <unordered_map>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "AST.hpp"
+#include "Value.hpp"
+#include "Builtins.hpp"
+#include "Interpreter.hpp"
+
+
+// evaluates one script function over many rows at once: the arguments come in as columns and every expression node
+// is evaluated for a whole block of rows before moving on to the next node, with plain loops over contiguous arrays
+// the compiler turns into SIMD code. Branches run under selection masks: both sides of an if are evaluated for the
+// rows that take them, a return fills in the result for its active rows and retires them.
+// Supported are functions whose body only uses declarations, assignments, ifs, returns, int / float / bool arithmetic and
+// comparisons on parameters and locals, pure builtins and inlined calls. Anything else (loops, calls, strings, globals)
+// is evaluated row by row through Interpreter::call() instead, see vectorized() and reason().
+// Results are the same as those of Interpreter::call() for every row.
+class BatchEvaluator {
+public:
+	using Function = AST::FunctionDeclarationStatement;
+
+	struct Column {
+		enum class Type : uint8_t {
+			BOOL, INT, FLOAT,
+		} type;
+		std::vector<int> ints; // BOOL (0 / 1) and INT columns
+		std::vector<float> floats; // FLOAT columns
+
+		inline Column(): type(Type::INT) {}
+		inline Column(std::vector<int> values): type(Type::INT), ints(std::move(values)) {}
+		inline Column(std::vector<float> values): type(Type::FLOAT), floats(std::move(values)) {}
+		inline Column(const std::vector<bool>& values): type(Type::BOOL), ints(values.begin(), values.end()) {}
+
+		inline size_t size() const { return type == Type::FLOAT ? floats.size() : ints.size(); }
+
+		inline Value at(const size_t i) const {
+			switch(type) {
+				case Type::BOOL: return Value(ints[i] != 0);
+				case Type::INT: return Value(ints[i]);
+				case Type::FLOAT: return Value(floats[i]);
+			}
+			throw std::runtime_error("BatchEvaluator::Column::at(): invalid column type");
+		}
+	};
+
+	static constexpr size_t blockSize = 1024; // rows per pass over the expression tree, small enough to stay in cache
+
+private:
+	using Type = Column::Type;
+	using Mask = std::vector<uint8_t>;
+
+	struct Frame {
+		Type type; // return type
+		bool convert; // the function itself: returns convert to its return type, inlined calls return the raw value
+		Column* result;
+	};
+
+	Interpreter& interpreter;
+	const Function* function_;
+	Type returnType;
+	std::string reason_; // why the function is not vectorized, empty if it is
+	std::unordered_map<const AST::Node*, Type> inlinedTypes; // result types of the inlined calls
+
+	// state of the block being evaluated:
+	size_t lanes;
+	std::unordered_map<std::string, Column> variables;
+	Mask active; // rows executing the current statement
+	std::vector<Frame> frames;
+
+public:
+	// function has to belong to the program interpreter runs, which evaluates the rows the batch code cannot
+	inline BatchEvaluator(Interpreter& interpreter, const Function* function): interpreter(interpreter), function_(function), returnType(Type::INT), lanes(0) {
+		try {
+			check();
+		} catch(const Unsupported& e) {
+			reason_ = e.what();
+		}
+	}
+
+	inline const Function* function() const { return function_; }
+	inline bool vectorized() const { return reason_.empty(); }
+	inline const std::string& reason() const { return reason_; }
+
+	// one column per parameter, all of the same length. The result has the function's return type.
+	inline Column evaluate(const std::vector<Column>& args) {
+		if(args.size() != function_->args.size())
+			throw std::runtime_error("BatchEvaluator::evaluate(): \"" + function_->functionName + "\" takes " + std::to_string(function_->args.size()) + " arguments, got " + std::to_string(args.size()));
+
+		const size_t rows = args.empty() ? 0 : args[0].size();
+		for(const Column& arg : args)
+			if(arg.size() != rows)
+				throw std::runtime_error("BatchEvaluator::evaluate(): columns differ in length");
+
+		if(!vectorized())
+			return evaluateRows(args, rows);
+
+		for(size_t i = 0; i < args.size(); i++)
+			if(!convertible(args[i].type, function_->args[i].type))
+				return evaluateRows(args, rows); // reports the conversion error of the first row
+
+		Column res;
+		res.type = returnType;
+		for(size_t begin = 0; begin < rows; begin += blockSize)
+			evaluateBlock(args, begin, std::min(rows, begin + blockSize), res);
+		return res;
+	}
+
+private:
+	class Unsupported : public std::runtime_error {
+	public:
+		inline Unsupported(const std::string& what): std::runtime_error(what) {}
+	};
+
+	inline static bool typeOf(const std::string& name, Type& type) {
+		if(name == "bool") type = Type::BOOL;
+		else if(name == "int") type = Type::INT;
+		else if(name == "float") type = Type::FLOAT;
+		else return false;
+		return true;
+	}
+
+	inline static Type typeOf(const std::string& name) {
+		Type type;
+		if(!typeOf(name, type))
+			throw Unsupported("uses type " + name);
+		return type;
+	}
+
+	// same rules as Value::to()
+	inline static bool convertible(const Type from, const std::string& to) {
+		Type type;
+		return typeOf(to, type) && (from != Type::FLOAT || type == Type::FLOAT);
+	}
+
+	inline static bool isComparison(const AST::BinaryExpressionNode::Operation op) {
+		return op >= AST::BinaryExpressionNode::Operation::COMP_EQ;
+	}
+
+	inline Column evaluateRows(const std::vector<Column>& args, const size_t rows) {
+		Column res;
+		if(!typeOf(function_->typeName, res.type))
+			throw std::runtime_error("BatchEvaluator::evaluate(): \"" + function_->functionName + "\" does not return a bool, int or float");
+
+		std::vector<Value> values(args.size());
+		for(size_t row = 0; row < rows; row++) {
+			for(size_t i = 0; i < args.size(); i++)
+				values[i] = args[i].at(row);
+
+			const Value v = interpreter.call(function_, values);
+			if(res.type == Type::FLOAT)
+				res.floats.push_back(v.get<float>());
+			else
+				res.ints.push_back(res.type == Type::BOOL ? v.get<bool>() : v.get<int>());
+		}
+		return res;
+	}
+
+
+	// ############
+	// # CHECKING #
+	// ############
+	// walks the body once with the types the batch code will see and throws Unsupported for anything it cannot run.
+	// Variables may only change their type where every remaining row takes the assignment (outside of ifs).
+
+	struct CheckFrame {
+		bool inlined;
+		bool hasType;
+		Type type;
+	};
+
+	std::unordered_map<std::string, Type> types;
+	std::vector<CheckFrame> checkFrames;
+	size_t depth = 0; // nesting in ifs and inlined calls
+
+	inline void check() {
+		if(!typeOf(function_->typeName, returnType))
+			throw Unsupported("returns " + function_->typeName);
+		for(const Function::Argument& arg : function_->args)
+			types[arg.name] = typeOf(arg.type);
+
+		checkFrames.push_back({ false, true, returnType });
+		checkStatement(function_->body);
+		types.clear();
+		checkFrames.clear();
+	}
+
+	inline void setType(const std::string& name, const Type type) {
+		const auto it = types.find(name);
+		if(it != types.end() && it->second != type && depth > 0)
+			throw Unsupported("\"" + name + "\" changes its type inside a branch");
+		types[name] = type;
+	}
+
+	inline void checkStatement(const AST::StatementNode* node) {
+		switch(node->type()) {
+			case AST::StatementNode::Type::STATEMENT_LIST:
+				for(const AST::StatementNode* statement : dynamic_cast<const AST::StatementList*>(node)->statements)
+					checkStatement(statement);
+				return;
+
+			case AST::StatementNode::Type::EXPRESSION_STATEMENT:
+				checkExpression(dynamic_cast<const AST::ExpressionStatement*>(node)->expr);
+				return;
+
+			case AST::StatementNode::Type::VARIABLE_DECLARATION_STATEMENT: {
+				const AST::VariableDeclarationStatement* n = dynamic_cast<const AST::VariableDeclarationStatement*>(node);
+				setType(n->varName, n->initialAssignment ? checkExpression(n->initialAssignment->expr) : typeOf(n->typeName));
+				return;
+			}
+
+			case AST::StatementNode::Type::VARIABLE_ASSIGNMENT_STATEMENT: {
+				const AST::VariableAssignmentStatement* n = dynamic_cast<const AST::VariableAssignmentStatement*>(node);
+				if(!types.contains(n->varName))
+					throw Unsupported("assigns global variable \"" + n->varName + "\"");
+				setType(n->varName, checkExpression(n->expr));
+				return;
+			}
+
+			case AST::StatementNode::Type::IF_STATEMENT: {
+				const AST::IfStatement* n = dynamic_cast<const AST::IfStatement*>(node);
+				if(checkExpression(n->condition) == Type::FLOAT)
+					throw Unsupported("float condition");
+				depth++;
+				checkStatement(n->body);
+				depth--;
+				return;
+			}
+
+			case AST::StatementNode::Type::RETURN_STATEMENT: {
+				const Type type = checkExpression(dynamic_cast<const AST::ReturnStatement*>(node)->expr);
+				CheckFrame& frame = checkFrames.back();
+				if(!frame.inlined) {
+					if(type == Type::FLOAT && frame.type != Type::FLOAT)
+						throw Unsupported("returns a float from a " + function_->typeName + " function");
+				} else if(!frame.hasType) {
+					frame.hasType = true;
+					frame.type = type;
+				} else if(frame.type != type) {
+					throw Unsupported("inlined function returns different types");
+				}
+				return;
+			}
+
+			case AST::StatementNode::Type::FUNCTION_DECLARATION_STATEMENT:
+				return; // declares nothing at runtime
+
+			case AST::StatementNode::Type::FIELD_ASSIGNMENT_STATEMENT:
+			case AST::StatementNode::Type::STRUCT_DECLARATION_STATEMENT:
+				throw Unsupported("uses structs");
+
+			default:
+				throw Unsupported("contains a loop, switch, break or continue");
+		}
+	}
+
+	inline Type checkExpression(const AST::ExpressionNode* node) {
+		switch(node->type()) {
+			case AST::ExpressionNode::Type::LITERAL_EXPRESSION:
+				switch(dynamic_cast<const AST::LiteralNode*>(node)->type) {
+					case AST::LiteralNode::LiteralType::BOOL: return Type::BOOL;
+					case AST::LiteralNode::LiteralType::INT: return Type::INT;
+					case AST::LiteralNode::LiteralType::FLOAT: return Type::FLOAT;
+					case AST::LiteralNode::LiteralType::STRING: throw Unsupported("uses strings");
+				}
+				break;
+
+			case AST::ExpressionNode::Type::VARIABLE_EXPRESSION: {
+				const std::string& name = dynamic_cast<const AST::IdentifierNode*>(node)->name;
+				const auto it = types.find(name);
+				if(it == types.end())
+					throw Unsupported("reads global variable \"" + name + "\"");
+				return it->second;
+			}
+
+			case AST::ExpressionNode::Type::UNARY_EXPRESSION:
+				if(checkExpression(dynamic_cast<const AST::UnaryExpressionNode*>(node)->a) != Type::INT)
+					throw Unsupported("unary operator on a bool or float"); // the Interpreter only implements them for int
+				return Type::INT;
+
+			case AST::ExpressionNode::Type::BINARY_EXPRESSION: {
+				const AST::BinaryExpressionNode* n = dynamic_cast<const AST::BinaryExpressionNode*>(node);
+				const Type a = checkExpression(n->a);
+				const Type b = checkExpression(n->b);
+				if(isComparison(n->op))
+					return Type::BOOL;
+				return a == Type::FLOAT || b == Type::FLOAT ? Type::FLOAT : Type::INT; // C++ arithmetic conversions, like Value
+			}
+
+			case AST::ExpressionNode::Type::CALL_EXPRESSION:
+				throw Unsupported("calls \"" + dynamic_cast<const AST::FunctionCallExpressionNode*>(node)->name + "\"");
+
+			case AST::ExpressionNode::Type::INLINED_CALL_EXPRESSION: {
+				const AST::InlinedCallExpressionNode* n = dynamic_cast<const AST::InlinedCallExpressionNode*>(node);
+				depth++;
+				for(const AST::VariableDeclarationStatement* binding : n->bindings)
+					checkStatement(binding);
+				checkFrames.push_back({ true, false, Type::INT });
+				checkStatement(n->body);
+				const CheckFrame frame = checkFrames.back();
+				checkFrames.pop_back();
+				depth--;
+
+				if(!frame.hasType)
+					throw Unsupported("inlined call of \"" + n->name + "\" returns nothing");
+				inlinedTypes[node] = frame.type;
+				return frame.type;
+			}
+
+			case AST::ExpressionNode::Type::BUILTIN_CALL_EXPRESSION: {
+				const AST::BuiltinCallExpressionNode* n = dynamic_cast<const AST::BuiltinCallExpressionNode*>(node);
+				if(!n->builtin->pure)
+					throw Unsupported("calls impure builtin \"" + n->builtin->name + "\"");
+				for(size_t i = 0; i < n->args.size(); i++)
+					if(!convertible(checkExpression(n->args[i]), n->builtin->argTypes[i]))
+						throw Unsupported("argument of builtin \"" + n->builtin->name + "\" needs a conversion the Interpreter rejects");
+				return typeOf(n->builtin->returnType);
+			}
+
+			case AST::ExpressionNode::Type::ARRAY_EXPRESSION:
+			case AST::ExpressionNode::Type::INDEX_EXPRESSION:
+			case AST::ExpressionNode::Type::LENGTH_EXPRESSION:
+				throw Unsupported("uses arrays");
+
+			case AST::ExpressionNode::Type::RECORD_EXPRESSION:
+			case AST::ExpressionNode::Type::FIELD_EXPRESSION:
+				throw Unsupported("uses structs");
+
+			case AST::ExpressionNode::Type::CONCAT_EXPRESSION:
+				throw Unsupported("uses strings");
+		}
+
+		throw Unsupported("invalid expression Node type");
+	}
+
+
+	// ##############
+	// # EVALUATION #
+	// ##############
+
+	inline void evaluateBlock(const std::vector<Column>& args, const size_t begin, const size_t end, Column& res) {
+		lanes = end - begin;
+		variables.clear();
+		for(size_t i = 0; i < args.size(); i++)
+			variables[function_->args[i].name] = convert(slice(args[i], begin, end), typeOf(function_->args[i].type));
+
+		Column result;
+		result.type = returnType;
+		resize(result);
+
+		active.assign(lanes, 1);
+		frames.assign(1, { returnType, true, &result });
+		execute(function_->body);
+
+		if(std::find(active.begin(), active.end(), 1) != active.end())
+			throw std::runtime_error("Interpreter::call(): \"" + function_->functionName + "\" ended without returning a value");
+
+		if(res.type == Type::FLOAT)
+			res.floats.insert(res.floats.end(), result.floats.begin(), result.floats.end());
+		else
+			res.ints.insert(res.ints.end(), result.ints.begin(), result.ints.end());
+	}
+
+	inline void resize(Column& c) const {
+		if(c.type == Type::FLOAT)
+			c.floats.assign(lanes, 0.0f);
+		else
+			c.ints.assign(lanes, 0);
+	}
+
+	inline static Column slice(const Column& c, const size_t begin, const size_t end) {
+		Column res;
+		res.type = c.type;
+		if(c.type == Type::FLOAT)
+			res.floats.assign(c.floats.begin() + begin, c.floats.begin() + end);
+		else
+			res.ints.assign(c.ints.begin() + begin, c.ints.begin() + end);
+		return res;
+	}
+
+	inline static std::vector<float> floats(const Column& c) {
+		if(c.type == Type::FLOAT)
+			return c.floats;
+		return std::vector<float>(c.ints.begin(), c.ints.end());
+	}
+
+	// checked by convertible() beforehand
+	inline static Column convert(Column c, const Type type) {
+		if(c.type == type)
+			return c;
+
+		Column res;
+		res.type = type;
+		if(type == Type::FLOAT)
+			res.floats = floats(c);
+		else if(type == Type::BOOL)
+			for(const int v : c.ints)
+				res.ints.push_back(v != 0);
+		else
+			res.ints = std::move(c.ints);
+		return res;
+	}
+
+	// target[i] = value[i] for the rows in mask
+	inline static void select(Column& target, const Column& value, const Mask& mask) {
+		if(target.type == Type::FLOAT)
+			for(size_t i = 0; i < mask.size(); i++)
+				target.floats[i] = mask[i] ? value.floats[i] : target.floats[i];
+		else
+			for(size_t i = 0; i < mask.size(); i++)
+				target.ints[i] = mask[i] ? value.ints[i] : target.ints[i];
+	}
+
+	inline static bool any(const Mask& mask) {
+		return std::find(mask.begin(), mask.end(), 1) != mask.end();
+	}
+
+	inline void execute(const AST::StatementNode* node) {
+		switch(node->type()) {
+			case AST::StatementNode::Type::STATEMENT_LIST:
+				for(const AST::StatementNode* statement : dynamic_cast<const AST::StatementList*>(node)->statements) {
+					if(!any(active))
+						return; // every row returned
+					execute(statement);
+				}
+				return;
+
+			case AST::StatementNode::Type::EXPRESSION_STATEMENT:
+				evaluate(dynamic_cast<const AST::ExpressionStatement*>(node)->expr, active);
+				return;
+
+			case AST::StatementNode::Type::VARIABLE_DECLARATION_STATEMENT: {
+				const AST::VariableDeclarationStatement* n = dynamic_cast<const AST::VariableDeclarationStatement*>(node);
+				Column value;
+				if(n->initialAssignment) {
+					value = evaluate(n->initialAssignment->expr, active);
+				} else {
+					value.type = typeOf(n->typeName);
+					resize(value);
+				}
+				store(n->varName, value);
+				return;
+			}
+
+			case AST::StatementNode::Type::VARIABLE_ASSIGNMENT_STATEMENT: {
+				const AST::VariableAssignmentStatement* n = dynamic_cast<const AST::VariableAssignmentStatement*>(node);
+				store(n->varName, evaluate(n->expr, active));
+				return;
+			}
+
+			case AST::StatementNode::Type::IF_STATEMENT: {
+				const AST::IfStatement* n = dynamic_cast<const AST::IfStatement*>(node);
+				const Column condition = evaluate(n->condition, active);
+
+				const Mask outer = active;
+				for(size_t i = 0; i < lanes; i++)
+					active[i] = outer[i] && condition.ints[i] != 0;
+
+				if(any(active)) {
+					const Mask taken = active;
+					execute(n->body);
+					for(size_t i = 0; i < lanes; i++) // rows that returned in the body stay retired
+						active[i] = outer[i] && (!taken[i] || active[i]);
+				} else {
+					active = outer;
+				}
+				return;
+			}
+
+			case AST::StatementNode::Type::RETURN_STATEMENT: {
+				const Frame& frame = frames.back();
+				Column value = evaluate(dynamic_cast<const AST::ReturnStatement*>(node)->expr, active);
+				select(*frame.result, frame.convert ? convert(std::move(value), frame.type) : value, active);
+				std::fill(active.begin(), active.end(), 0);
+				return;
+			}
+
+			case AST::StatementNode::Type::FUNCTION_DECLARATION_STATEMENT:
+				return;
+
+			default:
+				throw std::runtime_error("BatchEvaluator::execute(): unsupported statement"); // excluded by check()
+		}
+	}
+
+	// a variable outside of ifs takes the whole column (and possibly a new type), inside of them only the active rows
+	inline void store(const std::string& name, const Column& value) {
+		const auto it = variables.find(name);
+		if(it == variables.end() || it->second.type != value.type)
+			variables[name] = value;
+		else
+			select(it->second, value, active);
+	}
+
+	inline Column evaluate(const AST::ExpressionNode* node, const Mask& mask) {
+		switch(node->type()) {
+			case AST::ExpressionNode::Type::LITERAL_EXPRESSION: {
+				Column res;
+				switch(dynamic_cast<const AST::LiteralNode*>(node)->type) {
+					case AST::LiteralNode::LiteralType::BOOL:
+						res.type = Type::BOOL;
+						res.ints.assign(lanes, dynamic_cast<const AST::BoolLiteralNode*>(node)->value);
+						break;
+					case AST::LiteralNode::LiteralType::INT:
+						res.type = Type::INT;
+						res.ints.assign(lanes, dynamic_cast<const AST::IntLiteralNode*>(node)->value);
+						break;
+					case AST::LiteralNode::LiteralType::FLOAT:
+						res.type = Type::FLOAT;
+						res.floats.assign(lanes, dynamic_cast<const AST::FloatLiteralNode*>(node)->value);
+						break;
+					case AST::LiteralNode::LiteralType::STRING:
+						break;
+				}
+				return res;
+			}
+
+			case AST::ExpressionNode::Type::VARIABLE_EXPRESSION:
+				return variables.at(dynamic_cast<const AST::IdentifierNode*>(node)->name);
+
+			case AST::ExpressionNode::Type::UNARY_EXPRESSION: {
+				const AST::UnaryExpressionNode* n = dynamic_cast<const AST::UnaryExpressionNode*>(node);
+				Column res = evaluate(n->a, mask);
+				if(n->op == AST::UnaryExpressionNode::Operation::MINUS)
+					for(int& v : res.ints)
+						v = -v;
+				return res;
+			}
+
+			case AST::ExpressionNode::Type::BINARY_EXPRESSION: {
+				const AST::BinaryExpressionNode* n = dynamic_cast<const AST::BinaryExpressionNode*>(node);
+				const Column a = evaluate(n->a, mask);
+				const Column b = evaluate(n->b, mask);
+
+				Column res;
+				res.type = isComparison(n->op) ? Type::BOOL : (a.type == Type::FLOAT || b.type == Type::FLOAT ? Type::FLOAT : Type::INT);
+
+				if(a.type == Type::FLOAT || b.type == Type::FLOAT) {
+					const std::vector<float> x = floats(a), y = floats(b);
+					if(res.type == Type::FLOAT)
+						arithmetic(n->op, x, y, res.floats);
+					else
+						compare(n->op, x, y, res.ints);
+				} else if(res.type == Type::BOOL) {
+					compare(n->op, a.ints, b.ints, res.ints);
+				} else if(n->op == AST::BinaryExpressionNode::Operation::DIV) {
+					// inactive rows hold arbitrary values, so they divide by 1 instead of trapping. So does INT_MIN / -1,
+					// which overflows: INT_MIN / 1 is the wrapped result
+					std::vector<int> divisors(b.ints);
+					for(size_t i = 0; i < lanes; i++) {
+						if(mask[i] && divisors[i] == 0)
+							throw std::runtime_error("BatchEvaluator: integer division by zero");
+						if(!mask[i] || (divisors[i] == -1 && a.ints[i] == std::numeric_limits<int>::min()))
+							divisors[i] = 1;
+					}
+					arithmetic(n->op, a.ints, divisors, res.ints);
+				} else {
+					arithmetic(n->op, a.ints, b.ints, res.ints);
+				}
+				return res;
+			}
+
+			case AST::ExpressionNode::Type::INLINED_CALL_EXPRESSION: {
+				const AST::InlinedCallExpressionNode* n = dynamic_cast<const AST::InlinedCallExpressionNode*>(node);
+
+				const Mask outer = active;
+				active = mask;
+				for(const AST::VariableDeclarationStatement* binding : n->bindings)
+					execute(binding);
+
+				Column res;
+				res.type = inlinedTypes.at(node);
+				resize(res);
+				frames.push_back({ res.type, false, &res });
+				execute(n->body);
+				frames.pop_back();
+
+				const bool missing = any(active); // the Interpreter would continue with a void value
+				active = outer;
+				if(missing)
+					throw std::runtime_error("BatchEvaluator: inlined call of \"" + n->name + "\" ended without returning a value");
+				return res;
+			}
+
+			case AST::ExpressionNode::Type::BUILTIN_CALL_EXPRESSION: {
+				const AST::BuiltinCallExpressionNode* n = dynamic_cast<const AST::BuiltinCallExpressionNode*>(node);
+
+				std::vector<Column> args;
+				for(const AST::ExpressionNode* arg : n->args)
+					args.push_back(evaluate(arg, mask));
+
+				Column res;
+				res.type = typeOf(n->builtin->returnType);
+				resize(res);
+
+				Value values[Builtin::maxArgs];
+				for(size_t i = 0; i < lanes; i++) {
+					if(!mask[i])
+						continue; // inactive rows may hold arguments the builtin rejects
+					for(size_t j = 0; j < args.size(); j++)
+						values[j] = args[j].at(i);
+
+					const Value v = n->builtin->function(values);
+					if(res.type == Type::FLOAT)
+						res.floats[i] = v.get<float>();
+					else
+						res.ints[i] = res.type == Type::BOOL ? v.get<bool>() : v.get<int>();
+				}
+				return res;
+			}
+
+			case AST::ExpressionNode::Type::CALL_EXPRESSION:
+				break; // excluded by check()
+		}
+
+		throw std::runtime_error("BatchEvaluator::evaluate(): unsupported expression");
+	}
+
+	// the kernels: one operation over a whole block, no branches in the loop bodies
+	template<typename T>
+	inline static void arithmetic(const AST::BinaryExpressionNode::Operation op, const std::vector<T>& a, const std::vector<T>& b, std::vector<T>& out) {
+		const size_t n = a.size();
+		out.resize(n);
+		const T* x = a.data();
+		const T* y = b.data();
+		T* o = out.data();
+
+		switch(op) {
+			case AST::BinaryExpressionNode::Operation::PLUS: for(size_t i = 0; i < n; i++) o[i] = x[i] + y[i]; return;
+			case AST::BinaryExpressionNode::Operation::MINUS: for(size_t i = 0; i < n; i++) o[i] = x[i] - y[i]; return;
+			case AST::BinaryExpressionNode::Operation::MUL: for(size_t i = 0; i < n; i++) o[i] = x[i] * y[i]; return;
+			case AST::BinaryExpressionNode::Operation::DIV:
+				for(size_t i = 0; i < n; i++) o[i] = x[i] / y[i]; // integer divisors are made safe by evaluate()
+				return;
+			default:
+				throw std::runtime_error("BatchEvaluator::arithmetic(): not an arithmetic operation");
+		}
+	}
+
+	template<typename T>
+	inline static void compare(const AST::BinaryExpressionNode::Operation op, const std::vector<T>& a, const std::vector<T>& b, std::vector<int>& out) {
+		const size_t n = a.size();
+		out.resize(n);
+		const T* x = a.data();
+		const T* y = b.data();
+		int* o = out.data();
+
+		switch(op) {
+			case AST::BinaryExpressionNode::Operation::COMP_EQ: for(size_t i = 0; i < n; i++) o[i] = x[i] == y[i]; return;
+			case AST::BinaryExpressionNode::Operation::COMP_NE: for(size_t i = 0; i < n; i++) o[i] = x[i] != y[i]; return;
+			case AST::BinaryExpressionNode::Operation::COMP_GT: for(size_t i = 0; i < n; i++) o[i] = x[i] > y[i]; return;
+			case AST::BinaryExpressionNode::Operation::COMP_LT: for(size_t i = 0; i < n; i++) o[i] = x[i] < y[i]; return;
+			case AST::BinaryExpressionNode::Operation::COMP_GE: for(size_t i = 0; i < n; i++) o[i] = x[i] >= y[i]; return;
+			case AST::BinaryExpressionNode::Operation::COMP_LE: for(size_t i = 0; i < n; i++) o[i] = x[i] <= y[i]; return;
+			default:
+				throw std::runtime_error("BatchEvaluator::compare(): not a comparison");
+		}
+	}
+};
@@ -0,0 +1,223 @@
+#pragma once
+
+
+#include <unordered_map>
+#include <type_traits>
+#include <stdexcept>
+#include <iostream>
+#include <utility>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <tuple>
+#include <cmath>
+
+#include "ScopedSymbolTable.hpp"
+#include "ArrayKernels.hpp"
+#include "Value.hpp"
+
+
+// native C++ function callable from scripts.
+// The Interpreter evaluates the arguments into a Value array and calls `function` directly, no script scope is created.
+struct Builtin {
+	using Function = Value (*)(const Value* args);
+	static constexpr size_t maxArgs = 8;
+
+	std::string name;
+	std::string returnType;
+	std::vector<std::string> argTypes;
+	Function function;
+	bool pure; // no side effects, the result only depends on the arguments (see ParallelAnalysis)
+};
+
+template<typename T> struct BuiltinTypeName;
+template<> struct BuiltinTypeName<void> { static constexpr const char* value = "void"; };
+template<> struct BuiltinTypeName<bool> { static constexpr const char* value = "bool"; };
+template<> struct BuiltinTypeName<int> { static constexpr const char* value = "int"; };
+template<> struct BuiltinTypeName<float> { static constexpr const char* value = "float"; };
+template<> struct BuiltinTypeName<std::string> { static constexpr const char* value = "string"; };
+template<> struct BuiltinTypeName<ArrayRef<bool>> { static constexpr const char* value = "bool[]"; };
+template<> struct BuiltinTypeName<ArrayRef<int>> { static constexpr const char* value = "int[]"; };
+template<> struct BuiltinTypeName<ArrayRef<float>> { static constexpr const char* value = "float[]"; };
+
+
+// host side registry of builtins. Functions are registered with their C++ signature:
+//   registry.add<&mySqrt>("sqrt");
+// which generates a trampoline that converts the argument Values to the parameter types and calls mySqrt directly.
+class BuiltinRegistry {
+private:
+	std::unordered_map<std::string, const Builtin*> builtins;
+
+public:
+	inline BuiltinRegistry() {}
+	BuiltinRegistry(const BuiltinRegistry&) = delete;
+
+	inline ~BuiltinRegistry() {
+		for(const auto& [name, builtin] : builtins)
+			delete builtin;
+	}
+
+	template<auto F>
+	inline void add(const std::string& name, const bool pure = true) {
+		addImpl<F>(name, pure, F);
+	}
+
+	inline const Builtin* lookup(const std::string& name) const {
+		const auto it = builtins.find(name);
+		return it != builtins.end() ? it->second : nullptr;
+	}
+
+	inline const std::unordered_map<std::string, const Builtin*>& entries() const { return builtins; }
+
+	// makes all builtins visible to the SemanticAnalyzer (usually called on the global scope)
+	inline void declare(ScopedSymbolTable* scope) const {
+		for(const auto& [name, builtin] : builtins)
+			scope->declare(new Symbol(Symbol::Category::BUILTIN, name, builtin));
+	}
+
+	inline void addStandardLibrary();
+
+private:
+	template<auto F, typename R, typename... Args>
+	inline void addImpl(const std::string& name, const bool pure, R (*)(Args...)) {
+		static_assert(sizeof...(Args) <= Builtin::maxArgs, "BuiltinRegistry::add(): too many parameters");
+
+		if(builtins.contains(name))
+			throw std::runtime_error("BuiltinRegistry::add(): Tried to redeclare builtin \"" + name + "\"");
+
+		builtins[name] = new Builtin{ name, BuiltinTypeName<R>::value, { BuiltinTypeName<std::remove_cvref_t<Args>>::value... }, &call<F, R, Args...>, pure };
+	}
+
+	template<auto F, typename R, typename... Args>
+	inline static Value call(const Value* args) {
+		return callImpl<F, R, Args...>(args, std::index_sequence_for<Args...>());
+	}
+
+	// parameter of type T converted from a Value. Strings are passed as a reference to the shared characters, only
+	// converted values are copied.
+	template<typename T>
+	struct Argument {
+		T value;
+		inline Argument(const Value& v): value(v.to<T>()) {}
+		inline const T& get() const { return value; }
+	};
+
+	template<auto F, typename R, typename... Args, size_t... I>
+	inline static Value callImpl(const Value* args, std::index_sequence<I...>) {
+		const std::tuple<Argument<std::remove_cvref_t<Args>>...> converted(args[I]...);
+		if constexpr(std::is_void_v<R>) {
+			F(std::get<I>(converted).get()...);
+			return Value::Void();
+		} else {
+			return Value(F(std::get<I>(converted).get()...));
+		}
+	}
+};
+
+template<>
+struct BuiltinRegistry::Argument<std::string> {
+	std::string converted;
+	const std::string* value;
+	inline Argument(const Value& v): value(v.is<std::string>() ? &v.get<std::string>() : &(converted = v.to<std::string>())) {}
+	inline const std::string& get() const { return *value; }
+};
+
+
+namespace StandardLibrary {
+	inline float sqrt(const float x) { return std::sqrt(x); }
+	inline float pow(const float x, const float y) { return std::pow(x, y); }
+	inline float sin(const float x) { return std::sin(x); }
+	inline float cos(const float x) { return std::cos(x); }
+	inline int abs(const int x) { return x < 0 ? -x : x; }
+	inline int min(const int a, const int b) { return a < b ? a : b; }
+	inline int max(const int a, const int b) { return a > b ? a : b; }
+	inline int floor(const float x) { return static_cast<int>(std::floor(x)); }
+	inline int ceil(const float x) { return static_cast<int>(std::ceil(x)); }
+
+	inline int len(const std::string& s) { return static_cast<int>(s.size()); }
+	inline std::string substr(const std::string& s, const int start, const int count) {
+		if(start < 0 || static_cast<size_t>(start) > s.size() || count < 0)
+			throw std::runtime_error("substr(): index out of range");
+		return s.substr(static_cast<size_t>(start), static_cast<size_t>(count));
+	}
+
+	inline void print(const std::string& s) { std::cout << s << "\n"; }
+
+	// array kernels, registered once per element type ("isum" / "fsum", ...) as builtins are not overloaded.
+	// Elementwise operations return a new array and leave their arguments unchanged.
+	template<typename T>
+	inline std::string kernelName(const char* name) { return (std::is_same_v<T, int> ? "i" : "f") + std::string(name); }
+
+	template<typename T>
+	inline T sum(const ArrayRef<T>& a) { return ArrayKernels::reduce<ArrayKernels::Op::ADD>(a->data.get(), a->size); }
+
+	template<typename T>
+	inline T minimum(const ArrayRef<T>& a) {
+		if(a->size == 0)
+			throw std::runtime_error(kernelName<T>("min") + "(): empty array");
+		return ArrayKernels::reduce<ArrayKernels::Op::MIN>(a->data.get(), a->size);
+	}
+
+	template<typename T>
+	inline T maximum(const ArrayRef<T>& a) {
+		if(a->size == 0)
+			throw std::runtime_error(kernelName<T>("max") + "(): empty array");
+		return ArrayKernels::reduce<ArrayKernels::Op::MAX>(a->data.get(), a->size);
+	}
+
+	template<typename T>
+	inline T dot(const ArrayRef<T>& a, const ArrayRef<T>& b) {
+		if(a->size != b->size)
+			throw std::runtime_error(kernelName<T>("dot") + "(): arrays of length " + std::to_string(a->size) + " and " + std::to_string(b->size));
+		return ArrayKernels::dot(a->data.get(), b->data.get(), a->size);
+	}
+
+	template<ArrayKernels::Op op, typename T>
+	inline ArrayRef<T> elementwise(const ArrayRef<T>& a, const ArrayRef<T>& b) {
+		if(a->size != b->size)
+			throw std::runtime_error(kernelName<T>(op == ArrayKernels::Op::ADD ? "add" : "mul") + "(): arrays of length " + std::to_string(a->size) + " and " + std::to_string(b->size));
+		const ArrayRef<T> res = std::make_shared<Array<T>>(a->size);
+		ArrayKernels::zip<op>(a->data.get(), b->data.get(), res->data.get(), a->size);
+		return res;
+	}
+
+	template<ArrayKernels::Op op, typename T>
+	inline ArrayRef<T> broadcast(const ArrayRef<T>& a, const T b) {
+		const ArrayRef<T> res = std::make_shared<Array<T>>(a->size);
+		ArrayKernels::broadcast<op>(a->data.get(), b, res->data.get(), a->size);
+		return res;
+	}
+}
+
+inline void BuiltinRegistry::addStandardLibrary() {
+	add<&StandardLibrary::sqrt>("sqrt");
+	add<&StandardLibrary::pow>("pow");
+	add<&StandardLibrary::sin>("sin");
+	add<&StandardLibrary::cos>("cos");
+	add<&StandardLibrary::abs>("abs");
+	add<&StandardLibrary::min>("min");
+	add<&StandardLibrary::max>("max");
+	add<&StandardLibrary::floor>("floor");
+	add<&StandardLibrary::ceil>("ceil");
+	add<&StandardLibrary::len>("len");
+	add<&StandardLibrary::substr>("substr");
+	add<&StandardLibrary::print>("print", false);
+
+	using ArrayKernels::Op;
+	add<&StandardLibrary::sum<int>>("isum");
+	add<&StandardLibrary::sum<float>>("fsum");
+	add<&StandardLibrary::minimum<int>>("imin");
+	add<&StandardLibrary::minimum<float>>("fmin");
+	add<&StandardLibrary::maximum<int>>("imax");
+	add<&StandardLibrary::maximum<float>>("fmax");
+	add<&StandardLibrary::dot<int>>("idot");
+	add<&StandardLibrary::dot<float>>("fdot");
+	add<&StandardLibrary::elementwise<Op::ADD, int>>("iadd");
+	add<&StandardLibrary::elementwise<Op::ADD, float>>("fadd");
+	add<&StandardLibrary::elementwise<Op::MUL, int>>("imul");
+	add<&StandardLibrary::elementwise<Op::MUL, float>>("fmul");
+	add<&StandardLibrary::broadcast<Op::MUL, int>>("iscale"); // a[i] * s
+	add<&StandardLibrary::broadcast<Op::MUL, float>>("fscale");
+	add<&StandardLibrary::broadcast<Op::ADD, int>>("ioffset"); // a[i] + s
+	add<&StandardLibrary::broadcast<Op::ADD, float>>("foffset");
+}
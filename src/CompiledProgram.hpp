@@ -0,0 +1,192 @@
+#pragma once
+
+
+#include <unordered_set>
+#include <functional>
+#include <stdexcept>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "Lexer.hpp"
+#include "Parser.hpp"
+#include "SemanticAnalyzer.hpp"
+#include "ScopedSymbolTable.hpp"
+#include "Builtins.hpp"
+#include "Inliner.hpp"
+#include "ObjectPool.hpp"
+#include "AST.hpp"
+
+
+// immutable result of lexing, parsing, analyzing and inlining a script.
+// Nothing reachable from it is written while executing, so a single CompiledProgram can be run concurrently
+// by any number of threads, each with its own Interpreter (the per-thread execution context).
+// The program owns its nodes, symbol tables and symbols (see ObjectPool) and frees them when it is destroyed.
+// Builtins referenced by the program are owned by the BuiltinRegistry, which has to outlive it.
+// ProgramCache stores compiled programs on disk and loads them without running the front end.
+class CompiledProgram {
+private:
+	friend class ProgramImage;
+
+	ObjectPool pool;
+	std::string source_;
+	ScopedSymbolTable* globalScope; // root of the symbol tables the AST refers to
+	const AST::Node* ast_;
+	uint32_t nodeCount_; // the nodes of ast_ are numbered 0 .. nodeCount_-1
+	InlineReport inlineReport_;
+
+	inline CompiledProgram(const std::string& source): source_(source), globalScope(nullptr), ast_(nullptr), nodeCount_(0) {}
+
+public:
+	CompiledProgram(const CompiledProgram&) = delete;
+
+	inline static std::shared_ptr<const CompiledProgram> compile(const std::string& source, const BuiltinRegistry* builtins = nullptr) {
+		std::shared_ptr<CompiledProgram> program(new CompiledProgram(source.ends_with('\n') ? source : source + "\n")); // the lexer needs a character after the last token
+
+		ObjectPool::Activation activation(program->pool);
+
+		ScopedSymbolTable* scope = program->globalScope = new ScopedSymbolTable("Global Scope");
+		scope->declare(new Symbol(Symbol::Category::TYPE, "void", "__VOID__"));
+		scope->declare(new Symbol(Symbol::Category::TYPE, "bool", "__BOOL__"));
+		scope->declare(new Symbol(Symbol::Category::TYPE, "int", "__INT__"));
+		scope->declare(new Symbol(Symbol::Category::TYPE, "float", "__FLOAT__"));
+		scope->declare(new Symbol(Symbol::Category::TYPE, "string", "__STRING__"));
+		scope->declare(new Symbol(Symbol::Category::TYPE, "bool[]", "__BOOL_ARRAY__"));
+		scope->declare(new Symbol(Symbol::Category::TYPE, "int[]", "__INT_ARRAY__"));
+		scope->declare(new Symbol(Symbol::Category::TYPE, "float[]", "__FLOAT_ARRAY__"));
+		if(builtins)
+			builtins->declare(scope);
+
+		ImmediateLexer lexer(program->source_);
+		Parser parser(lexer);
+
+		ObjectPool parseTree; // only needed until the AST is built
+		const ParseTree::Program* tree = nullptr;
+		{
+			ObjectPool::Activation parsing(parseTree);
+			tree = parser.program();
+		}
+
+		Inliner inliner;
+		program->ast_ = inliner.run(SemanticAnalyzer::visit(tree, scope));
+		program->nodeCount_ = AST::Node::number(program->ast_);
+		program->inlineReport_ = inliner.report();
+
+		return program;
+	}
+
+	inline const std::string& source() const { return source_; }
+	inline const AST::Node* ast() const { return ast_; }
+	inline uint32_t nodeCount() const { return nodeCount_; } // size of tables indexed by AST::Node::id()
+	inline const ScopedSymbolTable& symbols() const { return *globalScope; }
+	inline const InlineReport& inlineReport() const { return inlineReport_; }
+
+	// estimated heap bytes held by the program (source, AST nodes and symbol tables), used to bound caches
+	inline size_t footprint() const {
+		std::unordered_set<const AST::Node*> nodes;
+		std::unordered_set<const ScopedSymbolTable*> scopes;
+		size_t res = sizeof(CompiledProgram) + source_.capacity();
+
+		const std::function<void(const AST::Node*)> visit = [&](const AST::Node* node) {
+			if(!nodes.insert(node).second)
+				return;
+			res += nodeFootprint(node);
+			for(const ScopedSymbolTable* scope = &node->getScope(); scope && scopes.insert(scope).second; scope = scope->parent) {
+				res += sizeof(ScopedSymbolTable) + scope->name().capacity();
+				for(const auto& [name, symbol] : scope->entries())
+					res += sizeof(Symbol) + 2 * name.capacity() + 32; // symbol, its name, the key and the hash node
+			}
+			node->forEachChild(visit);
+		};
+		visit(ast_);
+
+		return res;
+	}
+
+private:
+	inline static size_t nodeFootprint(const AST::Node* node) {
+		if(node->baseType() == AST::Node::BaseType::EXPRESSION) {
+			const AST::ExpressionNode* expr = dynamic_cast<const AST::ExpressionNode*>(node);
+			const size_t base = expr->evalType().type().capacity();
+
+			switch(expr->type()) {
+				case AST::ExpressionNode::Type::LITERAL_EXPRESSION:
+					if(const AST::StringLiteralNode* n = dynamic_cast<const AST::StringLiteralNode*>(node))
+						return base + sizeof(*n) + n->value.capacity() + sizeof(std::string) + n->shared->capacity(); // and the shared copy
+					return base + sizeof(AST::FloatLiteralNode);
+				case AST::ExpressionNode::Type::VARIABLE_EXPRESSION:
+					return base + sizeof(AST::IdentifierNode) + dynamic_cast<const AST::IdentifierNode*>(node)->name.capacity();
+				case AST::ExpressionNode::Type::UNARY_EXPRESSION:
+					return base + sizeof(AST::UnaryExpressionNode);
+				case AST::ExpressionNode::Type::BINARY_EXPRESSION:
+					return base + sizeof(AST::BinaryExpressionNode);
+				case AST::ExpressionNode::Type::CALL_EXPRESSION: {
+					const AST::FunctionCallExpressionNode* n = dynamic_cast<const AST::FunctionCallExpressionNode*>(node);
+					return base + sizeof(*n) + n->name.capacity() + n->args.capacity() * sizeof(void*);
+				}
+				case AST::ExpressionNode::Type::INLINED_CALL_EXPRESSION: {
+					const AST::InlinedCallExpressionNode* n = dynamic_cast<const AST::InlinedCallExpressionNode*>(node);
+					return base + sizeof(*n) + n->name.capacity() + n->bindings.capacity() * sizeof(void*);
+				}
+				case AST::ExpressionNode::Type::BUILTIN_CALL_EXPRESSION:
+					return base + sizeof(AST::BuiltinCallExpressionNode) + dynamic_cast<const AST::BuiltinCallExpressionNode*>(node)->args.capacity() * sizeof(void*);
+				case AST::ExpressionNode::Type::ARRAY_EXPRESSION: {
+					const AST::ArrayExpressionNode* n = dynamic_cast<const AST::ArrayExpressionNode*>(node);
+					return base + sizeof(*n) + n->elementType.capacity() + n->elements.capacity() * sizeof(void*);
+				}
+				case AST::ExpressionNode::Type::INDEX_EXPRESSION:
+					return base + sizeof(AST::IndexExpressionNode);
+				case AST::ExpressionNode::Type::LENGTH_EXPRESSION:
+					return base + sizeof(AST::LengthExpressionNode);
+				case AST::ExpressionNode::Type::RECORD_EXPRESSION:
+					return base + sizeof(AST::RecordExpressionNode);
+				case AST::ExpressionNode::Type::FIELD_EXPRESSION:
+					return base + sizeof(AST::FieldExpressionNode) + dynamic_cast<const AST::FieldExpressionNode*>(node)->fieldName.capacity();
+				case AST::ExpressionNode::Type::CONCAT_EXPRESSION:
+					return base + sizeof(AST::ConcatExpressionNode) + dynamic_cast<const AST::ConcatExpressionNode*>(node)->parts.capacity() * sizeof(void*);
+			}
+			return base + sizeof(AST::ExpressionNode);
+		}
+
+		switch(dynamic_cast<const AST::StatementNode*>(node)->type()) {
+			case AST::StatementNode::Type::STATEMENT_LIST:
+				return sizeof(AST::StatementList) + dynamic_cast<const AST::StatementList*>(node)->statements.capacity() * sizeof(void*);
+			case AST::StatementNode::Type::SWITCH_STATEMENT: {
+				const AST::SwitchStatement* n = dynamic_cast<const AST::SwitchStatement*>(node);
+				return sizeof(*n) + n->statements.capacity() * sizeof(void*) + n->labels.capacity() * sizeof(AST::SwitchStatement::Label) + n->table.capacity() * sizeof(size_t);
+			}
+			case AST::StatementNode::Type::FUNCTION_DECLARATION_STATEMENT: {
+				const AST::FunctionDeclarationStatement* n = dynamic_cast<const AST::FunctionDeclarationStatement*>(node);
+				size_t res = sizeof(*n) + n->typeName.capacity() + n->functionName.capacity() + n->args.capacity() * sizeof(AST::FunctionDeclarationStatement::Argument);
+				for(const AST::FunctionDeclarationStatement::Argument& arg : n->args)
+					res += arg.type.capacity() + arg.name.capacity();
+				return res;
+			}
+			case AST::StatementNode::Type::VARIABLE_DECLARATION_STATEMENT: {
+				const AST::VariableDeclarationStatement* n = dynamic_cast<const AST::VariableDeclarationStatement*>(node);
+				return sizeof(*n) + n->typeName.capacity() + n->varName.capacity();
+			}
+			case AST::StatementNode::Type::VARIABLE_ASSIGNMENT_STATEMENT: {
+				const AST::VariableAssignmentStatement* n = dynamic_cast<const AST::VariableAssignmentStatement*>(node);
+				return sizeof(*n) + n->varName.capacity();
+			}
+			case AST::StatementNode::Type::ELEMENT_ASSIGNMENT_STATEMENT: {
+				const AST::ElementAssignmentStatement* n = dynamic_cast<const AST::ElementAssignmentStatement*>(node);
+				return sizeof(*n) + n->varName.capacity();
+			}
+			case AST::StatementNode::Type::FIELD_ASSIGNMENT_STATEMENT: {
+				const AST::FieldAssignmentStatement* n = dynamic_cast<const AST::FieldAssignmentStatement*>(node);
+				return sizeof(*n) + n->varName.capacity() + n->fieldName.capacity();
+			}
+			case AST::StatementNode::Type::STRUCT_DECLARATION_STATEMENT: {
+				const AST::StructDeclarationStatement* n = dynamic_cast<const AST::StructDeclarationStatement*>(node);
+				size_t res = sizeof(*n) + n->layout.name.capacity() + n->layout.fields.capacity() * sizeof(StructLayout::Field);
+				for(const StructLayout::Field& field : n->layout.fields)
+					res += field.name.capacity();
+				return res;
+			}
+			default:
+				return sizeof(AST::CountedForStatement); // the largest of the remaining statements
+		}
+	}
+};
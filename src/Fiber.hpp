@@ -0,0 +1,125 @@
+#pragma once
+
+
+#include <functional>
+#include <stdexcept>
+#include <exception>
+#include <cstdint>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+// stackful coroutine: entry runs on its own stack and can suspend itself with yield() at any call depth,
+// which lets the recursive Interpreter pause in the middle of a script (see Scheduler).
+// A fiber must always be resumed from the same OS thread: code running on it may have cached thread_local addresses.
+// The stack ends in an inaccessible guard page, so an overflow faults instead of overwriting other memory
+// (Windows fiber stacks have one anyway). Pages are only committed once they are touched.
+class Fiber {
+private:
+	std::function<void()> entry;
+	std::exception_ptr error;
+	bool finished_;
+
+#ifdef _WIN32
+	void* fiber;
+	void* caller;
+#else
+	char* stack; // guard page first, the stack grows down towards it
+	size_t mapped;
+	ucontext_t context;
+	ucontext_t caller;
+#endif
+
+public:
+	inline Fiber(std::function<void()> entry_, const size_t stackSize = 512 * 1024): entry(std::move(entry_)), finished_(false) {
+#ifdef _WIN32
+		caller = nullptr;
+		fiber = CreateFiberEx(0, stackSize, 0, &Fiber::start, this); // reserves stackSize, commits on demand
+		if(!fiber)
+			throw std::runtime_error("Fiber::Fiber(): CreateFiber() failed");
+#else
+		const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		const size_t usable = (stackSize + page - 1) / page * page;
+		mapped = usable + page;
+		void* memory = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if(memory == MAP_FAILED)
+			throw std::runtime_error("Fiber::Fiber(): mmap() failed");
+		stack = static_cast<char*>(memory);
+		if(mprotect(stack, page, PROT_NONE) != 0 || getcontext(&context) != 0) {
+			munmap(stack, mapped);
+			throw std::runtime_error("Fiber::Fiber(): could not set up the stack");
+		}
+		context.uc_stack.ss_sp = stack + page;
+		context.uc_stack.ss_size = usable;
+		context.uc_link = &caller; // returning from start() resumes the caller
+		const uint64_t self = reinterpret_cast<uintptr_t>(this); // makecontext only passes ints
+		makecontext(&context, reinterpret_cast<void (*)()>(&Fiber::start), 2, static_cast<unsigned>(self >> 32), static_cast<unsigned>(self & 0xFFFFFFFF));
+#endif
+	}
+
+	Fiber(const Fiber&) = delete;
+
+	inline ~Fiber() {
+#ifdef _WIN32
+		DeleteFiber(fiber);
+#else
+		munmap(stack, mapped);
+#endif
+	}
+
+	inline bool finished() const { return finished_; }
+
+	// runs the fiber until it yields or returns, rethrows an exception that escaped entry
+	inline void resume() {
+		if(finished_)
+			throw std::runtime_error("Fiber::resume(): fiber has already finished");
+
+#ifdef _WIN32
+		static thread_local void* threadFiber = ConvertThreadToFiber(nullptr);
+		caller = threadFiber;
+		SwitchToFiber(fiber);
+#else
+		swapcontext(&caller, &context);
+#endif
+
+		if(error)
+			std::rethrow_exception(std::exchange(error, nullptr));
+	}
+
+	// suspends the fiber, called on the fiber itself
+	inline void yield() {
+#ifdef _WIN32
+		SwitchToFiber(caller);
+#else
+		swapcontext(&context, &caller);
+#endif
+	}
+
+private:
+	inline void run() {
+		try {
+			entry();
+		} catch(...) {
+			error = std::current_exception();
+		}
+		finished_ = true;
+	}
+
+#ifdef _WIN32
+	inline static void CALLBACK start(void* self) {
+		static_cast<Fiber*>(self)->run();
+		SwitchToFiber(static_cast<Fiber*>(self)->caller); // a Windows fiber must never return
+	}
+#else
+	inline static void start(const unsigned high, const unsigned low) {
+		reinterpret_cast<Fiber*>(static_cast<uintptr_t>((static_cast<uint64_t>(high) << 32) | low))->run();
+	}
+#endif
+};
@@ -0,0 +1,725 @@
+#pragma once
+
+
+#include <unordered_map>
+#include <unordered_set>
+#include <stdexcept>
+#include <ostream>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ScopedSymbolTable.hpp"
+#include "AST.hpp"
+
+
+struct InlineReport {
+	struct Entry {
+		std::string caller; // function containing the call site ("<global>" for top level code)
+		std::string callee;
+		size_t calleeSize; // AST node count of the callee body
+		Span callSite;
+		std::string reason; // why the call was not inlined (empty for inlined calls)
+	};
+
+	std::vector<Entry> inlined;
+	std::vector<Entry> skipped;
+
+	inline void print(std::ostream& console) const {
+		console << "Inline Report: " << inlined.size() << " inlined, " << skipped.size() << " skipped\n";
+		for(const Entry& e : inlined)
+			console << "  inlined \"" << e.callee << "\" into \"" << e.caller << "\" (" << e.calleeSize << " nodes) " << e.callSite << "\n";
+		for(const Entry& e : skipped)
+			console << "  skipped \"" << e.callee << "\" in \"" << e.caller << "\": " << e.reason << " " << e.callSite << "\n";
+	}
+};
+
+
+// AST level inliner: substitutes calls to small non-recursive functions with a renamed copy of the callee body.
+// The copy runs in a variable scope below the caller's, like a call, but without the function lookup. Its locals are renamed,
+// so they can not hide the caller's variables.
+class Inliner {
+private:
+	using Function = AST::FunctionDeclarationStatement;
+
+	struct Site {
+		ScopedSymbolTable* scope; // symbol scope of the copied nodes
+		std::unordered_map<std::string, std::string> names; // callee local name -> renamed local name
+	};
+
+private:
+	size_t budget; // maximum AST node count of an inlined callee body
+	InlineReport report_;
+
+	std::unordered_map<const Function*, std::vector<const Function*>> callees; // call graph
+	std::unordered_set<const Function*> recursive;
+	std::unordered_set<const Function*> finished; // functions whose body has already been rewritten
+	std::unordered_set<const Function*> inProgress;
+	std::string currentFunction;
+	size_t siteCount;
+
+public:
+	inline Inliner(const size_t budget = 32): budget(budget), currentFunction("<global>"), siteCount(0) {}
+
+	inline const InlineReport& report() const { return report_; }
+
+	inline const AST::Node* run(const AST::Node* ast) {
+		std::vector<const Function*> functions;
+		collectFunctions(ast, functions);
+
+		for(const Function* function : functions)
+			collectCallees(function->body, callees[function]);
+
+		for(const Function* function : functions) {
+			std::unordered_set<const Function*> visited;
+			if(reaches(function, function, visited))
+				recursive.insert(function);
+		}
+
+		// rewrite callees before callers, so inlined bodies already contain their own inlined calls
+		for(const Function* function : functions)
+			process(function);
+
+		currentFunction = "<global>";
+
+		switch(ast->baseType()) {
+			case AST::Node::BaseType::EXPRESSION:
+				return rewrite(dynamic_cast<const AST::ExpressionNode*>(ast));
+			case AST::Node::BaseType::STATEMENT:
+				return rewrite(dynamic_cast<const AST::StatementNode*>(ast));
+		}
+
+		throw std::runtime_error("Inliner::run(): invalid AST Node base type");
+	}
+
+	inline static size_t size(const AST::Node* node) {
+		size_t count = 1;
+		node->forEachChild([&](const AST::Node* child) { count += size(child); });
+		return count;
+	}
+
+private:
+	inline static const Function* resolve(const AST::FunctionCallExpressionNode* node) {
+		const Symbol* sym = node->getScope().lookupRecursive(node->name);
+		if(!sym || !std::holds_alternative<const AST::Node*>(sym->type))
+			return nullptr;
+		return dynamic_cast<const Function*>(std::get<const AST::Node*>(sym->type));
+	}
+
+	inline static void collectFunctions(const AST::Node* node, std::vector<const Function*>& out) {
+		if(const Function* function = dynamic_cast<const Function*>(node))
+			out.push_back(function);
+		node->forEachChild([&](const AST::Node* child) { collectFunctions(child, out); });
+	}
+
+	inline static void collectCallees(const AST::Node* node, std::vector<const Function*>& out) {
+		if(dynamic_cast<const Function*>(node))
+			return; // nested functions have their own call graph entry
+
+		if(const AST::FunctionCallExpressionNode* call = dynamic_cast<const AST::FunctionCallExpressionNode*>(node))
+			if(const Function* target = resolve(call))
+				out.push_back(target);
+
+		node->forEachChild([&](const AST::Node* child) { collectCallees(child, out); });
+	}
+
+	inline bool reaches(const Function* from, const Function* to, std::unordered_set<const Function*>& visited) const {
+		if(!callees.contains(from)) return false;
+
+		for(const Function* callee : callees.at(from)) {
+			if(callee == to) return true;
+			if(visited.insert(callee).second && reaches(callee, to, visited)) return true;
+		}
+
+		return false;
+	}
+
+	inline void process(const Function* function) {
+		if(finished.contains(function) || inProgress.contains(function))
+			return;
+
+		inProgress.insert(function);
+
+		if(callees.contains(function))
+			for(const Function* callee : callees.at(function))
+				process(callee);
+
+		currentFunction = function->functionName;
+		function->body = rewrite(function->body);
+
+		inProgress.erase(function);
+		finished.insert(function);
+	}
+
+
+	// #####################
+	// # INLINING DECISION #
+	// #####################
+	inline static void collectLocals(const AST::Node* node, std::vector<std::pair<std::string, std::string>>& out) {
+		if(const AST::VariableDeclarationStatement* decl = dynamic_cast<const AST::VariableDeclarationStatement*>(node))
+			out.push_back({ decl->varName, decl->typeName });
+		node->forEachChild([&](const AST::Node* child) { collectLocals(child, out); });
+	}
+
+	// calls are resolved dynamically at runtime (the callee scope's parent is the caller scope),
+	// so a remaining call inside an inlined body could observe the renamed locals of its new caller
+	inline static bool containsCall(const AST::Node* node) {
+		if(dynamic_cast<const AST::FunctionCallExpressionNode*>(node))
+			return true;
+		bool found = false;
+		node->forEachChild([&](const AST::Node* child) { found = found || containsCall(child); });
+		return found;
+	}
+
+	// locals are renamed for the whole body, so every use of a local name has to come after a visible declaration of it;
+	// otherwise the name also refers to a non-local (e.g. "int s = x; int x = 10;") and renaming would redirect that use
+	inline static bool declaredBeforeUse(const AST::Node* node, std::vector<std::unordered_set<std::string>>& visible, const std::unordered_map<std::string, std::string>& locals) {
+		const auto check = [&](const std::string& name) {
+			if(!locals.contains(name)) return true;
+			for(const std::unordered_set<std::string>& declared : visible)
+				if(declared.contains(name)) return true;
+			return false;
+		};
+
+		if(const AST::VariableDeclarationStatement* decl = dynamic_cast<const AST::VariableDeclarationStatement*>(node))
+			visible.back().insert(decl->varName);
+
+		if(const AST::IdentifierNode* id = dynamic_cast<const AST::IdentifierNode*>(node))
+			if(!check(id->name)) return false;
+
+		if(const AST::VariableAssignmentStatement* assignment = dynamic_cast<const AST::VariableAssignmentStatement*>(node))
+			if(!check(assignment->varName)) return false;
+
+		if(const AST::ElementAssignmentStatement* assignment = dynamic_cast<const AST::ElementAssignmentStatement*>(node))
+			if(!check(assignment->varName)) return false;
+
+		if(const AST::FieldAssignmentStatement* assignment = dynamic_cast<const AST::FieldAssignmentStatement*>(node))
+			if(!check(assignment->varName)) return false;
+
+		// declarations inside blocks and loops are not visible after them
+		const bool block = dynamic_cast<const AST::StatementList*>(node) || dynamic_cast<const AST::ForStatement*>(node)
+			|| dynamic_cast<const AST::CountedForStatement*>(node) || dynamic_cast<const AST::InlinedCallExpressionNode*>(node);
+		if(block)
+			visible.emplace_back();
+
+		bool ok = true;
+		node->forEachChild([&](const AST::Node* child) { ok = ok && declaredBeforeUse(child, visible, locals); });
+
+		if(block)
+			visible.pop_back();
+		return ok;
+	}
+
+	// returns true if every non-local name used by the callee resolves to the same symbol at the call site
+	inline static bool resolvesIdentically(const AST::Node* node, const ScopedSymbolTable& callSite, const std::unordered_map<std::string, std::string>& locals) {
+		const auto check = [&](const std::string& name) {
+			return locals.contains(name) || callSite.lookupRecursive(name) == node->getScope().lookupRecursive(name);
+		};
+
+		if(dynamic_cast<const Function*>(node))
+			return false; // nested function declarations can not be copied into an expression
+
+		if(const AST::IdentifierNode* id = dynamic_cast<const AST::IdentifierNode*>(node))
+			if(!check(id->name)) return false;
+
+		if(const AST::VariableAssignmentStatement* assignment = dynamic_cast<const AST::VariableAssignmentStatement*>(node))
+			if(!locals.contains(assignment->varName)) return false; // writes to non-locals would become visible in the caller's scope
+
+		if(const AST::ElementAssignmentStatement* assignment = dynamic_cast<const AST::ElementAssignmentStatement*>(node))
+			if(!check(assignment->varName)) return false; // the array itself is shared, only the name has to resolve to it
+
+		if(const AST::FieldAssignmentStatement* assignment = dynamic_cast<const AST::FieldAssignmentStatement*>(node))
+			if(!check(assignment->varName)) return false; // same for records
+
+		bool ok = true;
+		node->forEachChild([&](const AST::Node* child) { ok = ok && resolvesIdentically(child, callSite, locals); });
+		return ok;
+	}
+
+	inline const AST::ExpressionNode* tryInline(const AST::FunctionCallExpressionNode* node, const std::vector<const AST::ExpressionNode*>& args) {
+		const Function* callee = resolve(node);
+		if(!callee)
+			return nullptr;
+
+		const size_t calleeSize = size(callee->body);
+
+		const auto skip = [&](const std::string& reason) -> const AST::ExpressionNode* {
+			report_.skipped.push_back({ currentFunction, node->name, calleeSize, node->span(), reason });
+			return nullptr;
+		};
+
+		if(recursive.contains(callee))
+			return skip("recursive");
+		if(!finished.contains(callee))
+			return skip("callee not yet rewritten");
+		if(calleeSize > budget)
+			return skip("body exceeds budget of " + std::to_string(budget) + " nodes");
+		if(args.size() != callee->args.size())
+			return skip("argument count mismatch");
+		if(containsCall(callee->body))
+			return skip("body contains calls that were not inlined");
+
+		std::vector<std::pair<std::string, std::string>> locals; // name, type
+		for(const Function::Argument& arg : callee->args)
+			locals.push_back({ arg.name, arg.type });
+		collectLocals(callee->body, locals);
+
+		Site site{ new ScopedSymbolTable("Inlined Function Scope \"" + callee->functionName + "\"", &node->getScope()), {} };
+		const std::string prefix = callee->functionName + "#" + std::to_string(siteCount++) + ".";
+		for(const auto& [name, type] : locals)
+			site.names[name] = prefix + name;
+
+		std::vector<std::unordered_set<std::string>> visible(1);
+		for(const Function::Argument& arg : callee->args)
+			visible.front().insert(arg.name);
+		if(!declaredBeforeUse(callee->body, visible, site.names))
+			return skip("local shadows a name that is also used non-locally");
+
+		if(!resolvesIdentically(callee->body, node->getScope(), site.names))
+			return skip("non-local name is shadowed or written at the call site");
+
+		for(const auto& [name, type] : locals)
+			if(!site.scope->lookup(site.names.at(name)))
+				site.scope->declare(new Symbol(Symbol::Category::VARIABLE, site.names.at(name), type));
+
+		std::vector<const AST::VariableDeclarationStatement*> bindings;
+		for(size_t i = 0; i < args.size(); i++) {
+			const std::string& name = site.names.at(callee->args[i].name);
+			const AST::VariableAssignmentStatement* assignment = new AST::VariableAssignmentStatement(site.scope, name, args[i], callee->args[i].nameSpan);
+			bindings.push_back(new AST::VariableDeclarationStatement(site.scope, callee->args[i].type, name, assignment, callee->args[i].typeSpan, callee->args[i].nameSpan));
+			assignment->setSpan(args[i]->span());
+			bindings.back()->setSpan(args[i]->span());
+		}
+
+		report_.inlined.push_back({ currentFunction, node->name, calleeSize, node->span(), "" });
+
+		return new AST::InlinedCallExpressionNode(&node->getScope(), callee, bindings, copy(callee->body, site), node->nameSpan);
+	}
+
+
+	// #############
+	// # REWRITING #
+	// #############
+	// rewritten nodes keep the source span of the node they replace
+	inline const AST::ExpressionNode* rewrite(const AST::ExpressionNode* node) {
+		const AST::ExpressionNode* res = rewriteNode(node);
+		if(res != node) res->setSpan(node->span());
+		return res;
+	}
+
+	inline const AST::StatementNode* rewrite(const AST::StatementNode* node) {
+		const AST::StatementNode* res = rewriteNode(node);
+		if(res != node) res->setSpan(node->span());
+		return res;
+	}
+
+	inline const AST::ExpressionNode* rewriteNode(const AST::ExpressionNode* node) {
+		switch(node->type()) {
+			case AST::ExpressionNode::Type::LITERAL_EXPRESSION:
+			case AST::ExpressionNode::Type::VARIABLE_EXPRESSION:
+			case AST::ExpressionNode::Type::INLINED_CALL_EXPRESSION:
+			case AST::ExpressionNode::Type::RECORD_EXPRESSION:
+				return node;
+
+			case AST::ExpressionNode::Type::UNARY_EXPRESSION: {
+				const AST::UnaryExpressionNode* n = dynamic_cast<const AST::UnaryExpressionNode*>(node);
+				const AST::ExpressionNode* a = rewrite(n->a);
+				return a == n->a ? n : new AST::UnaryExpressionNode(&n->getScope(), n->opString(), a);
+			}
+
+			case AST::ExpressionNode::Type::BINARY_EXPRESSION: {
+				const AST::BinaryExpressionNode* n = dynamic_cast<const AST::BinaryExpressionNode*>(node);
+				const AST::ExpressionNode* a = rewrite(n->a);
+				const AST::ExpressionNode* b = rewrite(n->b);
+				return (a == n->a && b == n->b) ? n : new AST::BinaryExpressionNode(&n->getScope(), a, n->opString(), b);
+			}
+
+			case AST::ExpressionNode::Type::CALL_EXPRESSION: {
+				const AST::FunctionCallExpressionNode* n = dynamic_cast<const AST::FunctionCallExpressionNode*>(node);
+
+				bool changed = false;
+				std::vector<const AST::ExpressionNode*> args;
+				for(const AST::ExpressionNode* arg : n->args) {
+					args.push_back(rewrite(arg));
+					changed = changed || args.back() != arg;
+				}
+
+				if(const AST::ExpressionNode* inlined = tryInline(n, args))
+					return inlined;
+
+				return changed ? new AST::FunctionCallExpressionNode(&n->getScope(), n->name, args, n->nameSpan) : n;
+			}
+
+			case AST::ExpressionNode::Type::BUILTIN_CALL_EXPRESSION: {
+				const AST::BuiltinCallExpressionNode* n = dynamic_cast<const AST::BuiltinCallExpressionNode*>(node);
+
+				bool changed = false;
+				std::vector<const AST::ExpressionNode*> args;
+				for(const AST::ExpressionNode* arg : n->args) {
+					args.push_back(rewrite(arg));
+					changed = changed || args.back() != arg;
+				}
+
+				return changed ? new AST::BuiltinCallExpressionNode(&n->getScope(), n->builtin, args, n->nameSpan) : n;
+			}
+
+			case AST::ExpressionNode::Type::ARRAY_EXPRESSION: {
+				const AST::ArrayExpressionNode* n = dynamic_cast<const AST::ArrayExpressionNode*>(node);
+				const AST::ExpressionNode* length = n->length ? rewrite(n->length) : nullptr;
+
+				bool changed = length != n->length;
+				std::vector<const AST::ExpressionNode*> elements;
+				for(const AST::ExpressionNode* element : n->elements) {
+					elements.push_back(rewrite(element));
+					changed = changed || elements.back() != element;
+				}
+
+				return changed ? new AST::ArrayExpressionNode(&n->getScope(), n->elementType, length, elements) : n;
+			}
+
+			case AST::ExpressionNode::Type::INDEX_EXPRESSION: {
+				const AST::IndexExpressionNode* n = dynamic_cast<const AST::IndexExpressionNode*>(node);
+				const AST::ExpressionNode* array = rewrite(n->array);
+				const AST::ExpressionNode* index = rewrite(n->index);
+				return (array == n->array && index == n->index) ? n : new AST::IndexExpressionNode(&n->getScope(), array, index, n->checked);
+			}
+
+			case AST::ExpressionNode::Type::LENGTH_EXPRESSION: {
+				const AST::LengthExpressionNode* n = dynamic_cast<const AST::LengthExpressionNode*>(node);
+				const AST::ExpressionNode* array = rewrite(n->array);
+				return array == n->array ? n : new AST::LengthExpressionNode(&n->getScope(), array);
+			}
+
+			case AST::ExpressionNode::Type::FIELD_EXPRESSION: {
+				const AST::FieldExpressionNode* n = dynamic_cast<const AST::FieldExpressionNode*>(node);
+				const AST::ExpressionNode* object = rewrite(n->object);
+				return object == n->object ? n : new AST::FieldExpressionNode(&n->getScope(), object, n->declaration, n->fieldName);
+			}
+
+			case AST::ExpressionNode::Type::CONCAT_EXPRESSION: {
+				const AST::ConcatExpressionNode* n = dynamic_cast<const AST::ConcatExpressionNode*>(node);
+
+				bool changed = false;
+				std::vector<const AST::ExpressionNode*> parts;
+				for(const AST::ExpressionNode* part : n->parts) {
+					parts.push_back(rewrite(part));
+					changed = changed || parts.back() != part;
+				}
+
+				return changed ? new AST::ConcatExpressionNode(&n->getScope(), parts) : n;
+			}
+		}
+
+		throw std::runtime_error("Inliner::rewrite(ExpressionNode): invalid expression Node type");
+	}
+
+	inline const AST::StatementNode* rewriteNode(const AST::StatementNode* node) {
+		switch(node->type()) {
+			case AST::StatementNode::Type::EXPRESSION_STATEMENT: {
+				const AST::ExpressionStatement* n = dynamic_cast<const AST::ExpressionStatement*>(node);
+				const AST::ExpressionNode* expr = rewrite(n->expr);
+				return expr == n->expr ? n : new AST::ExpressionStatement(&n->getScope(), expr);
+			}
+
+			case AST::StatementNode::Type::STATEMENT_LIST: {
+				const AST::StatementList* n = dynamic_cast<const AST::StatementList*>(node);
+
+				bool changed = false;
+				std::vector<const AST::StatementNode*> statements;
+				for(const AST::StatementNode* statement : n->statements) {
+					statements.push_back(rewrite(statement));
+					changed = changed || statements.back() != statement;
+				}
+
+				return changed ? new AST::StatementList(&n->getScope(), statements) : n;
+			}
+
+			case AST::StatementNode::Type::RETURN_STATEMENT: {
+				const AST::ReturnStatement* n = dynamic_cast<const AST::ReturnStatement*>(node);
+				const AST::ExpressionNode* expr = rewrite(n->expr);
+				return expr == n->expr ? n : new AST::ReturnStatement(&n->getScope(), expr);
+			}
+
+			case AST::StatementNode::Type::IF_STATEMENT: {
+				const AST::IfStatement* n = dynamic_cast<const AST::IfStatement*>(node);
+				const AST::ExpressionNode* condition = rewrite(n->condition);
+				const AST::StatementNode* body = rewrite(n->body);
+				return (condition == n->condition && body == n->body) ? n : new AST::IfStatement(&n->getScope(), condition, body);
+			}
+
+			case AST::StatementNode::Type::WHILE_STATEMENT: {
+				const AST::WhileStatement* n = dynamic_cast<const AST::WhileStatement*>(node);
+				const AST::ExpressionNode* condition = rewrite(n->condition);
+				const AST::StatementNode* body = rewrite(n->body);
+				return (condition == n->condition && body == n->body) ? n : new AST::WhileStatement(&n->getScope(), condition, body);
+			}
+
+			case AST::StatementNode::Type::FOR_STATEMENT: {
+				const AST::ForStatement* n = dynamic_cast<const AST::ForStatement*>(node);
+				const AST::StatementNode* init = n->init ? rewrite(n->init) : nullptr;
+				const AST::ExpressionNode* condition = n->condition ? rewrite(n->condition) : nullptr;
+				const AST::StatementNode* step = n->step ? rewrite(n->step) : nullptr;
+				const AST::StatementNode* body = rewrite(n->body);
+				return (init == n->init && condition == n->condition && step == n->step && body == n->body) ? n
+					: new AST::ForStatement(&n->getScope(), init, condition, dynamic_cast<const AST::VariableAssignmentStatement*>(step), body);
+			}
+
+			case AST::StatementNode::Type::COUNTED_FOR_STATEMENT: {
+				const AST::CountedForStatement* n = dynamic_cast<const AST::CountedForStatement*>(node);
+				const AST::StatementNode* init = rewrite(n->init);
+				const AST::ExpressionNode* bound = rewrite(n->bound);
+				const AST::StatementNode* body = rewrite(n->body);
+				return (init == n->init && bound == n->bound && body == n->body) ? n
+					: new AST::CountedForStatement(&n->getScope(), dynamic_cast<const AST::VariableDeclarationStatement*>(init), bound, n->inclusive, n->stride, n->boundInvariant, body);
+			}
+
+			case AST::StatementNode::Type::SWITCH_STATEMENT: {
+				const AST::SwitchStatement* n = dynamic_cast<const AST::SwitchStatement*>(node);
+				const AST::ExpressionNode* value = rewrite(n->value);
+
+				bool changed = value != n->value;
+				std::vector<const AST::StatementNode*> statements;
+				for(const AST::StatementNode* statement : n->statements) {
+					statements.push_back(rewrite(statement));
+					changed = changed || statements.back() != statement;
+				}
+
+				return changed ? new AST::SwitchStatement(&n->getScope(), value, statements, n->labels, n->defaultTarget) : n;
+			}
+
+			case AST::StatementNode::Type::BREAK_STATEMENT:
+			case AST::StatementNode::Type::CONTINUE_STATEMENT:
+				return node;
+
+			case AST::StatementNode::Type::FUNCTION_DECLARATION_STATEMENT:
+				return node; // bodies are rewritten by process()
+
+			case AST::StatementNode::Type::STRUCT_DECLARATION_STATEMENT:
+				return node;
+
+			case AST::StatementNode::Type::VARIABLE_DECLARATION_STATEMENT: {
+				const AST::VariableDeclarationStatement* n = dynamic_cast<const AST::VariableDeclarationStatement*>(node);
+				if(!n->initialAssignment)
+					return n;
+				const AST::StatementNode* assignment = rewrite(n->initialAssignment);
+				return assignment == n->initialAssignment ? n : new AST::VariableDeclarationStatement(&n->getScope(), n->typeName, n->varName, dynamic_cast<const AST::VariableAssignmentStatement*>(assignment), n->typeSpan, n->nameSpan);
+			}
+
+			case AST::StatementNode::Type::VARIABLE_ASSIGNMENT_STATEMENT: {
+				const AST::VariableAssignmentStatement* n = dynamic_cast<const AST::VariableAssignmentStatement*>(node);
+				const AST::ExpressionNode* expr = rewrite(n->expr);
+				return expr == n->expr ? n : new AST::VariableAssignmentStatement(&n->getScope(), n->varName, expr, n->nameSpan);
+			}
+
+			case AST::StatementNode::Type::ELEMENT_ASSIGNMENT_STATEMENT: {
+				const AST::ElementAssignmentStatement* n = dynamic_cast<const AST::ElementAssignmentStatement*>(node);
+				const AST::ExpressionNode* index = rewrite(n->index);
+				const AST::ExpressionNode* expr = rewrite(n->expr);
+				return (index == n->index && expr == n->expr) ? n : new AST::ElementAssignmentStatement(&n->getScope(), n->varName, index, expr, n->checked, n->nameSpan);
+			}
+
+			case AST::StatementNode::Type::FIELD_ASSIGNMENT_STATEMENT: {
+				const AST::FieldAssignmentStatement* n = dynamic_cast<const AST::FieldAssignmentStatement*>(node);
+				const AST::ExpressionNode* expr = rewrite(n->expr);
+				return expr == n->expr ? n : new AST::FieldAssignmentStatement(&n->getScope(), n->varName, n->declaration, n->fieldName, expr, n->nameSpan);
+			}
+		}
+
+		throw std::runtime_error("Inliner::rewrite(StatementNode): invalid statement Node type");
+	}
+
+
+	// ###########
+	// # COPYING #
+	// ###########
+	// copies keep the source span of the callee node, so runtime statistics point at the callee's source lines
+	inline static const AST::ExpressionNode* copy(const AST::ExpressionNode* node, const Site& site) {
+		const AST::ExpressionNode* res = copyNode(node, site);
+		res->setSpan(node->span());
+		return res;
+	}
+
+	inline static const AST::StatementNode* copy(const AST::StatementNode* node, const Site& site) {
+		const AST::StatementNode* res = copyNode(node, site);
+		res->setSpan(node->span());
+		return res;
+	}
+
+	inline static const std::string& renamed(const std::string& name, const Site& site) {
+		return site.names.contains(name) ? site.names.at(name) : name;
+	}
+
+	inline static const AST::ExpressionNode* copyNode(const AST::ExpressionNode* node, const Site& site) {
+		switch(node->type()) {
+			case AST::ExpressionNode::Type::LITERAL_EXPRESSION: {
+				const AST::LiteralNode* n = dynamic_cast<const AST::LiteralNode*>(node);
+				switch(n->type) {
+					case AST::LiteralNode::LiteralType::BOOL:
+						return new AST::BoolLiteralNode(site.scope, dynamic_cast<const AST::BoolLiteralNode*>(n)->value);
+					case AST::LiteralNode::LiteralType::INT:
+						return new AST::IntLiteralNode(site.scope, dynamic_cast<const AST::IntLiteralNode*>(n)->value);
+					case AST::LiteralNode::LiteralType::FLOAT:
+						return new AST::FloatLiteralNode(site.scope, dynamic_cast<const AST::FloatLiteralNode*>(n)->value);
+					case AST::LiteralNode::LiteralType::STRING:
+						return new AST::StringLiteralNode(site.scope, dynamic_cast<const AST::StringLiteralNode*>(n)->value);
+				}
+				break;
+			}
+
+			case AST::ExpressionNode::Type::VARIABLE_EXPRESSION:
+				return new AST::IdentifierNode(site.scope, renamed(dynamic_cast<const AST::IdentifierNode*>(node)->name, site));
+
+			case AST::ExpressionNode::Type::UNARY_EXPRESSION: {
+				const AST::UnaryExpressionNode* n = dynamic_cast<const AST::UnaryExpressionNode*>(node);
+				return new AST::UnaryExpressionNode(site.scope, n->opString(), copy(n->a, site));
+			}
+
+			case AST::ExpressionNode::Type::BINARY_EXPRESSION: {
+				const AST::BinaryExpressionNode* n = dynamic_cast<const AST::BinaryExpressionNode*>(node);
+				return new AST::BinaryExpressionNode(site.scope, copy(n->a, site), n->opString(), copy(n->b, site));
+			}
+
+			case AST::ExpressionNode::Type::CALL_EXPRESSION: {
+				const AST::FunctionCallExpressionNode* n = dynamic_cast<const AST::FunctionCallExpressionNode*>(node);
+				std::vector<const AST::ExpressionNode*> args;
+				for(const AST::ExpressionNode* arg : n->args)
+					args.push_back(copy(arg, site));
+				return new AST::FunctionCallExpressionNode(site.scope, n->name, args, n->nameSpan);
+			}
+
+			case AST::ExpressionNode::Type::BUILTIN_CALL_EXPRESSION: {
+				const AST::BuiltinCallExpressionNode* n = dynamic_cast<const AST::BuiltinCallExpressionNode*>(node);
+				std::vector<const AST::ExpressionNode*> args;
+				for(const AST::ExpressionNode* arg : n->args)
+					args.push_back(copy(arg, site));
+				return new AST::BuiltinCallExpressionNode(site.scope, n->builtin, args, n->nameSpan);
+			}
+
+			case AST::ExpressionNode::Type::INLINED_CALL_EXPRESSION: {
+				const AST::InlinedCallExpressionNode* n = dynamic_cast<const AST::InlinedCallExpressionNode*>(node);
+				std::vector<const AST::VariableDeclarationStatement*> bindings;
+				for(const AST::VariableDeclarationStatement* binding : n->bindings)
+					bindings.push_back(dynamic_cast<const AST::VariableDeclarationStatement*>(copy(binding, site)));
+				return new AST::InlinedCallExpressionNode(site.scope, n->function, bindings, copy(n->body, site), n->nameSpan);
+			}
+
+			case AST::ExpressionNode::Type::ARRAY_EXPRESSION: {
+				const AST::ArrayExpressionNode* n = dynamic_cast<const AST::ArrayExpressionNode*>(node);
+				std::vector<const AST::ExpressionNode*> elements;
+				for(const AST::ExpressionNode* element : n->elements)
+					elements.push_back(copy(element, site));
+				return new AST::ArrayExpressionNode(site.scope, n->elementType, n->length ? copy(n->length, site) : nullptr, elements);
+			}
+
+			case AST::ExpressionNode::Type::INDEX_EXPRESSION: {
+				const AST::IndexExpressionNode* n = dynamic_cast<const AST::IndexExpressionNode*>(node);
+				return new AST::IndexExpressionNode(site.scope, copy(n->array, site), copy(n->index, site), n->checked);
+			}
+
+			case AST::ExpressionNode::Type::LENGTH_EXPRESSION:
+				return new AST::LengthExpressionNode(site.scope, copy(dynamic_cast<const AST::LengthExpressionNode*>(node)->array, site));
+
+			case AST::ExpressionNode::Type::RECORD_EXPRESSION:
+				return new AST::RecordExpressionNode(site.scope, dynamic_cast<const AST::RecordExpressionNode*>(node)->declaration);
+
+			case AST::ExpressionNode::Type::FIELD_EXPRESSION: {
+				const AST::FieldExpressionNode* n = dynamic_cast<const AST::FieldExpressionNode*>(node);
+				return new AST::FieldExpressionNode(site.scope, copy(n->object, site), n->declaration, n->fieldName);
+			}
+
+			case AST::ExpressionNode::Type::CONCAT_EXPRESSION: {
+				const AST::ConcatExpressionNode* n = dynamic_cast<const AST::ConcatExpressionNode*>(node);
+				std::vector<const AST::ExpressionNode*> parts;
+				for(const AST::ExpressionNode* part : n->parts)
+					parts.push_back(copy(part, site));
+				return new AST::ConcatExpressionNode(site.scope, parts);
+			}
+		}
+
+		throw std::runtime_error("Inliner::copy(ExpressionNode): invalid expression Node type");
+	}
+
+	inline static const AST::StatementNode* copyNode(const AST::StatementNode* node, const Site& site) {
+		switch(node->type()) {
+			case AST::StatementNode::Type::EXPRESSION_STATEMENT:
+				return new AST::ExpressionStatement(site.scope, copy(dynamic_cast<const AST::ExpressionStatement*>(node)->expr, site));
+
+			case AST::StatementNode::Type::STATEMENT_LIST: {
+				std::vector<const AST::StatementNode*> statements;
+				for(const AST::StatementNode* statement : dynamic_cast<const AST::StatementList*>(node)->statements)
+					statements.push_back(copy(statement, site));
+				return new AST::StatementList(site.scope, statements);
+			}
+
+			case AST::StatementNode::Type::RETURN_STATEMENT:
+				return new AST::ReturnStatement(site.scope, copy(dynamic_cast<const AST::ReturnStatement*>(node)->expr, site));
+
+			case AST::StatementNode::Type::IF_STATEMENT: {
+				const AST::IfStatement* n = dynamic_cast<const AST::IfStatement*>(node);
+				return new AST::IfStatement(site.scope, copy(n->condition, site), copy(n->body, site));
+			}
+
+			case AST::StatementNode::Type::WHILE_STATEMENT: {
+				const AST::WhileStatement* n = dynamic_cast<const AST::WhileStatement*>(node);
+				return new AST::WhileStatement(site.scope, copy(n->condition, site), copy(n->body, site));
+			}
+
+			case AST::StatementNode::Type::FOR_STATEMENT: {
+				const AST::ForStatement* n = dynamic_cast<const AST::ForStatement*>(node);
+				return new AST::ForStatement(site.scope,
+					n->init ? copy(n->init, site) : nullptr,
+					n->condition ? copy(n->condition, site) : nullptr,
+					n->step ? dynamic_cast<const AST::VariableAssignmentStatement*>(copy(n->step, site)) : nullptr,
+					copy(n->body, site));
+			}
+
+			case AST::StatementNode::Type::COUNTED_FOR_STATEMENT: {
+				const AST::CountedForStatement* n = dynamic_cast<const AST::CountedForStatement*>(node);
+				return new AST::CountedForStatement(site.scope, dynamic_cast<const AST::VariableDeclarationStatement*>(copy(n->init, site)), copy(n->bound, site), n->inclusive, n->stride, n->boundInvariant, copy(n->body, site));
+			}
+
+			case AST::StatementNode::Type::SWITCH_STATEMENT: {
+				const AST::SwitchStatement* n = dynamic_cast<const AST::SwitchStatement*>(node);
+				std::vector<const AST::StatementNode*> statements;
+				for(const AST::StatementNode* statement : n->statements)
+					statements.push_back(copy(statement, site));
+				return new AST::SwitchStatement(site.scope, copy(n->value, site), statements, n->labels, n->defaultTarget);
+			}
+
+			case AST::StatementNode::Type::BREAK_STATEMENT:
+				return new AST::BreakStatement(site.scope);
+
+			case AST::StatementNode::Type::CONTINUE_STATEMENT:
+				return new AST::ContinueStatement(site.scope);
+
+			case AST::StatementNode::Type::FUNCTION_DECLARATION_STATEMENT:
+				break; // rejected by resolvesIdentically()
+
+			case AST::StatementNode::Type::STRUCT_DECLARATION_STATEMENT:
+				return node; // only declares a type, the copied records keep referring to it
+
+			case AST::StatementNode::Type::VARIABLE_DECLARATION_STATEMENT: {
+				const AST::VariableDeclarationStatement* n = dynamic_cast<const AST::VariableDeclarationStatement*>(node);
+				const AST::VariableAssignmentStatement* assignment = n->initialAssignment ? dynamic_cast<const AST::VariableAssignmentStatement*>(copy(n->initialAssignment, site)) : nullptr;
+				return new AST::VariableDeclarationStatement(site.scope, n->typeName, renamed(n->varName, site), assignment, n->typeSpan, n->nameSpan);
+			}
+
+			case AST::StatementNode::Type::VARIABLE_ASSIGNMENT_STATEMENT: {
+				const AST::VariableAssignmentStatement* n = dynamic_cast<const AST::VariableAssignmentStatement*>(node);
+				return new AST::VariableAssignmentStatement(site.scope, renamed(n->varName, site), copy(n->expr, site), n->nameSpan);
+			}
+
+			case AST::StatementNode::Type::ELEMENT_ASSIGNMENT_STATEMENT: {
+				const AST::ElementAssignmentStatement* n = dynamic_cast<const AST::ElementAssignmentStatement*>(node);
+				return new AST::ElementAssignmentStatement(site.scope, renamed(n->varName, site), copy(n->index, site), copy(n->expr, site), n->checked, n->nameSpan);
+			}
+
+			case AST::StatementNode::Type::FIELD_ASSIGNMENT_STATEMENT: {
+				const AST::FieldAssignmentStatement* n = dynamic_cast<const AST::FieldAssignmentStatement*>(node);
+				return new AST::FieldAssignmentStatement(site.scope, renamed(n->varName, site), n->declaration, n->fieldName, copy(n->expr, site), n->nameSpan);
+			}
+		}
+
+		throw std::runtime_error("Inliner::copy(StatementNode): invalid statement Node type");
+	}
+};
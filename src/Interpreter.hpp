@@ -1,91 +1,28 @@
 #pragma once
 
 
+#include <type_traits>
+#include <functional>
 #include <stdexcept>
+#include <algorithm>
 #include <iostream>
 #include <variant>
+#include <utility>
 #include <cstdint>
+#include <atomic>
 #include <vector>
 #include <string>
 
 #include "AST.hpp"
 #include "ScopedSymbolTable.hpp"
-
-
-inline std::string operator+(const std::string& a, const int v) { return a + std::to_string(v); }
-inline std::string operator+(const std::string& a, const float v) { return a + std::to_string(v); }
-inline std::string operator+(const std::string& a, const bool b) { return a + (b ? "true" : "false"); }
-
-
-// string [- * /] [bool float int string]  =>  string  <exception>
-#define STRING_OP_DEFINE_TYPE(OP, T) \
-	inline std::string OP(const std::string& a, const T& b) { throw std::runtime_error("Tried to execute placeholder string-operation std::string " #OP " " #T); }
-#define STRING_OP_DEFINE(OP) \
-	STRING_OP_DEFINE_TYPE(OP, bool) \
-	STRING_OP_DEFINE_TYPE(OP, float) \
-	STRING_OP_DEFINE_TYPE(OP, int) \
-	STRING_OP_DEFINE_TYPE(OP, std::string)
-STRING_OP_DEFINE(operator-)
-STRING_OP_DEFINE(operator*)
-STRING_OP_DEFINE(operator/)
-#undef STRING_OP_DEFINE_TYPE
-#undef STRING_OP_DEFINE
-
-
-// string [== != > < >= <=] [bool float int string]  =>  bool  <exception>
-#define STRING_OP_DEFINE_TYPE(OP, T) \
-	inline bool OP(const std::string& a, const T& b) { throw std::runtime_error("Tried to execute placeholder string-operation std::string " #OP " " #T); }
-#define STRING_OP_DEFINE(OP) \
-	STRING_OP_DEFINE_TYPE(OP, bool) \
-	STRING_OP_DEFINE_TYPE(OP, float) \
-	STRING_OP_DEFINE_TYPE(OP, int)
-STRING_OP_DEFINE(operator==)
-STRING_OP_DEFINE(operator!=)
-STRING_OP_DEFINE(operator>)
-STRING_OP_DEFINE(operator<)
-STRING_OP_DEFINE(operator>=)
-STRING_OP_DEFINE(operator<=)
-#undef STRING_OP_DEFINE_TYPE
-#undef STRING_OP_DEFINE
-
-
-// T [+ - * /] string  =>  string  <string [+ - * /] T>
-#define STRING_OP_CORRECT(OP_NAME, OP) \
-	template<typename T> \
-		requires ( \
-			requires (T a, const std::string& b) { \
-				{b OP a} -> std::convertible_to<std::string>; \
-			} \
-			&& !std::convertible_to<std::remove_cvref_t<T>, std::string> \
-		)  \
-	inline std::string OP_NAME(const T& a, const std::string& b) { return b OP a; }
-STRING_OP_CORRECT(operator+, +)
-STRING_OP_CORRECT(operator-, -)
-STRING_OP_CORRECT(operator*, *)
-STRING_OP_CORRECT(operator/, /)
-#undef STRING_OP_CORRECT
-
-// T [== != > < >= <=] string  =>  bool  <string [== != > < >= <=] T>  ||  <exception>
-#define STRING_OP_CORRECT(OP_NAME, OP) \
-	template<typename T> \
-		requires ( \
-			!std::convertible_to<std::remove_cvref_t<T>, std::string> && \
-			requires (T a, const std::string& b) {{b OP a} -> std::convertible_to<bool>; } \
-		)  \
-	inline bool OP_NAME(const T& a, const std::string& b) { return b OP a; } \
-	template<typename T> \
-		requires ( \
-			!std::convertible_to<std::remove_cvref_t<T>, std::string> && \
-			!requires (T a, const std::string& b) {{b OP a} -> std::convertible_to<bool>; } \
-		)  \
-	inline bool OP_NAME(const T& a, const std::string& b) { throw std::runtime_error("Tried to execute placeholder string-operation std::string " #OP " " "UnknownType!!1!"); }
-STRING_OP_CORRECT(operator==, ==)
-STRING_OP_CORRECT(operator!=, !=)
-STRING_OP_CORRECT(operator>, >)
-STRING_OP_CORRECT(operator<, <)
-STRING_OP_CORRECT(operator>=, >=)
-STRING_OP_CORRECT(operator<=, <=)
-#undef STRING_OP_CORRECT
+#include "Value.hpp"
+#include "Profiler.hpp"
+#include "LineCounter.hpp"
+#include "Trace.hpp"
+#include "InterpreterStats.hpp"
+#include "CompiledProgram.hpp"
+#include "ParallelAnalysis.hpp"
+#include "WorkStealingPool.hpp"
 
 
 struct StatementResult {
@@ -109,132 +46,44 @@ public:
 };
 
 
-struct Value {
-private:
-	struct VoidT {};
-	std::variant<std::monostate, VoidT, bool, int, float, std::string> value; // std::monostate -> no value
-
-public:
-	inline Value(void): value{} {}
-	inline Value(const bool b): value(b) {}
-	inline Value(const int b): value(b) {}
-	inline Value(const float b): value(b) {}
-	inline Value(const std::string& b): value(b) {}
-	inline static Value Void() { return { VoidT() }; }
-
-private:
-	inline Value(const VoidT& v): value(v) {}
-
-public:
-	template<typename T>
-	inline bool is() const { return std::holds_alternative<T>(value); }
-	inline bool isEmpty() const { return is<std::monostate>(); }
-	inline bool isVoid() const { return is<VoidT>(); }
-	inline bool isConvertibleToBool() const { return is<bool>() || is<int>(); }
-
-	template<typename T>
-	inline T get() const { return std::get<T>(value); }
-
-	template<typename T>
-	inline T to() const;
-
-	template<>
-	inline bool to<bool>() const {
-		if(is<bool>()) return get<bool>();
-		if(is<int>()) return get<int>();
-		throw std::runtime_error("Value::convert: Tried to convert non-bool-converible Value to bool");
-	}
-
-	template<>
-	inline int to<int>() const {
-		if(is<bool>()) return get<bool>();
-		if(is<int>()) return get<int>();
-		throw std::runtime_error("Value::convert: Tried to convert non-int-converible Value to int");
-	}
-
-	template<>
-	inline float to<float>() const {
-		if(is<bool>()) return get<bool>();
-		if(is<int>()) return get<int>();
-		if(is<float>()) return get<float>();
-		throw std::runtime_error("Value::convert: Tried to convert non-float-converible Value to float");
-	}
-
-	template<>
-	inline std::string to<std::string>() const {
-		if(is<bool>()) return get<bool>() ? "true" : "false";
-		if(is<int>()) return std::to_string(get<int>());
-		if(is<float>()) return std::to_string(get<float>());
-		if(is<std::string>()) return get<std::string>();
-		throw std::runtime_error("Value::convert: Tried to convert non-string-converible Value to string");
-	}
-
-	inline std::string toString() const {
-		if(isEmpty()) return "<NO VALUE>";
-		if(isVoid()) return "<VOID>";
-		if(is<bool>()) return (get<bool>() ? "true" : "false");
-		if(is<int>()) return "<int>" + std::to_string(get<int>());
-		if(is<float>()) return "<float>" + std::to_string(get<float>());
-		if(is<std::string>()) return "<string>\"" + get<std::string>() + "\"";
-		throw std::runtime_error("Error printing interpreter value: unknown variant type");
-	}
-
-public:
-	#define typeCaseAB(TA, OP, TB) \
-		if(is<TA>() && other.is<TB>()) return get<TA>() OP other.get<TB>();
-	#define typeCaseA(TA, OP) \
-		typeCaseAB(TA, OP, bool) \
-		typeCaseAB(TA, OP, int) \
-		typeCaseAB(TA, OP, float) \
-		typeCaseAB(TA, OP, std::string)
-	#define opImpl(OP_NAME, OP) \
-		inline Value OP_NAME(const Value& other) const { \
-			typeCaseA(bool, OP) \
-			typeCaseA(int, OP) \
-			typeCaseA(float, OP) \
-			typeCaseA(std::string, OP) \
-			throw std::runtime_error("Error executing Interpreter::Value::" #OP_NAME "(): unsipported types " + toString() + ", " + other.toString()); \
-		}
-	opImpl(operator+, +)
-	opImpl(operator-, -)
-	opImpl(operator*, *)
-	opImpl(operator/, /)
-	opImpl(operator==, ==)
-	opImpl(operator!=, !=)
-	opImpl(operator>, >)
-	opImpl(operator<, <)
-	opImpl(operator>=, >=)
-	opImpl(operator<=, <=)
-	#undef opImpl
-	#undef typeCaseA
-	#undef typeCaseAB
-};
-
-
 struct Variable {
 	enum class Category : uint8_t {
-		BOOL, INT, FLOAT, STRING,
+		BOOL, INT, FLOAT, STRING, ARRAY, RECORD,
 	} type;
 	std::string name;
 	Value value;
-	inline Variable(const Category type, const std::string& name, const Value& value): type(type), name(name), value(value) {}
+	inline Variable(const Category type, const std::string& name, Value value): type(type), name(name), value(std::move(value)) {}
 };
 
 class ScopedVariableTable {
 private:
-	std::string scopeName;
+	inline static std::atomic<uint64_t> tableCount{ 0 };
+
+	const char* scopeName; // a literal: calls create a table each, so naming it must not allocate
 	std::unordered_map<std::string, Variable*> symbols;
 
 public:
 	ScopedVariableTable* parent;
+	const uint64_t id; // unique for the lifetime of the process (unlike the table's address)
 
 public:
-	inline ScopedVariableTable(const std::string& scopeName, ScopedVariableTable* parent = nullptr): scopeName(scopeName), parent(parent) {
+	inline ScopedVariableTable(const char* scopeName, ScopedVariableTable* parent = nullptr): scopeName(scopeName), parent(parent), id(tableCount++) {
 	}
 
-	inline void set(const std::string& name, const Value& value) {
-		if(symbols.contains(name)) {
-			symbols[name]->value = value;
+	ScopedVariableTable(const ScopedVariableTable&) = delete;
+
+	inline ~ScopedVariableTable() {
+		for(const auto& [name, variable] : symbols)
+			delete variable;
+	}
+
+	// updates the variable in place if it already exists in this table, so Variable pointers stay valid for the table's lifetime
+	inline Variable* set(const std::string& name, Value value) {
+		BCC_STATS_COUNT(hashProbes);
+		const auto it = symbols.find(name);
+		if(it != symbols.end()) {
+			it->second->value = std::move(value);
+			return it->second;
 		}
 
 		Variable::Category category = static_cast<Variable::Category>(-1);
@@ -246,55 +95,201 @@ public:
 			category = Variable::Category::FLOAT;
 		if(value.is<std::string>())
 			category = Variable::Category::STRING;
-		symbols[name] = new Variable(category, name, value); // TODO: correct type
+		if(value.isArray())
+			category = Variable::Category::ARRAY;
+		if(value.isRecord())
+			category = Variable::Category::RECORD;
+		BCC_STATS_COUNT(variablesCreated);
+		return symbols[name] = new Variable(category, name, std::move(value)); // TODO: correct type
 	}
 
-	inline const Variable* lookup(const std::string& name) const {
-		for(const ScopedVariableTable* table = this; table != nullptr; table = table->parent)
-			if(table->symbols.contains(name))
-				return table->symbols.at(name);
+	inline Variable* lookup(const std::string& name) const {
+		BCC_STATS_COUNT(scopeLookups);
+		for(const ScopedVariableTable* table = this; table != nullptr; table = table->parent) {
+			BCC_STATS_COUNT(hashProbes);
+			const auto it = table->symbols.find(name);
+			if(it != table->symbols.end())
+				return it->second;
+		}
 		throw std::runtime_error("ScopedVariableTable::lookup(): Tried to lookup unknown symbol \"" + name + "\"");
 	}
 
 	inline void print(std::ostream& console, const std::string& indent) const {
-		console << indent << "<Variable Table \"" + scopeName + "\">:\n";
+		console << indent << "<Variable Table \"" << scopeName << "\">:\n";
 		for(const auto& [name, value] : symbols) {
 			console << indent << name << ": " << value->value.toString() << "\n";
 		}
-		console << indent << "</Variable Table \"" + scopeName + "\">\n\n";
+		console << indent << "</Variable Table \"" << scopeName << "\">\n\n";
 	}
 };
 
 
+// execution context of one run: all state that changes while executing (variables, return value, resolve cache, trace)
+// lives here, the AST is only read. Threads running the same CompiledProgram each use their own Interpreter.
 class Interpreter {
 private:
+	// per-node cache of the variable an identifier / assignment resolved to, valid while executing in the same scope
+	struct ResolvedVariable {
+		uint64_t scopeId;
+		Variable* variable;
+	};
+
+	struct Fork {}; // tag of the constructor for parallel tasks
+
+private:
+	std::shared_ptr<const CompiledProgram> program; // keeps the AST alive, empty when constructed from a bare AST
 	const AST::Node* ast;
 	ScopedVariableTable globalVariables;
 	Value returnValue;
+	std::vector<ResolvedVariable> resolved; // indexed by AST::Node::id(), grows on demand
+	Profiler* profiler; // optional, not owned
+	LineCounter* lineCounter; // optional, not owned
+	WorkStealingPool* pool; // optional, not owned
+	std::shared_ptr<const ParallelAnalysis> parallel; // shared with the forked contexts
+	uint64_t evaluations; // expression and statement nodes visited so far
+	uint64_t yieldInterval; // 0: never yields
+	uint64_t untilYield;
+	std::function<void()> onYield;
+	uint32_t callDepth; // script function calls in progress
+	uint32_t maxCallDepth; // 0: unlimited
+	std::function<void()> onCallDepthExceeded;
 
 private: // logging:
+	TraceMode traceMode;
+	TraceBuffer* traceBuffer; // TraceMode::BINARY only, not owned
 	std::string indent;
 	std::ostream& console;
 
 public:
-	inline Interpreter(const AST::Node* ast, std::ostream& console = std::cout): ast(ast), globalVariables("Global Scope"), returnValue(), console(console) {
+	inline Interpreter(const AST::Node* ast, std::ostream& console = std::cout): ast(ast), globalVariables("Global Scope"), returnValue(), resolved(), profiler(nullptr), lineCounter(nullptr), pool(nullptr), evaluations(0), yieldInterval(0), untilYield(0), callDepth(0), maxCallDepth(0), traceMode(TraceMode::TEXT), traceBuffer(nullptr), console(console) {
+	}
+
+	inline Interpreter(std::shared_ptr<const CompiledProgram> program_, std::ostream& console = std::cout): Interpreter(program_->ast(), console) {
+		program = std::move(program_);
+		resolved.assign(program->nodeCount(), { static_cast<uint64_t>(-1), nullptr });
+	}
+
+	inline const ScopedVariableTable& globals() const { return globalVariables; }
+
+	// function declared at the top level of the program. The handle stays valid as long as the AST and can be passed to call()
+	// on any Interpreter of the same program.
+	inline const AST::FunctionDeclarationStatement* function(const std::string& name) const {
+		const Symbol* symbol = ast->getScope().lookup(name);
+		if(!symbol || symbol->category != Symbol::Category::FUNCTION)
+			throw std::runtime_error("Interpreter::function(): \"" + name + "\" is not a global function");
+		return dynamic_cast<const AST::FunctionDeclarationStatement*>(std::get<const AST::Node*>(symbol->type));
+	}
+
+	// calls a script function from the host: the arguments are converted to the parameter types and the result to the
+	// return type (void functions return Value::Void()). The function sees the global variables as left by run(), which is
+	// not required and not repeated, and the call prints nothing, whatever the trace mode.
+	inline Value call(const AST::FunctionDeclarationStatement* function, const std::vector<Value>& args) {
+		if(args.size() != function->args.size())
+			throw std::runtime_error("Interpreter::call(): \"" + function->functionName + "\" takes " + std::to_string(function->args.size()) + " arguments, got " + std::to_string(args.size()));
+
+		ScopedVariableTable localScope("Local FunctionCall Scope", &globalVariables);
+		for(size_t i = 0; i < args.size(); i++)
+			localScope.set(function->args[i].name, args[i].as(function->args[i].type));
+
+		const TraceMode mode = traceMode;
+		if(mode == TraceMode::TEXT)
+			traceMode = TraceMode::NONE;
+
+		StatementResult out = StatementResult::Void();
+		try {
+			const CallFrame frame(*this);
+			const ProfilerFrame profile(profiler, function, function->functionName);
+			out = visit(&localScope, function->body);
+		} catch(...) {
+			traceMode = mode;
+			throw;
+		}
+		traceMode = mode;
+
+		if(function->typeName == "void")
+			return Value::Void();
+		if(out.type() != StatementResult::Type::RETURN)
+			throw std::runtime_error("Interpreter::call(): \"" + function->functionName + "\" ended without returning a value");
+		return returnValue.as(function->typeName);
+	}
+
+	inline Value call(const std::string& name, const std::vector<Value>& args) { return call(function(name), args); }
+
+	// typed host call, e.g. interpreter.call<float>("f", 5). R = Value returns the script value unconverted.
+	template<typename R = Value, typename... Args>
+	inline R call(const std::string& name, const Args&... args) {
+		const Value res = call(function(name), { Value(args)... });
+		if constexpr(std::is_same_v<R, Value>)
+			return res;
+		else if constexpr(!std::is_void_v<R>)
+			return res.template to<R>();
 	}
 
+	// evaluates independent side effect free operands (see ParallelAnalysis) as tasks on pool (nullptr disables it).
+	// Operands cheaper than threshold AST nodes stay serial, and so does everything while tracing, profiling or counting lines.
+	// Results and the reported error (the leftmost) are the same as in serial evaluation.
+	inline void setParallel(WorkStealingPool* pool_, const uint64_t threshold = 64) {
+		pool = pool_;
+		parallel = pool ? std::make_shared<const ParallelAnalysis>(ast, threshold) : nullptr;
+	}
+
+	// records function calls into profiler while running (nullptr disables profiling)
+	inline void setProfiler(Profiler* profiler_) { profiler = profiler_; }
+
+	// counts executed statements into lineCounter while running (nullptr disables counting)
+	inline void setLineCounter(LineCounter* lineCounter_) { lineCounter = lineCounter_; }
+
+	// TEXT traces to console (default), BINARY records events into buffer (see TraceDecoder), NONE disables tracing
+	inline void setTrace(const TraceMode mode, TraceBuffer* buffer = nullptr) {
+		if(mode == TraceMode::BINARY && !buffer)
+			throw std::runtime_error("Interpreter::setTrace(): binary tracing requires a TraceBuffer");
+		traceMode = mode;
+		traceBuffer = buffer;
+	}
+
+	// calls yield every interval node evaluations (0 disables it). yield may suspend the calling fiber (see Scheduler)
+	// or throw to abort the run.
+	inline void setYield(const uint64_t interval, std::function<void()> yield) {
+		yieldInterval = interval;
+		untilYield = interval;
+		onYield = std::move(yield);
+	}
+
+	inline uint64_t evaluationCount() const { return evaluations; }
+
+	// calls exceeded (which has to throw) instead of nesting more than depth script function calls, 0 disables the limit.
+	// Without exceeded a std::runtime_error is thrown. Every nested call takes a few KB of the native stack.
+	inline void setMaxCallDepth(const uint32_t depth, std::function<void()> exceeded = nullptr) {
+		maxCallDepth = depth;
+		onCallDepthExceeded = std::move(exceeded);
+	}
+
+	// runtime counters of the calling thread, all zero unless compiled with BCC_INTERPRETER_STATS
+	inline static InterpreterStats stats() { return InterpreterStats::local(); }
+	inline static void resetStats() { InterpreterStats::local() = InterpreterStats(); }
+
 	inline void run() {
-		switch(ast->baseType()) {
-		case AST::Node::BaseType::EXPRESSION:
-			visit(&globalVariables, dynamic_cast<const AST::ExpressionNode*>(ast));
-			break;
+		{
+			const ProfilerFrame profile(profiler, ast, "<global>");
+
+			switch(ast->baseType()) {
+			case AST::Node::BaseType::EXPRESSION:
+				visit(&globalVariables, dynamic_cast<const AST::ExpressionNode*>(ast));
+				break;
 
-		case AST::Node::BaseType::STATEMENT:
-			visit(&globalVariables, dynamic_cast<const AST::StatementNode*>(ast));
-			break;
+			case AST::Node::BaseType::STATEMENT:
+				visit(&globalVariables, dynamic_cast<const AST::StatementNode*>(ast));
+				break;
+			}
 		}
 
-		globalVariables.print(console, indent);
+		if(traceMode == TraceMode::TEXT)
+			globalVariables.print(console, indent);
 	}
 
 	inline Value visit(ScopedVariableTable* scope, const AST::ExpressionNode* node) {
+		tick();
+
 		switch(node->type()) {
 			case AST::ExpressionNode::Type::LITERAL_EXPRESSION:
 				return visitLiteralExpression(scope, dynamic_cast<const AST::LiteralNode*>(node));
@@ -306,12 +301,33 @@ public:
 				return visitBinaryExpression(scope, dynamic_cast<const AST::BinaryExpressionNode*>(node));
 			case AST::ExpressionNode::Type::CALL_EXPRESSION:
 				return visitFunctionCall(scope, dynamic_cast<const AST::FunctionCallExpressionNode*>(node));
+			case AST::ExpressionNode::Type::INLINED_CALL_EXPRESSION:
+				return visitInlinedCall(scope, dynamic_cast<const AST::InlinedCallExpressionNode*>(node));
+			case AST::ExpressionNode::Type::BUILTIN_CALL_EXPRESSION:
+				return visitBuiltinCall(scope, dynamic_cast<const AST::BuiltinCallExpressionNode*>(node));
+			case AST::ExpressionNode::Type::ARRAY_EXPRESSION:
+				return visitArrayExpression(scope, dynamic_cast<const AST::ArrayExpressionNode*>(node));
+			case AST::ExpressionNode::Type::INDEX_EXPRESSION:
+				return visitIndexExpression(scope, dynamic_cast<const AST::IndexExpressionNode*>(node));
+			case AST::ExpressionNode::Type::LENGTH_EXPRESSION:
+				return visitLengthExpression(scope, dynamic_cast<const AST::LengthExpressionNode*>(node));
+			case AST::ExpressionNode::Type::RECORD_EXPRESSION:
+				return visitRecordExpression(scope, dynamic_cast<const AST::RecordExpressionNode*>(node));
+			case AST::ExpressionNode::Type::FIELD_EXPRESSION:
+				return visitFieldExpression(scope, dynamic_cast<const AST::FieldExpressionNode*>(node));
+			case AST::ExpressionNode::Type::CONCAT_EXPRESSION:
+				return visitConcatExpression(scope, dynamic_cast<const AST::ConcatExpressionNode*>(node));
 		}
 
 		throw std::runtime_error("Interpreter::visit(ExpressionNode): invalid expression Node type");
 	}
 
 	inline StatementResult visit(ScopedVariableTable* scope, const AST::StatementNode* node) {
+		tick();
+
+		if(lineCounter && node->type() != AST::StatementNode::Type::STATEMENT_LIST) // blocks are counted through their statements
+			lineCounter->hit(node);
+
 		switch(node->type()) {
 			case AST::StatementNode::Type::EXPRESSION_STATEMENT:
 				return visitExpressionStatement(scope, dynamic_cast<const AST::ExpressionStatement*>(node));
@@ -324,17 +340,168 @@ public:
 				return visitIfStatement(scope, dynamic_cast<const AST::IfStatement*>(node));
 			case AST::StatementNode::Type::WHILE_STATEMENT:
 				return visitWhileStatement(scope, dynamic_cast<const AST::WhileStatement*>(node));
+			case AST::StatementNode::Type::FOR_STATEMENT:
+				return visitForStatement(scope, dynamic_cast<const AST::ForStatement*>(node));
+			case AST::StatementNode::Type::COUNTED_FOR_STATEMENT:
+				return visitCountedForStatement(scope, dynamic_cast<const AST::CountedForStatement*>(node));
+			case AST::StatementNode::Type::SWITCH_STATEMENT:
+				return visitSwitchStatement(scope, dynamic_cast<const AST::SwitchStatement*>(node));
+			case AST::StatementNode::Type::BREAK_STATEMENT:
+				return visitBreakStatement(scope, dynamic_cast<const AST::BreakStatement*>(node));
+			case AST::StatementNode::Type::CONTINUE_STATEMENT:
+				return visitContinueStatement(scope, dynamic_cast<const AST::ContinueStatement*>(node));
 			case AST::StatementNode::Type::FUNCTION_DECLARATION_STATEMENT:
 				return visitFunctionDeclaration(scope, dynamic_cast<const AST::FunctionDeclarationStatement*>(node));
 			case AST::StatementNode::Type::VARIABLE_DECLARATION_STATEMENT:
 				return visitVariableDeclaration(scope, dynamic_cast<const AST::VariableDeclarationStatement*>(node));
 			case AST::StatementNode::Type::VARIABLE_ASSIGNMENT_STATEMENT:
 				return visitVariableAssignment(scope, dynamic_cast<const AST::VariableAssignmentStatement*>(node));
+			case AST::StatementNode::Type::ELEMENT_ASSIGNMENT_STATEMENT:
+				return visitElementAssignment(scope, dynamic_cast<const AST::ElementAssignmentStatement*>(node));
+			case AST::StatementNode::Type::FIELD_ASSIGNMENT_STATEMENT:
+				return visitFieldAssignment(scope, dynamic_cast<const AST::FieldAssignmentStatement*>(node));
+			case AST::StatementNode::Type::STRUCT_DECLARATION_STATEMENT:
+				return visitStructDeclaration(scope, dynamic_cast<const AST::StructDeclarationStatement*>(node));
 		}
 
 		throw std::runtime_error("Interpreter::visit(StatementNode): invalid statement Node type");
 	}
 
+	inline void traceEnter(const AST::Node* node) {
+		if(traceMode == TraceMode::BINARY) {
+			traceBuffer->push(TraceEvent::Kind::ENTER, node);
+		} else if(traceMode == TraceMode::TEXT) {
+			TraceFormat::write(console, indent, TraceEvent::Kind::ENTER, node, "");
+			indent += "  ";
+		}
+	}
+
+	inline void traceExit(const AST::Node* node, const Value& value = Value()) {
+		if(traceMode == TraceMode::BINARY) {
+			traceBuffer->push(TraceEvent::Kind::EXIT, node, value);
+		} else if(traceMode == TraceMode::TEXT) {
+			indent.resize(indent.size() - 2);
+			TraceFormat::write(console, indent, TraceEvent::Kind::EXIT, node, value.isEmpty() ? "" : value.toString());
+		}
+	}
+
+	inline void traceLeaf(const AST::Node* node, const Value& value = Value()) {
+		if(traceMode == TraceMode::BINARY)
+			traceBuffer->push(TraceEvent::Kind::LEAF, node, value);
+		else if(traceMode == TraceMode::TEXT)
+			TraceFormat::write(console, indent, TraceEvent::Kind::LEAF, node, value.isEmpty() ? "" : value.toString());
+	}
+
+	// context of a parallel task: shares the AST and the parallel setup, never traces.
+	// The resolve cache starts empty and only grows to the nodes the task evaluates
+	inline Interpreter(const Interpreter& parent, Fork): program(parent.program), ast(parent.ast), globalVariables("Fork Scope"), returnValue(), resolved(), profiler(nullptr), lineCounter(nullptr), pool(parent.pool), parallel(parent.parallel), evaluations(0), yieldInterval(0), untilYield(0), callDepth(parent.callDepth), maxCallDepth(parent.maxCallDepth), onCallDepthExceeded(parent.onCallDepthExceeded), traceMode(TraceMode::NONE), traceBuffer(nullptr), console(parent.console) {
+	}
+
+	// one level of script call nesting, for as long as the call runs or until it throws
+	class CallFrame {
+	private:
+		Interpreter& interpreter;
+
+	public:
+		inline CallFrame(Interpreter& interpreter): interpreter(interpreter) {
+			if(interpreter.maxCallDepth && interpreter.callDepth >= interpreter.maxCallDepth) {
+				if(interpreter.onCallDepthExceeded)
+					interpreter.onCallDepthExceeded();
+				throw std::runtime_error("Interpreter: exceeded " + std::to_string(interpreter.maxCallDepth) + " nested calls");
+			}
+			interpreter.callDepth++;
+		}
+		inline ~CallFrame() { interpreter.callDepth--; }
+		CallFrame(const CallFrame&) = delete;
+	};
+
+	// profiler enter() / exit() around a call, also when it throws, so later calls are not recorded below it
+	class ProfilerFrame {
+	private:
+		Profiler* profiler; // nullptr: not profiling
+
+	public:
+		inline ProfilerFrame(Profiler* profiler, const void* key, const std::string& name): profiler(profiler) {
+			if(profiler) profiler->enter(key, name);
+		}
+		inline ~ProfilerFrame() { if(profiler) profiler->exit(); }
+		ProfilerFrame(const ProfilerFrame&) = delete;
+	};
+
+	inline void tick() {
+		evaluations++;
+		if(yieldInterval && --untilYield == 0) {
+			untilYield = yieldInterval;
+			onYield();
+		}
+	}
+
+	inline bool canFork(const AST::Node* node) const {
+		return pool && parallel->isParallel(node) && traceMode == TraceMode::NONE && !profiler && !lineCounter
+			&& pool->pendingCount() < pool->threadCount(); // enough queued work to keep the pool busy
+	}
+
+	// evaluates expressions[0 .. n-2] as tasks with their own contexts and the last one in this thread
+	inline void evaluateParallel(ScopedVariableTable* scope, const AST::ExpressionNode* const* expressions, Value* out, const size_t n) {
+		std::vector<std::unique_ptr<Interpreter>> forks;
+		std::vector<std::unique_ptr<WorkStealingPool::Task>> tasks;
+		for(size_t i = 0; i + 1 < n; i++) {
+			Interpreter* fork = forks.emplace_back(new Interpreter(*this, Fork())).get();
+			tasks.emplace_back(new WorkStealingPool::Task([=] { out[i] = fork->visit(scope, expressions[i]); }));
+			pool->fork(tasks.back().get());
+		}
+
+		std::vector<std::exception_ptr> errors(n);
+		try {
+			out[n - 1] = visit(scope, expressions[n - 1]);
+		} catch(...) {
+			errors[n - 1] = std::current_exception();
+		}
+
+		for(size_t i = 0; i + 1 < n; i++) { // every task has to finish before its context goes out of scope
+			try {
+				pool->join(tasks[i].get());
+			} catch(...) {
+				errors[i] = std::current_exception();
+			}
+		}
+
+		for(const std::exception_ptr& error : errors)
+			if(error)
+				std::rethrow_exception(error);
+	}
+
+	inline ResolvedVariable& cached(const AST::Node* node) {
+		if(node->id() >= resolved.size()) // forks start empty, bare ASTs are not required to be numbered
+			resolved.resize(std::max<size_t>(node->id() + 1, 2 * resolved.size()), { static_cast<uint64_t>(-1), nullptr });
+		return resolved[node->id()];
+	}
+
+	// loop bodies run repeatedly in the same scope, so after the first iteration names are not looked up again
+	inline Variable* resolve(ScopedVariableTable* scope, const AST::Node* node, const std::string& name) {
+		ResolvedVariable& entry = cached(node);
+		if(entry.scopeId != scope->id) {
+			entry.variable = scope->lookup(name);
+			entry.scopeId = scope->id;
+		}
+		return entry.variable;
+	}
+
+	inline void assign(ScopedVariableTable* scope, const AST::Node* node, const std::string& name, Value value) {
+		resolve(scope, node, name)->value = std::move(value);
+	}
+
+	// declarations always create (or reuse) the variable in the current scope
+	inline void declare(ScopedVariableTable* scope, const AST::Node* node, const std::string& name, Value value) {
+		ResolvedVariable& entry = cached(node);
+		if(entry.scopeId == scope->id) {
+			entry.variable->value = std::move(value);
+			return;
+		}
+		entry.variable = scope->set(name, std::move(value));
+		entry.scopeId = scope->id;
+	}
+
 	Value visitLiteralExpression(ScopedVariableTable* scope, const AST::LiteralNode* node) {
 		Value out;
 
@@ -349,28 +516,28 @@ public:
 				out = Value(dynamic_cast<const AST::FloatLiteralNode*>(node)->value);
 				break;
 			case AST::LiteralNode::LiteralType::STRING:
-				out = Value(dynamic_cast<const AST::StringLiteralNode*>(node)->value);
+				out = Value(dynamic_cast<const AST::StringLiteralNode*>(node)->shared);
 				break;
 		}
 
 		if(out.isEmpty())
 			throw std::runtime_error("Interpreter::visitLiteralExpression: Unknown Literal Type");
 
-		console << indent << "<LiteralExpression " << out.toString() << "/> => " << out.toString() << "\n";
+		traceLeaf(node, out);
 
 		return out;
 	}
 
 	Value visitVariableExpression(ScopedVariableTable* scope, const AST::IdentifierNode* node) {
-		const Value ret = scope->lookup(node->name)->value;
+		const Value ret = resolve(scope, node, node->name)->value;
 
-		console << indent << "<VariableExpression \"" + node->name + "\"/> => " << ret.toString() << "\n";
+		traceLeaf(node, ret);
 
 		return ret;
 	}
 
 	Value visitUnaryExpression(ScopedVariableTable* scope, const AST::UnaryExpressionNode* node) {
-		console << indent << "<UnaryExpression " << node->opString() << ">:\n";
+		traceEnter(node);
 		
 		Value res;
 		
@@ -388,19 +555,26 @@ public:
 		if(res.isEmpty())
 			throw std::runtime_error("Interpreter::visitUnaryExpression: Invalid type or operator in Unary Expression");
 		
-		console << indent << "</UnaryExpression> => " << res.toString() << "\n";
+		traceExit(node, res);
 
 		return res;
 	}
 
 	Value visitBinaryExpression(ScopedVariableTable* scope, const AST::BinaryExpressionNode* node) {
-		console << indent << "<BinaryExpression " + node->opString() + ">:\n";
-
-		indent += "  ";
-
-		const Value va = visit(scope, node->a);
-
-		const Value vb = visit(scope, node->b);
+		traceEnter(node);
+
+		Value va, vb;
+
+		if(canFork(node)) {
+			const AST::ExpressionNode* operands[] = { node->a, node->b };
+			Value values[2];
+			evaluateParallel(scope, operands, values, 2);
+			va = std::move(values[0]);
+			vb = std::move(values[1]);
+		} else {
+			va = visit(scope, node->a);
+			vb = visit(scope, node->b);
+		}
 
 		const std::string& evalType = node->evalType().type();
 
@@ -442,18 +616,40 @@ public:
 				+ node->b->evalType().type()
 				+ " -> " + evalType);
 
-		indent = indent.substr(0, indent.size() - 2);
-
-		console << indent << "</BinaryExpression> => " << res.toString() << "\n";
+		traceExit(node, res);
 
 		return res;
 	}
 
-	Value visitFunctionCall(ScopedVariableTable* scope, const AST::FunctionCallExpressionNode* node) {
-		ScopedVariableTable* localScope = new ScopedVariableTable("Local FunctionCall Scope", scope);
-		console << indent << "<FunctionCall \"" + node->name + "\">:\n";
+	Value visitConcatExpression(ScopedVariableTable* scope, const AST::ConcatExpressionNode* node) {
+		traceEnter(node);
+
+		// all parts are evaluated first, so the result is allocated once. Strings are appended from the shared
+		// characters, numbers are formatted straight into the result.
+		std::vector<Value> parts;
+		parts.reserve(node->parts.size());
+		size_t size = 0;
+		for(const AST::ExpressionNode* part : node->parts) {
+			parts.push_back(visit(scope, part));
+			size += parts.back().is<std::string>() ? parts.back().get<std::string>().size() : NumberFormat::maxChars;
+		}
+
+		std::string res;
+		res.reserve(size);
+		for(const Value& part : parts)
+			part.appendTo(res);
+
+		const Value ret(std::move(res));
+
+		traceExit(node, ret);
+
+		return ret;
+	}
 
-		indent += "  ";
+	Value visitFunctionCall(ScopedVariableTable* scope, const AST::FunctionCallExpressionNode* node) {
+		ScopedVariableTable localScope("Local FunctionCall Scope", scope);
+		traceEnter(node);
+		BCC_STATS_COUNT(functionCalls);
 
 		const AST::FunctionDeclarationStatement* targetFunction =
 			dynamic_cast<const AST::FunctionDeclarationStatement*>(
@@ -462,46 +658,210 @@ public:
 				)
 			);
 
-		for(size_t i = 0; i < node->args.size(); i++) {
-			const AST::FunctionDeclarationStatement::Argument& param = targetFunction->args[i];
-			// const std::string& paramType = param.type;
-			const std::string& paramName = param.name;
-			const Value val = visit(scope, node->args[i]);
-			localScope->set(paramName, val);
+		if(canFork(node)) {
+			std::vector<Value> values(node->args.size());
+			evaluateParallel(scope, node->args.data(), values.data(), values.size());
+			for(size_t i = 0; i < values.size(); i++)
+				localScope.set(targetFunction->args[i].name, std::move(values[i]));
+		} else {
+			for(size_t i = 0; i < node->args.size(); i++) {
+				const AST::FunctionDeclarationStatement::Argument& param = targetFunction->args[i];
+				// const std::string& paramType = param.type;
+				const std::string& paramName = param.name;
+				localScope.set(paramName, visit(scope, node->args[i]));
+			}
 		}
 
-		const StatementResult out = visit(localScope, targetFunction->body); // TODO: fix warning and rethink
-		(void)out;
+		{
+			const CallFrame frame(*this); // arguments are evaluated in the caller
+			const ProfilerFrame profile(profiler, targetFunction, node->name);
 
-		indent = indent.substr(0, indent.size() - 2);
+			const StatementResult out = visit(&localScope, targetFunction->body); // TODO: fix warning and rethink
+			(void)out;
+		}
 
-		console << indent << "</FunctionCall> => " << returnValue.toString() << "\n";
+		traceExit(node, returnValue);
 
-		localScope->print(console, indent);
+		if(traceMode == TraceMode::TEXT)
+			localScope.print(console, indent);
 
-		return returnValue;
+		return std::exchange(returnValue, Value()); // moved out, the next return statement overwrites it anyway
 	}
 
+	Value visitInlinedCall(ScopedVariableTable* scope, const AST::InlinedCallExpressionNode* node) {
+		traceEnter(node);
+		BCC_STATS_COUNT(inlinedCalls);
 
-	// Stetements:
-	StatementResult visitExpressionStatement(ScopedVariableTable* scope, const AST::ExpressionStatement* node) {
-		console << indent << "<StatementList>\n";
+		// the callee locals live and die with the call, like those of a real call. The Inliner renamed them, so they
+		// can not hide the caller's variables the body reads
+		ScopedVariableTable localScope("Local InlinedCall Scope", scope);
+		for(const AST::VariableDeclarationStatement* binding : node->bindings)
+			visit(&localScope, binding);
+
+		Value ret;
+		{
+			const CallFrame frame(*this); // counts like the call it replaced
+			const ProfilerFrame profile(profiler, node->function, node->name); // keeps inlined functions visible in profiles
+
+			const StatementResult out = visit(&localScope, node->body);
+			ret = out.type() == StatementResult::Type::RETURN ? std::exchange(returnValue, Value()) : Value::Void();
+		}
+
+		traceExit(node, ret);
+
+		if(traceMode == TraceMode::TEXT)
+			localScope.print(console, indent);
+
+		return ret;
+	}
+
+
+	Value visitBuiltinCall(ScopedVariableTable* scope, const AST::BuiltinCallExpressionNode* node) {
+		traceEnter(node);
+		BCC_STATS_COUNT(builtinCalls);
+
+		Value args[Builtin::maxArgs]; // no script scope, the arguments are passed by position
+		for(size_t i = 0; i < node->args.size(); i++)
+			args[i] = visit(scope, node->args[i]);
 
-		indent += "  ";
+		const Value ret = node->builtin->function(args);
 
-		visit(scope, node);
+		traceExit(node, ret);
 
-		indent = indent.substr(0, indent.size() - 2);
+		return ret;
+	}
+
+	Value visitArrayExpression(ScopedVariableTable* scope, const AST::ArrayExpressionNode* node) {
+		traceEnter(node);
+
+		Value ret;
+		if(node->elementType == "bool")
+			ret = makeArray<bool>(scope, node);
+		else if(node->elementType == "int")
+			ret = makeArray<int>(scope, node);
+		else if(node->elementType == "float")
+			ret = makeArray<float>(scope, node);
+		else
+			throw std::runtime_error("Interpreter::visitArrayExpression(): invalid element type \"" + node->elementType + "\"");
+
+		traceExit(node, ret);
+
+		return ret;
+	}
+
+	template<typename T>
+	inline ArrayRef<T> makeArray(ScopedVariableTable* scope, const AST::ArrayExpressionNode* node) {
+		if(!node->length) {
+			const ArrayRef<T> array = std::make_shared<Array<T>>(node->elements.size());
+			for(size_t i = 0; i < node->elements.size(); i++)
+				array->data[i] = visit(scope, node->elements[i]).template to<T>();
+			return array;
+		}
+
+		const int length = visit(scope, node->length).to<int>();
+		if(length < 0)
+			throw std::runtime_error("Interpreter: negative array length " + std::to_string(length));
+		return std::make_shared<Array<T>>(static_cast<size_t>(length));
+	}
+
+	Value visitIndexExpression(ScopedVariableTable* scope, const AST::IndexExpressionNode* node) {
+		traceEnter(node);
+
+		const Value array = visit(scope, node->array);
+		const int index = visit(scope, node->index).to<int>();
+
+		Value ret;
+		if(const ArrayRef<bool>* a = array.getIf<ArrayRef<bool>>())
+			ret = element(**a, index, node->checked);
+		else if(const ArrayRef<int>* a = array.getIf<ArrayRef<int>>())
+			ret = element(**a, index, node->checked);
+		else if(const ArrayRef<float>* a = array.getIf<ArrayRef<float>>())
+			ret = element(**a, index, node->checked);
+		else
+			throw std::runtime_error("Interpreter::visitIndexExpression(): " + array.toString() + " is not an array");
+
+		traceExit(node, ret);
+
+		return ret;
+	}
+
+	// unchecked accesses were proven in bounds by the SemanticAnalyzer
+	template<typename T>
+	inline static T& element(Array<T>& array, const int index, const bool checked) {
+		if(checked && (index < 0 || static_cast<size_t>(index) >= array.size))
+			throw std::runtime_error("Interpreter: index " + std::to_string(index) + " out of bounds for array of length " + std::to_string(array.size));
+		return array.data[index];
+	}
+
+	Value visitLengthExpression(ScopedVariableTable* scope, const AST::LengthExpressionNode* node) {
+		traceEnter(node);
+
+		const Value ret(static_cast<int>(visit(scope, node->array).length()));
+
+		traceExit(node, ret);
+
+		return ret;
+	}
+
+	Value visitRecordExpression(ScopedVariableTable* scope, const AST::RecordExpressionNode* node) {
+		traceEnter(node);
+
+		const Value ret(std::make_shared<Record>(&node->declaration->layout));
+
+		traceExit(node, ret);
+
+		return ret;
+	}
+
+	Value visitFieldExpression(ScopedVariableTable* scope, const AST::FieldExpressionNode* node) {
+		traceEnter(node);
+
+		// a variable is read in place: copying the record reference would cost two atomic reference count updates
+		Value object;
+		const Value* value = &object;
+		if(const AST::IdentifierNode* id = dynamic_cast<const AST::IdentifierNode*>(node->object)) {
+			tick();
+			value = &resolve(scope, id, id->name)->value;
+			traceLeaf(id, *value);
+		} else {
+			object = visit(scope, node->object);
+		}
+		const Record& r = record(*value, node->declaration);
+
+		Value ret;
+		switch(node->fieldType) {
+			case StructLayout::FieldType::BOOL: ret = r.load<bool>(node->offset); break;
+			case StructLayout::FieldType::INT: ret = r.load<int>(node->offset); break;
+			case StructLayout::FieldType::FLOAT: ret = r.load<float>(node->offset); break;
+		}
+
+		traceExit(node, ret);
+
+		return ret;
+	}
+
+	// the offsets of a field access are only valid for the struct it was resolved against
+	inline static Record& record(const Value& value, const AST::StructDeclarationStatement* declaration) {
+		const RecordRef* r = value.getIf<RecordRef>();
+		if(!r || (*r)->layout != &declaration->layout)
+			throw std::runtime_error("Interpreter: " + value.toString() + " is not a " + declaration->layout.name);
+		return **r;
+	}
 
-		console << indent << "</StatementList>\n";
+
+	// Stetements:
+	StatementResult visitExpressionStatement(ScopedVariableTable* scope, const AST::ExpressionStatement* node) {
+		traceEnter(node);
+
+		visit(scope, node->expr);
+
+		traceExit(node);
 
 		return StatementResult::Void();
 	}
 
 	StatementResult visitStatementList(ScopedVariableTable* scope, const AST::StatementList* node) {
-		console << indent << "<StatementList>\n";
-	
-		indent += "  ";
+		traceEnter(node);
 
 		StatementResult out = StatementResult::Void();
 
@@ -511,24 +871,18 @@ public:
 			if(out.type() != StatementResult::Type::VOID) break; // found return, break or continue statement // TODO: fix
 		}
 		
-		indent = indent.substr(0, indent.size() - 2);
-
-		console << indent << "</StatementList>\n";
+		traceExit(node);
 
 		return out;
 	}
 
 	StatementResult visitReturnStatement(ScopedVariableTable* scope, const AST::ReturnStatement* node) {
-		console << indent << "<ReturnStatement>\n";
-
-		indent += "  ";
+		traceEnter(node);
 
 		returnValue = visit(scope, node->expr);
 		// const Value out = visit(scope, node->expr);
 
-		indent = indent.substr(0, indent.size() - 2);
-
-		console << indent << "</ReturnStatement>\n";
+		traceExit(node);
 
 		// return out;
 		return StatementResult::Return();
@@ -537,9 +891,7 @@ public:
 
 
 	StatementResult visitIfStatement(ScopedVariableTable* scope, const AST::IfStatement* node) {
-		console << indent << "<IfStatement>\n";
-
-		indent += "  ";
+		traceEnter(node);
 
 		const Value cond = visit(scope, node->condition);
 
@@ -548,65 +900,225 @@ public:
 
 		StatementResult res = StatementResult::Void();
 
-		if(cond.to<bool>()) {
-			ScopedVariableTable* localScope = new ScopedVariableTable("Local IfStatement Scope", scope);
+		if(cond.to<bool>())
+			res = visit(scope, node->body); // the body shares the enclosing symbol scope, so it shares the variable scope as well
+
+		traceExit(node);
+
+		return res; // TODO: fix
+	}
+
+	StatementResult visitWhileStatement(ScopedVariableTable* scope, const AST::WhileStatement* node) {
+		traceEnter(node);
+
+		StatementResult res = StatementResult::Void();
+
+		// the body shares the enclosing scope: no scope is allocated per iteration and resolved names stay cached
+		for(;;) {
+			const Value cond = visit(scope, node->condition);
+
+			if(!cond.isConvertibleToBool())
+				throw std::runtime_error("Interpreter::visitWhileStatement: condition not convertible to bool");
+
+			if(!cond.to<bool>())
+				break;
+
+			const StatementResult out = visit(scope, node->body);
+
+			if(out.type() == StatementResult::Type::BREAK)
+				break;
+
+			if(out.type() == StatementResult::Type::RETURN) {
+				res = out;
+				break;
+			}
+		}
+
+		traceExit(node);
+
+		return res;
+	}
+
+	StatementResult visitForStatement(ScopedVariableTable* scope, const AST::ForStatement* node) {
+		traceEnter(node);
+
+		ScopedVariableTable localScope("Local ForStatement Scope", scope); // one scope per loop, not per iteration
+
+		if(node->init)
+			visit(&localScope, node->init);
+
+		StatementResult res = StatementResult::Void();
+
+		for(;;) {
+			if(node->condition) {
+				const Value cond = visit(&localScope, node->condition);
+
+				if(!cond.isConvertibleToBool())
+					throw std::runtime_error("Interpreter::visitForStatement: condition not convertible to bool");
+
+				if(!cond.to<bool>())
+					break;
+			}
+
+			const StatementResult out = visit(&localScope, node->body);
+
+			if(out.type() == StatementResult::Type::BREAK)
+				break;
+
+			if(out.type() == StatementResult::Type::RETURN) {
+				res = out;
+				break;
+			}
 
-			res = visit(localScope, node->body);
+			if(node->step)
+				visit(&localScope, node->step);
 		}
 
-		indent = indent.substr(0, indent.size() - 2);
+		traceExit(node);
 
-		console << indent << "</IfStatement>\n";
+		return res;
+	}
 
-		return res; // TODO: fix
+	StatementResult visitCountedForStatement(ScopedVariableTable* scope, const AST::CountedForStatement* node) {
+		traceEnter(node);
+
+		ScopedVariableTable localScope("Local ForStatement Scope", scope);
+
+		// the induction variable lives in a native counter, the script variable is only written for the body to read
+		const int64_t start = visit(&localScope, node->init->initialAssignment->expr).to<int>();
+		int64_t bound = visit(&localScope, node->bound).to<int>();
+		Variable* counter = localScope.set(node->init->varName, Value(static_cast<int>(start)));
+
+		StatementResult res = StatementResult::Void();
+
+		for(int64_t i = start; node->inclusive ? i <= bound : i < bound; i += node->stride) {
+			counter->value = Value(static_cast<int>(i));
+
+			const StatementResult out = visit(&localScope, node->body);
+
+			if(out.type() == StatementResult::Type::BREAK)
+				break;
+
+			if(out.type() == StatementResult::Type::RETURN) {
+				res = out;
+				break;
+			}
+
+			if(!node->boundInvariant)
+				bound = visit(&localScope, node->bound).to<int>();
+		}
+
+		traceExit(node);
+
+		return res;
 	}
 
-	StatementResult visitWhileStatement(ScopedVariableTable* scope, const AST::WhileStatement* node) {
-		console << indent << "<WhileStatement>\n";
+	StatementResult visitSwitchStatement(ScopedVariableTable* scope, const AST::SwitchStatement* node) {
+		traceEnter(node);
+
+		const Value value = visit(scope, node->value);
+
+		if(!value.is<int>())
+			throw std::runtime_error("Interpreter::visitSwitchStatement: switch value is not an int");
+
+		StatementResult res = StatementResult::Void();
+
+		// jump to the matching case and fall through the following statements until a break
+		for(size_t i = node->target(value.get<int>()); i < node->statements.size(); i++) {
+			const StatementResult out = visit(scope, node->statements[i]);
 
-		indent += "  ";
+			if(out.type() == StatementResult::Type::BREAK)
+				break;
+
+			if(out.type() != StatementResult::Type::VOID) { // return, or continue of an enclosing loop
+				res = out;
+				break;
+			}
+		}
+
+		traceExit(node);
+
+		return res;
+	}
 
-		// visit(scope, node->expr); // TODO: implement
+	StatementResult visitBreakStatement(ScopedVariableTable* scope, const AST::BreakStatement* node) {
+		traceLeaf(node);
 
-		indent = indent.substr(0, indent.size() - 2);
+		return StatementResult::Break();
+	}
 
-		console << indent << "</WhileStatement>\n";
+	StatementResult visitContinueStatement(ScopedVariableTable* scope, const AST::ContinueStatement* node) {
+		traceLeaf(node);
 
-		return StatementResult::Void(); // TODO: fix
+		return StatementResult::Continue();
 	}
 
 	StatementResult visitFunctionDeclaration(ScopedVariableTable* scope, const AST::FunctionDeclarationStatement* node) {
-		console << indent << "<FunctionDeclaration/> (skipping)\n";
+		traceLeaf(node);
 
 		return StatementResult::Void();
 	}
 
-	StatementResult visitVariableDeclaration(ScopedVariableTable* scope, const AST::VariableDeclarationStatement* node) {
-		console << indent << "<VariableDeclaration>\n";
+	StatementResult visitStructDeclaration(ScopedVariableTable* scope, const AST::StructDeclarationStatement* node) {
+		traceLeaf(node);
 
-		indent += "  ";
+		return StatementResult::Void();
+	}
 
-		if(node->initialAssignment)
-			visit(scope, node->initialAssignment);
+	StatementResult visitVariableDeclaration(ScopedVariableTable* scope, const AST::VariableDeclarationStatement* node) {
+		traceEnter(node);
 
-		indent = indent.substr(0, indent.size() - 2);
+		declare(scope, node, node->varName, node->initialAssignment ? visit(scope, node->initialAssignment->expr) : Value::defaultOf(node->typeName));
 
-		console << indent << "</VariableDeclaration>\n";
+		traceExit(node);
 
 		return StatementResult::Void();
 	}
 
 	StatementResult visitVariableAssignment(ScopedVariableTable* scope, const AST::VariableAssignmentStatement* node) {
-		console << indent << "<VariableAssignment \"" + node->varName + "\">\n";
+		traceEnter(node);
+
+		assign(scope, node, node->varName, visit(scope, node->expr));
+
+		traceExit(node);
+
+		return StatementResult::Void();
+	}
+
+	StatementResult visitElementAssignment(ScopedVariableTable* scope, const AST::ElementAssignmentStatement* node) {
+		traceEnter(node);
+
+		const int index = visit(scope, node->index).to<int>();
+		const Value val = visit(scope, node->expr);
+		const Value& array = resolve(scope, node, node->varName)->value;
 
-		indent += "  ";
+		if(const ArrayRef<bool>* a = array.getIf<ArrayRef<bool>>())
+			element(**a, index, node->checked) = val.to<bool>();
+		else if(const ArrayRef<int>* a = array.getIf<ArrayRef<int>>())
+			element(**a, index, node->checked) = val.to<int>();
+		else if(const ArrayRef<float>* a = array.getIf<ArrayRef<float>>())
+			element(**a, index, node->checked) = val.to<float>();
+		else
+			throw std::runtime_error("Interpreter::visitElementAssignment(): \"" + node->varName + "\" is not an array");
 
-		Value val = visit(scope, node->expr);
-		scope->set(node->varName, val);
+		traceExit(node);
 
-		indent = indent.substr(0, indent.size() - 2);
+		return StatementResult::Void();
+	}
+
+	StatementResult visitFieldAssignment(ScopedVariableTable* scope, const AST::FieldAssignmentStatement* node) {
+		traceEnter(node);
+
+		const Value val = visit(scope, node->expr);
+		Record& r = record(resolve(scope, node, node->varName)->value, node->declaration);
+
+		switch(node->fieldType) {
+			case StructLayout::FieldType::BOOL: r.store(node->offset, val.to<bool>()); break;
+			case StructLayout::FieldType::INT: r.store(node->offset, val.to<int>()); break;
+			case StructLayout::FieldType::FLOAT: r.store(node->offset, val.to<float>()); break;
+		}
 
-		console << indent << "</VariableAssignment>\n";
+		traceExit(node);
 
 		return StatementResult::Void();
 	}
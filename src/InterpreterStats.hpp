@@ -0,0 +1,59 @@
+#pragma once
+
+
+#include <ostream>
+#include <cstdint>
+#include <iomanip>
+
+
+// runtime event counters of the Interpreter, compiled in with BCC_INTERPRETER_STATS (see Interpreter::stats()).
+// Counters are per thread: Values and variable tables count without knowing which Interpreter they belong to.
+struct InterpreterStats {
+#ifdef BCC_INTERPRETER_STATS
+	static constexpr bool enabled = true;
+#else
+	static constexpr bool enabled = false;
+#endif
+
+	uint64_t scopeLookups = 0; // ScopedVariableTable::lookup() calls
+	uint64_t hashProbes = 0; // variable table hash map lookups (every table of a lookup() chain, set())
+	uint64_t variablesCreated = 0;
+	uint64_t valueCopies = 0;
+	uint64_t stringAllocations = 0; // string Values with new characters (operator, conversion and builtin results), copies share them
+	uint64_t valueOperations = 0; // Value arithmetic / comparison operators
+	uint64_t functionCalls = 0;
+	uint64_t inlinedCalls = 0;
+	uint64_t builtinCalls = 0;
+
+	inline static InterpreterStats& local() {
+		static thread_local InterpreterStats stats;
+		return stats;
+	}
+
+	inline void print(std::ostream& console) const {
+		const auto row = [&](const char* name, const uint64_t value) {
+			console << "  " << std::setw(20) << std::left << name << std::setw(12) << std::right << value << "\n";
+		};
+
+		console << "Interpreter Stats:\n";
+		if(!enabled) {
+			console << "  (disabled, compile with BCC_INTERPRETER_STATS)\n";
+			return;
+		}
+		row("scope lookups", scopeLookups);
+		row("hash probes", hashProbes);
+		row("variables created", variablesCreated);
+		row("value copies", valueCopies);
+		row("string allocations", stringAllocations);
+		row("value operations", valueOperations);
+		row("function calls", functionCalls);
+		row("inlined calls", inlinedCalls);
+		row("builtin calls", builtinCalls);
+	}
+};
+
+#ifdef BCC_INTERPRETER_STATS
+#define BCC_STATS_COUNT(COUNTER) (InterpreterStats::local().COUNTER++)
+#else
+#define BCC_STATS_COUNT(COUNTER) ((void)0)
+#endif
@@ -101,6 +101,8 @@ public:
 			std::cout << "ERROR: Tried to destroy ImmediateLexer object with non-empty stack\n";
 	}
 
+	inline size_t tokenCount() const { return tokens.size(); } // including the END token
+
 public:
 	inline virtual Token peek() const override {
 		return tokens[std::min<size_t>(tokens.size()-1, ind)];
@@ -0,0 +1,88 @@
+#pragma once
+
+
+#include <string_view>
+#include <algorithm>
+#include <ostream>
+#include <cstdint>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "AST.hpp"
+
+
+// Opt-in statement execution counter for the Interpreter (see Interpreter::setLineCounter()).
+// Counting is a single increment per executed statement, indexed by AST::Node::id();
+// hits are only mapped to source lines (through the node spans) when a report is generated.
+class LineCounter {
+public:
+	struct Line {
+		size_t line; // 1-based
+		uint64_t hits;
+	};
+
+private:
+	std::string_view source;
+	std::vector<size_t> lineStarts; // offset of the first character of every line
+	std::vector<uint64_t> hits; // indexed by AST::Node::id()
+	std::vector<const AST::Node*> nodes; // indexed by AST::Node::id()
+
+public:
+	inline LineCounter(const std::string_view source): source(source), lineStarts{ 0 } {
+		for(size_t i = 0; i < source.size(); i++)
+			if(source[i] == '\n')
+				lineStarts.push_back(i + 1);
+	}
+
+	inline void hit(const AST::Node* node) {
+		const uint32_t id = node->id();
+		if(id >= hits.size()) {
+			hits.resize(std::max<size_t>(id + 1, 2 * hits.size()), 0);
+			nodes.resize(hits.size(), nullptr);
+		}
+		hits[id]++;
+		nodes[id] = node;
+	}
+
+	// 1-based line containing the given source offset
+	inline size_t lineOf(const size_t offset) const {
+		return static_cast<size_t>(std::upper_bound(lineStarts.begin(), lineStarts.end(), offset) - lineStarts.begin());
+	}
+
+	inline std::string_view lineText(const size_t line) const {
+		const size_t start = lineStarts[line - 1];
+		const size_t end = line < lineStarts.size() ? lineStarts[line] - 1 : source.size();
+		return source.substr(start, end - start);
+	}
+
+	// hits per source line (statements are attributed to the line they start on), only lines with hits
+	inline std::vector<Line> lines() const {
+		std::vector<uint64_t> perLine(lineStarts.size() + 1, 0);
+		for(size_t id = 0; id < hits.size(); id++)
+			if(hits[id] > 0 && nodes[id]->span().len() > 0) // synthesized nodes have no source span
+				perLine[lineOf(nodes[id]->span().start())] += hits[id];
+
+		std::vector<Line> res;
+		for(size_t line = 1; line < perLine.size(); line++)
+			if(perLine[line] > 0)
+				res.push_back({ line, perLine[line] });
+		return res;
+	}
+
+	// the source, annotated with the number of executed statements per line
+	inline void print(std::ostream& console) const {
+		std::vector<uint64_t> perLine(lineStarts.size() + 1, 0);
+		for(const Line& line : lines())
+			perLine[line.line] = line.hits;
+
+		console << "Line Hits:\n";
+		for(size_t line = 1; line <= lineStarts.size(); line++) {
+			if(perLine[line] > 0)
+				console << std::setw(10) << perLine[line];
+			else
+				console << std::setw(10) << "";
+			console << " " << std::setw(5) << line << ": " << lineText(line) << "\n";
+		}
+	}
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+
+#include <filesystem>
+#include <stdexcept>
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+// read only memory mapping of a whole file, the pages are loaded on first access
+class MappedFile {
+private:
+	const char* data_;
+	size_t size_;
+
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#endif
+
+public:
+	inline MappedFile(const std::filesystem::path& path): data_(nullptr), size_(0) {
+#ifdef _WIN32
+		mapping = nullptr;
+		file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if(file == INVALID_HANDLE_VALUE)
+			throw std::runtime_error("MappedFile::MappedFile(): Could not open \"" + path.string() + "\"");
+
+		LARGE_INTEGER size;
+		if(!GetFileSizeEx(file, &size)) {
+			CloseHandle(file);
+			throw std::runtime_error("MappedFile::MappedFile(): Could not read the size of \"" + path.string() + "\"");
+		}
+		size_ = static_cast<size_t>(size.QuadPart);
+		if(size_ == 0)
+			return;
+
+		mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if(mapping)
+			data_ = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		if(!data_) {
+			if(mapping) CloseHandle(mapping);
+			CloseHandle(file);
+			throw std::runtime_error("MappedFile::MappedFile(): Could not map \"" + path.string() + "\"");
+		}
+#else
+		const int fd = open(path.c_str(), O_RDONLY);
+		if(fd < 0)
+			throw std::runtime_error("MappedFile::MappedFile(): Could not open \"" + path.string() + "\"");
+
+		struct stat info;
+		if(fstat(fd, &info) != 0) {
+			close(fd);
+			throw std::runtime_error("MappedFile::MappedFile(): Could not read the size of \"" + path.string() + "\"");
+		}
+		size_ = static_cast<size_t>(info.st_size);
+
+		if(size_ > 0) {
+			void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+			if(p == MAP_FAILED) {
+				close(fd);
+				throw std::runtime_error("MappedFile::MappedFile(): Could not map \"" + path.string() + "\"");
+			}
+			data_ = static_cast<const char*>(p);
+		}
+		close(fd); // the mapping keeps the file alive
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+
+	inline ~MappedFile() {
+#ifdef _WIN32
+		if(data_) UnmapViewOfFile(data_);
+		if(mapping) CloseHandle(mapping);
+		CloseHandle(file);
+#else
+		if(data_) munmap(const_cast<char*>(data_), size_);
+#endif
+	}
+
+	inline const char* data() const { return data_; }
+	inline size_t size() const { return size_; }
+};
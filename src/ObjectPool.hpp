@@ -0,0 +1,71 @@
+#pragma once
+
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+
+// owns the heap objects of one compilation. Parse tree and AST nodes, symbol tables and symbols point at each other
+// without owning each other, so nothing deletes them individually. While a pool is active on a thread (see Activation),
+// every such object registers itself with it on construction, and destroying the pool deletes them all.
+// Objects constructed while a pool is active must therefore be heap allocated.
+class ObjectPool {
+private:
+	struct Entry {
+		const void* object;
+		void (*destroy)(const void*);
+	};
+
+	inline static thread_local ObjectPool* active = nullptr;
+	inline static thread_local uint32_t destroying = 0; // pools being destroyed on this thread
+
+	std::vector<Entry> entries;
+
+public:
+	// makes pool the active pool of this thread until the Activation goes out of scope
+	class Activation {
+	private:
+		ObjectPool* previous;
+
+	public:
+		inline Activation(ObjectPool& pool): previous(active) { active = &pool; }
+		inline ~Activation() { active = previous; }
+		Activation(const Activation&) = delete;
+	};
+
+public:
+	inline ObjectPool() {}
+	ObjectPool(const ObjectPool&) = delete;
+
+	inline ~ObjectPool() {
+		destroying++;
+		for(size_t i = entries.size(); i-- > 0;) // newest first
+			entries[i].destroy(entries[i].object);
+		destroying--;
+	}
+
+	inline size_t size() const { return entries.size(); }
+
+	// called by the constructors of the pooled types (T is the type whose destructor deletes the whole object)
+	template<typename T>
+	inline static void adopt(const T* object) {
+		if(active)
+			active->entries.push_back({ object, [](const void* p) { delete static_cast<const T*>(p); } });
+	}
+
+	// called by their destructors: an object that was deleted directly (or whose constructor threw) must not be deleted again.
+	// Such objects are among the most recently created ones, so the search starts at the end
+	inline static void forget(const void* object) {
+		if(destroying || !active)
+			return;
+
+		std::vector<Entry>& entries = active->entries;
+		for(size_t i = entries.size(); i-- > 0;) {
+			if(entries[i].object == object) {
+				entries.erase(entries.begin() + static_cast<ptrdiff_t>(i));
+				return;
+			}
+		}
+	}
+};
@@ -0,0 +1,182 @@
+#pragma once
+
+
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "AST.hpp"
+#include "Builtins.hpp"
+
+
+// finds the binary expressions and call argument lists whose operands can be evaluated concurrently
+// (see Interpreter::setParallel()). Operands qualify when they are side effect free and their estimated cost
+// reaches the threshold:
+// - a function is pure if it only assigns variables it declares (or its parameters) and only calls pure functions / builtins
+// - an operand is fork safe if it only calls pure functions and builtins, inlined or not
+//   (an inlined body declares its locals in its own scope, like the call it replaced)
+// - the cost is the number of AST nodes evaluated, including callee bodies; recursive callees count as unbounded
+class ParallelAnalysis {
+public:
+	using Function = AST::FunctionDeclarationStatement;
+	static constexpr uint64_t unbounded = UINT64_MAX / 4;
+
+private:
+	uint64_t threshold;
+	std::vector<uint8_t> parallel; // indexed by AST::Node::id()
+	std::vector<int8_t> forkSafe; // memo, -1: not computed yet
+	std::vector<uint64_t> costs; // memo of cost() outside of function bodies, 0: not computed yet
+
+	std::unordered_map<const Function*, bool> pure;
+	std::unordered_map<const Function*, std::vector<const Function*>> callees;
+	std::unordered_map<const Function*, uint64_t> functionCosts;
+	std::unordered_set<const Function*> inProgress;
+
+public:
+	inline ParallelAnalysis(const AST::Node* ast, const uint64_t threshold): threshold(threshold), parallel(idBound(ast), 0), forkSafe(parallel.size(), -1), costs(parallel.size(), 0) {
+		collectFunctions(ast);
+		propagateImpurity();
+		mark(ast);
+	}
+
+	// operands of this BinaryExpression / arguments of this FunctionCall may be evaluated as parallel tasks
+	inline bool isParallel(const AST::Node* node) const {
+		return node->id() < parallel.size() && parallel[node->id()];
+	}
+
+	inline bool isPure(const Function* function) const {
+		const auto it = pure.find(function);
+		return it != pure.end() && it->second;
+	}
+
+	inline size_t parallelCount() const {
+		return static_cast<size_t>(std::count(parallel.begin(), parallel.end(), 1));
+	}
+
+private:
+	// size of the tables: the node count for numbered programs (see AST::Node::number())
+	inline static size_t idBound(const AST::Node* node) {
+		size_t res = node->id() + 1;
+		node->forEachChild([&](const AST::Node* child) { res = std::max(res, idBound(child)); });
+		return res;
+	}
+
+	inline static const Function* callee(const AST::FunctionCallExpressionNode* call) {
+		const Symbol* symbol = call->getScope().lookupRecursive(call->name);
+		return symbol ? dynamic_cast<const Function*>(std::get<const AST::Node*>(symbol->type)) : nullptr;
+	}
+
+	inline void collectFunctions(const AST::Node* node) {
+		if(const Function* function = dynamic_cast<const Function*>(node)) {
+			std::unordered_set<std::string> locals;
+			for(const Function::Argument& arg : function->args)
+				locals.insert(arg.name);
+
+			bool effects = false;
+			std::vector<const Function*>& calls = callees[function];
+			visitBody(function->body, locals, effects, calls);
+			pure[function] = !effects;
+		}
+
+		node->forEachChild([&](const AST::Node* child) { collectFunctions(child); });
+	}
+
+	// pre-order, so declarations are seen before the assignments that follow them
+	inline static void visitBody(const AST::Node* node, std::unordered_set<std::string>& locals, bool& effects, std::vector<const Function*>& calls) {
+		if(const AST::VariableDeclarationStatement* declaration = dynamic_cast<const AST::VariableDeclarationStatement*>(node))
+			locals.insert(declaration->varName);
+		else if(const AST::VariableAssignmentStatement* assignment = dynamic_cast<const AST::VariableAssignmentStatement*>(node); assignment && !locals.contains(assignment->varName))
+			effects = true; // writes a variable of a calling scope
+		else if(dynamic_cast<const AST::ElementAssignmentStatement*>(node) || dynamic_cast<const AST::FieldAssignmentStatement*>(node))
+			effects = true; // arrays and records are shared by reference, even a local name may refer to the caller's
+		else if(const AST::BuiltinCallExpressionNode* builtin = dynamic_cast<const AST::BuiltinCallExpressionNode*>(node); builtin && !builtin->builtin->pure)
+			effects = true;
+		else if(const AST::FunctionCallExpressionNode* call = dynamic_cast<const AST::FunctionCallExpressionNode*>(node)) {
+			const Function* function = callee(call);
+			if(function) calls.push_back(function);
+			else effects = true;
+		}
+
+		node->forEachChild([&](const AST::Node* child) { visitBody(child, locals, effects, calls); });
+	}
+
+	inline void propagateImpurity() {
+		for(bool changed = true; changed;) {
+			changed = false;
+			for(auto& [function, isPure] : pure) {
+				if(!isPure)
+					continue;
+				for(const Function* c : callees[function])
+					if(!this->isPure(c)) { isPure = false; changed = true; break; }
+			}
+		}
+	}
+
+	inline bool isForkSafe(const AST::Node* node) {
+		int8_t& memo = forkSafe[node->id()];
+		if(memo < 0)
+			memo = computeForkSafe(node);
+		return memo;
+	}
+
+	inline bool computeForkSafe(const AST::Node* node) {
+		if(const AST::InlinedCallExpressionNode* inlined = dynamic_cast<const AST::InlinedCallExpressionNode*>(node); inlined && !isPure(inlined->function))
+			return false;
+		if(const AST::BuiltinCallExpressionNode* builtin = dynamic_cast<const AST::BuiltinCallExpressionNode*>(node); builtin && !builtin->builtin->pure)
+			return false;
+		if(const AST::FunctionCallExpressionNode* call = dynamic_cast<const AST::FunctionCallExpressionNode*>(node); call && !isPure(callee(call)))
+			return false;
+
+		bool safe = true;
+		node->forEachChild([&](const AST::Node* child) { safe = safe && isForkSafe(child); });
+		return safe;
+	}
+
+	inline uint64_t cost(const AST::Node* node) {
+		if(!inProgress.empty()) // inside a function body the result depends on the call chain
+			return computeCost(node);
+		if(costs[node->id()] == 0)
+			costs[node->id()] = computeCost(node);
+		return costs[node->id()];
+	}
+
+	inline uint64_t computeCost(const AST::Node* node) {
+		uint64_t res = 1;
+		if(const AST::FunctionCallExpressionNode* call = dynamic_cast<const AST::FunctionCallExpressionNode*>(node))
+			res += functionCost(callee(call));
+
+		node->forEachChild([&](const AST::Node* child) { res = std::min(unbounded, res + cost(child)); });
+		return res;
+	}
+
+	inline uint64_t functionCost(const Function* function) {
+		if(!function || inProgress.contains(function)) // recursion
+			return unbounded;
+		if(const auto it = functionCosts.find(function); it != functionCosts.end())
+			return it->second;
+
+		inProgress.insert(function);
+		const uint64_t res = cost(function->body);
+		inProgress.erase(function);
+		return functionCosts[function] = res;
+	}
+
+	inline void mark(const AST::Node* node) {
+		if(const AST::BinaryExpressionNode* binary = dynamic_cast<const AST::BinaryExpressionNode*>(node)) {
+			parallel[node->id()] = isForkSafe(binary->a) && isForkSafe(binary->b) && cost(binary->a) >= threshold && cost(binary->b) >= threshold;
+		} else if(const AST::FunctionCallExpressionNode* call = dynamic_cast<const AST::FunctionCallExpressionNode*>(node)) {
+			size_t expensive = 0;
+			bool safe = true;
+			for(const AST::ExpressionNode* arg : call->args) {
+				safe = safe && isForkSafe(arg);
+				if(cost(arg) >= threshold) expensive++;
+			}
+			parallel[node->id()] = safe && expensive >= 2;
+		}
+
+		node->forEachChild([&](const AST::Node* child) { mark(child); });
+	}
+};
@@ -3,10 +3,12 @@
 
 #include <stdexcept>
 #include <ostream>
+#include <atomic>
 #include <cstdint>
 #include <string>
 #include <vector>
 
+#include "ObjectPool.hpp"
 #include "Tokens.hpp"
 
 
@@ -31,13 +33,16 @@ namespace ParseTree {
 		};
 
 	private:
+		inline static std::atomic<uint32_t> nodeCount{ 0 }; // nodes created so far (including nodes discarded by backtracking)
+
 		BaseType baseType_;
 
 	public:
-		inline Node(const BaseType baseType): baseType_(baseType) {}
-		inline virtual ~Node() {}
+		inline Node(const BaseType baseType): baseType_(baseType) { nodeCount++; ObjectPool::adopt(this); }
+		inline virtual ~Node() { ObjectPool::forget(this); }
 
 	public:
+		inline static uint32_t count() { return nodeCount; }
 		inline BaseType baseType() const { return baseType_; }
 	
 	public:
@@ -51,7 +56,7 @@ namespace ParseTree {
 	struct ExpressionNode : public Node {
 	public:
 		enum class Type : uint8_t {
-			LITERAL_EXPRESSION, VARIABLE_EXPRESSION, UNARY_EXPRESSION, BINARY_EXPRESSION, CALL_EXPRESSION, GROUP_EXPRESSION,
+			LITERAL_EXPRESSION, VARIABLE_EXPRESSION, UNARY_EXPRESSION, BINARY_EXPRESSION, CALL_EXPRESSION, GROUP_EXPRESSION, ARRAY_EXPRESSION, INDEX_EXPRESSION, FIELD_EXPRESSION,
 		};
 
 	private:
@@ -67,7 +72,7 @@ namespace ParseTree {
 	public:
 		enum class Type : uint8_t {
 			EXPRESSION_STATEMENT, BLOCK_STATEMENT, RETURN_STATEMENT,
-			IF_STATEMENT, WHILE_STATEMENT, FUNCTION_DECLARATION, VARIABLE_DECLARATION, VARIABLE_ASSIGNMENT,
+			IF_STATEMENT, WHILE_STATEMENT, FOR_STATEMENT, SWITCH_STATEMENT, BREAK_STATEMENT, CONTINUE_STATEMENT, FUNCTION_DECLARATION, VARIABLE_DECLARATION, VARIABLE_ASSIGNMENT, ELEMENT_ASSIGNMENT, FIELD_ASSIGNMENT, STRUCT_DECLARATION,
 		};
 
 	private:
@@ -221,6 +226,102 @@ namespace ParseTree {
 		inline virtual std::string toString(const size_t indent) const override { return space(indent) + value.value; }
 	};
 
+	// "int[length]" (zero initialized) or an array literal "[a, b, c]" (typeName is not set)
+	struct ArrayExpressionNode : public ExpressionNode {
+		Token typeName;
+		Token openSquare;
+		const ExpressionNode* length;
+		std::vector<const ExpressionNode*> elements;
+		std::vector<Token> commas;
+		Token closeSquare;
+
+		inline ArrayExpressionNode(const Token& typeName, const Token& openSquare, const ExpressionNode* length, const Token& closeSquare):
+			ExpressionNode(Type::ARRAY_EXPRESSION),
+			typeName(typeName), openSquare(openSquare), length(length), closeSquare(closeSquare) {}
+		inline ArrayExpressionNode(const Token& openSquare, const std::vector<const ExpressionNode*>& elements, const std::vector<Token>& commas, const Token& closeSquare):
+			ExpressionNode(Type::ARRAY_EXPRESSION),
+			openSquare(openSquare), length(nullptr), elements(elements), commas(commas), closeSquare(closeSquare) {}
+
+		inline bool isLiteral() const { return length == nullptr; }
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+			console << RBRANCH << (isLiteral() ? "    ArrayLiteral " : "    ArrayAllocation ") << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			if(!isLiteral())
+				console << subIndent << VBRANCH << typeName.value << "    Typename " << typeName.span << "\n";
+			console << subIndent << VBRANCH << openSquare.value << "    OpenSquare " << openSquare.span << "\n";
+			if(length)
+				length->print(console, subIndent, false);
+			for(const ExpressionNode* element : elements)
+				element->print(console, subIndent, false);
+			console << subIndent << LBRANCH << closeSquare.value << "    CloseSquare " << closeSquare.span << "\n";
+		}
+
+		inline virtual Span span() const override { return Span(isLiteral() ? openSquare.span : typeName.span, closeSquare.span); }
+
+		inline virtual std::string toString(const size_t indent) const override {
+			if(!isLiteral())
+				return space(indent) + typeName.value + openSquare.value + length->toString(0) + closeSquare.value;
+
+			std::string res = space(indent) + openSquare.value;
+			for(size_t i = 0; i < commas.size(); i++)
+				res += elements[i]->toString(0) + commas[i].value + " ";
+			return res + elements.back()->toString(0) + closeSquare.value;
+		}
+	};
+
+	struct IndexExpressionNode : public ExpressionNode {
+		const ExpressionNode* array;
+		Token openSquare;
+		const ExpressionNode* index;
+		Token closeSquare;
+
+		inline IndexExpressionNode(const ExpressionNode* array, const Token& openSquare, const ExpressionNode* index, const Token& closeSquare):
+			ExpressionNode(Type::INDEX_EXPRESSION),
+			array(array), openSquare(openSquare), index(index), closeSquare(closeSquare) {}
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+			console << RBRANCH << "    IndexExpression " << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			array->print(console, subIndent, false);
+			console << subIndent << VBRANCH << openSquare.value << "    OpenSquare " << openSquare.span << "\n";
+			index->print(console, subIndent, false);
+			console << subIndent << LBRANCH << closeSquare.value << "    CloseSquare " << closeSquare.span << "\n";
+		}
+
+		inline virtual Span span() const override { return Span(array->span(), closeSquare.span); }
+
+		inline virtual std::string toString(const size_t indent) const override { return space(indent) + array->toString(0) + openSquare.value + index->toString(0) + closeSquare.value; }
+	};
+
+	struct FieldExpressionNode : public ExpressionNode {
+		const ExpressionNode* object;
+		Token dot;
+		Token fieldName;
+
+		inline FieldExpressionNode(const ExpressionNode* object, const Token& dot, const Token& fieldName):
+			ExpressionNode(Type::FIELD_EXPRESSION),
+			object(object), dot(dot), fieldName(fieldName) {}
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+			console << RBRANCH << "    FieldExpression " << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			object->print(console, subIndent, false);
+			console << subIndent << VBRANCH << dot.value << "    Dot " << dot.span << "\n";
+			console << subIndent << LBRANCH << fieldName.value << "    Identifier " << fieldName.span << "\n";
+		}
+
+		inline virtual Span span() const override { return Span(object->span(), fieldName.span); }
+
+		inline virtual std::string toString(const size_t indent) const override { return space(indent) + object->toString(0) + dot.value + fieldName.value; }
+	};
+
 
 	// Statements:
 	struct VariableDeclarationStatement : public StatementNode {
@@ -234,7 +335,7 @@ namespace ParseTree {
 			StatementNode(Type::VARIABLE_DECLARATION),
 			typeName(typeName), varName(varName), equals(equals), expr(expr), semicolon(semicolon) {}
 		inline VariableDeclarationStatement(const Token& typeName, const Token& varName, const Token& semicolon):
-			VariableDeclarationStatement(typeName, varName, equals, nullptr, semicolon) {}
+			VariableDeclarationStatement(typeName, varName, Token(), nullptr, semicolon) {} // no "=" token
 
 		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
 			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
@@ -289,6 +390,69 @@ namespace ParseTree {
 		inline virtual std::string toString(const size_t indent) const override { return space(indent) + varName.value + (expr ? (" " + equals.value + " " + expr->toString(0)) : "") + semicolon.value; }
 	};
 
+	// "a[index] = expr;"
+	struct ElementAssignmentStatement : public StatementNode {
+		Token varName;
+		Token openSquare;
+		const ExpressionNode* index;
+		Token closeSquare;
+		Token equals;
+		const ExpressionNode* expr;
+		Token semicolon;
+
+		inline ElementAssignmentStatement(const Token& varName, const Token& openSquare, const ExpressionNode* index, const Token& closeSquare, const Token& equals, const ExpressionNode* expr, const Token& semicolon):
+			StatementNode(Type::ELEMENT_ASSIGNMENT),
+			varName(varName), openSquare(openSquare), index(index), closeSquare(closeSquare), equals(equals), expr(expr), semicolon(semicolon) {}
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+			console << RBRANCH << "    ElementAssignment " << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			console << subIndent << VBRANCH << varName.value << "    Identifier " << varName.span << "\n";
+			console << subIndent << VBRANCH << openSquare.value << "    OpenSquare " << openSquare.span << "\n";
+			index->print(console, subIndent, false);
+			console << subIndent << VBRANCH << closeSquare.value << "    CloseSquare " << closeSquare.span << "\n";
+			console << subIndent << VBRANCH << equals.value << "    Operator " << equals.span << "\n";
+			expr->print(console, subIndent, false);
+			console << subIndent << LBRANCH << semicolon.value << "    Semicolon " << semicolon.span << "\n";
+		}
+
+		inline virtual Span span() const override { return Span(varName.span, semicolon.span); }
+
+		inline virtual std::string toString(const size_t indent) const override { return space(indent) + varName.value + openSquare.value + index->toString(0) + closeSquare.value + " " + equals.value + " " + expr->toString(0) + semicolon.value; }
+	};
+
+	struct FieldAssignmentStatement : public StatementNode {
+		Token varName;
+		Token dot;
+		Token fieldName;
+		Token equals;
+		const ExpressionNode* expr;
+		Token semicolon;
+
+		inline FieldAssignmentStatement(const Token& varName, const Token& dot, const Token& fieldName, const Token& equals, const ExpressionNode* expr, const Token& semicolon):
+			StatementNode(Type::FIELD_ASSIGNMENT),
+			varName(varName), dot(dot), fieldName(fieldName), equals(equals), expr(expr), semicolon(semicolon) {}
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+			console << RBRANCH << "    FieldAssignment " << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			console << subIndent << VBRANCH << varName.value << "    Identifier " << varName.span << "\n";
+			console << subIndent << VBRANCH << dot.value << "    Dot " << dot.span << "\n";
+			console << subIndent << VBRANCH << fieldName.value << "    Identifier " << fieldName.span << "\n";
+			console << subIndent << VBRANCH << equals.value << "    Operator " << equals.span << "\n";
+			expr->print(console, subIndent, false);
+			console << subIndent << LBRANCH << semicolon.value << "    Semicolon " << semicolon.span << "\n";
+		}
+
+		inline virtual Span span() const override { return Span(varName.span, semicolon.span); }
+
+		inline virtual std::string toString(const size_t indent) const override { return space(indent) + varName.value + dot.value + fieldName.value + " " + equals.value + " " + expr->toString(0) + semicolon.value; }
+	};
+
 	struct ExpressionStatement : public StatementNode {
 		const ExpressionNode* expr;
 		Token semicolon;
@@ -437,13 +601,188 @@ namespace ParseTree {
 		inline virtual std::string toString(const size_t indent) const override { return space(indent) + whileToken.value + openParen.value + condition->toString(0) + closeParen.value + "\n" + body->toString(indent); }
 	};
 
+	struct ForStatement : public StatementNode {
+		Token forToken;
+		Token openParen;
+		const StatementNode* init; // variable declaration or assignment (including its ';'), nullptr if empty
+		Token initSemicolon; // only used if init is empty
+		const ExpressionNode* condition; // nullptr if empty
+		Token conditionSemicolon;
+		Token stepName, stepEquals; // step assignment "name = expr" (without ';')
+		const ExpressionNode* stepExpr; // nullptr if empty
+		Token closeParen;
+		const StatementNode* body;
+
+		inline ForStatement(const Token& forToken, const Token& openParen, const StatementNode* init, const Token& initSemicolon, const ExpressionNode* condition, const Token& conditionSemicolon, const Token& stepName, const Token& stepEquals, const ExpressionNode* stepExpr, const Token& closeParen, const StatementNode* body):
+			StatementNode(Type::FOR_STATEMENT),
+			forToken(forToken), openParen(openParen), init(init), initSemicolon(initSemicolon), condition(condition), conditionSemicolon(conditionSemicolon),
+			stepName(stepName), stepEquals(stepEquals), stepExpr(stepExpr), closeParen(closeParen), body(body) {}
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+
+			console << RBRANCH << "    ForStatement " << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			console << subIndent << VBRANCH << forToken.value << "    ForKeyword " << forToken.span << "\n";
+			console << subIndent << VBRANCH << openParen.value << "    OpenParen " << openParen.span << "\n";
+			if(init)
+				init->print(console, subIndent, false);
+			else
+				console << subIndent << VBRANCH << initSemicolon.value << "    Semicolon " << initSemicolon.span << "\n";
+			if(condition)
+				condition->print(console, subIndent, false);
+			console << subIndent << VBRANCH << conditionSemicolon.value << "    Semicolon " << conditionSemicolon.span << "\n";
+			if(stepExpr) {
+				console << subIndent << VBRANCH << stepName.value << "    Identifier " << stepName.span << "\n";
+				console << subIndent << VBRANCH << stepEquals.value << "    Operator " << stepEquals.span << "\n";
+				stepExpr->print(console, subIndent, false);
+			}
+			console << subIndent << VBRANCH << closeParen.value << "    CloseParen " << closeParen.span << "\n";
+			body->print(console, subIndent, true);
+		}
+
+		inline virtual Span span() const override { return Span(forToken.span, body->span()); }
+
+		inline virtual std::string toString(const size_t indent) const override {
+			return space(indent) + forToken.value + openParen.value
+				+ (init ? init->toString(0) : initSemicolon.value) + " "
+				+ (condition ? condition->toString(0) : "") + conditionSemicolon.value + " "
+				+ (stepExpr ? stepName.value + " " + stepEquals.value + " " + stepExpr->toString(0) : "")
+				+ closeParen.value + "\n" + body->toString(indent);
+		}
+	};
+
+	struct SwitchStatement : public StatementNode {
+		struct Label {
+			Token keyword; // 'case' or 'default'
+			Token sign; // optional '-' before the value (default constructed if absent)
+			Token value; // int literal (default constructed for 'default')
+			Token colon;
+
+			inline bool isDefault() const { return keyword.type == Token::Type::DEFAULT; }
+			inline bool isNegative() const { return sign.type == Token::Type::MINUS; }
+		};
+
+		struct Section {
+			std::vector<Label> labels; // at least one
+			std::vector<const StatementNode*> statements;
+		};
+
+		Token switchToken;
+		Token openParen;
+		const ExpressionNode* value;
+		Token closeParen;
+		Token openBrace;
+		std::vector<Section> sections;
+		Token closeBrace;
+
+		inline SwitchStatement(const Token& switchToken, const Token& openParen, const ExpressionNode* value, const Token& closeParen, const Token& openBrace, const std::vector<Section>& sections, const Token& closeBrace):
+			StatementNode(Type::SWITCH_STATEMENT),
+			switchToken(switchToken), openParen(openParen), value(value), closeParen(closeParen), openBrace(openBrace), sections(sections), closeBrace(closeBrace) {}
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+
+			console << RBRANCH << "    SwitchStatement " << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			console << subIndent << VBRANCH << switchToken.value << "    SwitchKeyword " << switchToken.span << "\n";
+			console << subIndent << VBRANCH << openParen.value << "    OpenParen " << openParen.span << "\n";
+			value->print(console, subIndent, false);
+			console << subIndent << VBRANCH << closeParen.value << "    CloseParen " << closeParen.span << "\n";
+			console << subIndent << VBRANCH << openBrace.value << "    OpenBrace " << openBrace.span << "\n";
+
+			for(const Section& section : sections) {
+				for(const Label& label : section.labels) {
+					console << subIndent << VBRANCH << label.keyword.value << (label.isDefault() ? "    DefaultKeyword " : "    CaseKeyword ") << label.keyword.span << "\n";
+					if(label.isNegative())
+						console << subIndent << VBRANCH << label.sign.value << "    Operator " << label.sign.span << "\n";
+					if(!label.isDefault())
+						console << subIndent << VBRANCH << label.value.value << "    IntLiteral " << label.value.span << "\n";
+					console << subIndent << VBRANCH << label.colon.value << "    Colon " << label.colon.span << "\n";
+				}
+
+				for(const StatementNode* statement : section.statements)
+					statement->print(console, subIndent, false);
+			}
+
+			console << subIndent << LBRANCH << closeBrace.value << "    CloseBrace " << closeBrace.span << "\n";
+		}
+
+		inline virtual Span span() const override { return Span(switchToken.span, closeBrace.span); }
+
+		inline virtual std::string toString(const size_t indent) const override {
+			std::string res = space(indent) + switchToken.value + openParen.value + value->toString(0) + closeParen.value + " " + openBrace.value + "\n";
+
+			for(const Section& section : sections) {
+				for(const Label& label : section.labels)
+					res += space(indent) + label.keyword.value + (label.isDefault() ? "" : " " + (label.isNegative() ? label.sign.value : "") + label.value.value) + label.colon.value + "\n";
+
+				for(const StatementNode* s : section.statements)
+					res += s->toString(indent + 1) + "\n";
+			}
+
+			res += space(indent) + closeBrace.value;
+
+			return res;
+		}
+	};
+
+	struct BreakStatement : public StatementNode {
+		Token breakToken;
+		Token semicolon;
+
+		inline BreakStatement(const Token& breakToken, const Token& semicolon):
+			StatementNode(Type::BREAK_STATEMENT),
+			breakToken(breakToken), semicolon(semicolon) {}
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+
+			console << RBRANCH << "    BreakStatement " << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			console << subIndent << VBRANCH << breakToken.value << "    BreakKeyword " << breakToken.span << "\n";
+			console << subIndent << LBRANCH << semicolon.value << "    Semicolon " << semicolon.span << "\n";
+		}
+
+		inline virtual Span span() const override { return Span(breakToken.span, semicolon.span); }
+
+		inline virtual std::string toString(const size_t indent) const override { return space(indent) + breakToken.value + semicolon.value; }
+	};
+
+	struct ContinueStatement : public StatementNode {
+		Token continueToken;
+		Token semicolon;
+
+		inline ContinueStatement(const Token& continueToken, const Token& semicolon):
+			StatementNode(Type::CONTINUE_STATEMENT),
+			continueToken(continueToken), semicolon(semicolon) {}
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+
+			console << RBRANCH << "    ContinueStatement " << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			console << subIndent << VBRANCH << continueToken.value << "    ContinueKeyword " << continueToken.span << "\n";
+			console << subIndent << LBRANCH << semicolon.value << "    Semicolon " << semicolon.span << "\n";
+		}
+
+		inline virtual Span span() const override { return Span(continueToken.span, semicolon.span); }
+
+		inline virtual std::string toString(const size_t indent) const override { return space(indent) + continueToken.value + semicolon.value; }
+	};
+
 	struct ArgumentsNode {
 		struct Argument { Token type, name; };
 		std::vector<Argument> args;
 		std::vector<Token> commas;
 
 		inline ArgumentsNode(const std::vector<Argument>& args, const std::vector<Token>& commas):
-			args(args), commas(commas) {}
+			args(args), commas(commas) { ObjectPool::adopt(this); }
+		inline ~ArgumentsNode() { ObjectPool::forget(this); }
 
 		inline void print(std::ostream& console, const std::string& indent, const bool isLast) const {
 			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
@@ -512,6 +851,50 @@ namespace ParseTree {
 		inline virtual std::string toString(const size_t indent) const override { return space(indent) + typeName.value + " " + functionName.value + openParen.value + args->toString(0) + closeParen.value + "\n" + body->toString(indent) + "\n"; }
 	};
 
+	// struct Name { type field; ... }
+	struct StructDeclarationStatement : public StatementNode {
+		struct Field { Token type, name, semicolon; };
+
+		Token structToken;
+		Token name;
+		Token openBrace;
+		std::vector<Field> fields;
+		Token closeBrace;
+
+		inline StructDeclarationStatement(const Token& structToken, const Token& name, const Token& openBrace, const std::vector<Field>& fields, const Token& closeBrace):
+			StatementNode(Type::STRUCT_DECLARATION),
+			structToken(structToken), name(name), openBrace(openBrace), fields(fields), closeBrace(closeBrace) {}
+
+		inline virtual void print(std::ostream& console, const std::string& indent, const bool isLast) const override {
+			console << indent << (isLast ? LBRANCH : VBRANCH); // isLast ? "└─" : "├─"
+			console << RBRANCH << "    StructDeclaration " << span() << "\n";
+
+			const std::string subIndent = indent + (isLast ? SPACE : VSPACE); // isLast ? "  " : "│ "
+			console << subIndent << VBRANCH << structToken.value << "    Keyword " << structToken.span << "\n";
+			console << subIndent << VBRANCH << name.value << "    Identifier " << name.span << "\n";
+			console << subIndent << VBRANCH << openBrace.value << "    OpenBrace " << openBrace.span << "\n";
+			for(const Field& field : fields) {
+				console << subIndent << VBRANCH << field.type.value << "    Typename " << field.type.span << "\n";
+				console << subIndent << VBRANCH << field.name.value << "    Identifier " << field.name.span << "\n";
+				console << subIndent << VBRANCH << field.semicolon.value << "    Semicolon " << field.semicolon.span << "\n";
+			}
+			console << subIndent << LBRANCH << closeBrace.value << "    CloseBrace " << closeBrace.span << "\n";
+		}
+
+		inline virtual Span span() const override { return Span(structToken.span, closeBrace.span); }
+
+		inline virtual std::string toString(const size_t indent) const override {
+			std::string res = space(indent) + structToken.value + " " + name.value + " " + openBrace.value + "\n";
+
+			for(const Field& field : fields)
+				res += space(indent + 1) + field.type.value + " " + field.name.value + field.semicolon.value + "\n";
+
+			res += space(indent) + closeBrace.value;
+
+			return res;
+		}
+	};
+
 	// Program:
 	struct Program : public Node {
 		std::vector<const StatementNode*> statements;
@@ -13,12 +13,41 @@
 class Parser {
 private:
 	TokenProvider& tokenProvider;
+	size_t loopDepth; // number of enclosing loops in the current function (break / continue are only valid inside loops)
+	size_t switchDepth; // number of enclosing switch statements in the current function (break is also valid inside a switch)
 
 public:
-	inline Parser(TokenProvider& tokenProvider): tokenProvider(tokenProvider) {} // parser does not own tokenProvider, it only uses it
+	inline Parser(TokenProvider& tokenProvider): tokenProvider(tokenProvider), loopDepth(0), switchDepth(0) {} // parser does not own tokenProvider, it only uses it
 	inline const Token peekToken() const { return tokenProvider.peek(); }
 	inline const Token getToken() { return tokenProvider.consume(); }
 
+	inline static bool isTypename(const Token& token) { const Token::Type type = token.type; return type == Token::Type::BOOL || type == Token::Type::INT || type == Token::Type::FLOAT || type == Token::Type::STRING; }
+
+	// consumes a typename, array types ("int[]") are merged into a single token. Consumes nothing if there is none.
+	// Identifiers are accepted as struct names, the SemanticAnalyzer checks that they name a type.
+	inline bool typeName(Token& type, const bool allowVoid = false) {
+		if(!isTypename(peekToken()) && peekToken().type != Token::Type::IDENTIFIER && !(allowVoid && peekToken().type == Token::Type::VOID))
+			return false;
+		type = getToken(); // consume typename
+
+		tokenProvider.pushState();
+		if(peekToken().type != Token::Type::SQUARE_OPEN) {
+			tokenProvider.popState();
+			return true;
+		}
+		getToken(); // consume '['
+
+		if(peekToken().type != Token::Type::SQUARE_CLOSE) { // array allocation "int[n]", not a typename
+			tokenProvider.popState();
+			return true;
+		}
+		const Token& closeSquare = getToken(); // consume ']'
+
+		tokenProvider.yeetState();
+		type = Token(type.type, type.value + "[]", type.span.start(), closeSquare.span.end() - type.span.start());
+		return true;
+	}
+
 
 	// ###########
 	// # Program #
@@ -51,15 +80,36 @@ public:
 		if(const ParseTree::VariableAssignmentStatement* varAss = variableAssignment())
 			return varAss;
 
+		if(const ParseTree::ElementAssignmentStatement* elemAss = elementAssignment())
+			return elemAss;
+
+		if(const ParseTree::FieldAssignmentStatement* fieldAss = fieldAssignment())
+			return fieldAss;
+
 		if(const ParseTree::IfStatement* ifStmt = ifStatement())
 			return ifStmt;
 
 		if(const ParseTree::WhileStatement* whileStmt = whileStatement())
 			return whileStmt;
 
+		if(const ParseTree::ForStatement* forStmt = forStatement())
+			return forStmt;
+
+		if(const ParseTree::SwitchStatement* switchStmt = switchStatement())
+			return switchStmt;
+
+		if(const ParseTree::BreakStatement* breakStmt = breakStatement())
+			return breakStmt;
+
+		if(const ParseTree::ContinueStatement* continueStmt = continueStatement())
+			return continueStmt;
+
 		if(const ParseTree::FunctionDeclarationStatement* function = functionDeclaration())
 			return function;
 
+		if(const ParseTree::StructDeclarationStatement* structDecl = structDeclaration())
+			return structDecl;
+
 		if(const ParseTree::ExpressionStatement* expStmt = expressionStatement())
 			return expStmt;
 
@@ -122,17 +172,14 @@ public:
 	}
 
 	inline const ParseTree::VariableDeclarationStatement* variableDeclaration() {
-		static constexpr auto isTypename = [](const Token& token) { const Token::Type type = token.type; return type == Token::Type::BOOL || type == Token::Type::INT || type == Token::Type::FLOAT || type == Token::Type::STRING; };
-
 		tokenProvider.pushState();
 		// const size_t currentTokenBefore = currentToken;
 
-		if(!isTypename(peekToken())) {
+		Token type;
+		if(!typeName(type)) { // consume typename
 			tokenProvider.popState();
 			return nullptr;
 		}
-		
-		const Token& type = getToken(); // consume typename
 
 		// ParseTree::IdentifierNode* name = identifier();
 		if(peekToken().type != Token::Type::IDENTIFIER) {
@@ -211,6 +258,83 @@ public:
 		return new ParseTree::VariableAssignmentStatement(name, equals, expr, semicolon);
 	}
 
+	inline const ParseTree::ElementAssignmentStatement* elementAssignment() {
+		tokenProvider.pushState();
+
+		if(peekToken().type != Token::Type::IDENTIFIER) {
+			tokenProvider.popState();
+			return nullptr;
+		}
+		const Token& name = getToken();
+
+		if(peekToken().type != Token::Type::SQUARE_OPEN) {
+			tokenProvider.popState();
+			return nullptr;
+		}
+		const Token& openSquare = getToken(); // consume '['
+
+		const ParseTree::ExpressionNode* index = expression();
+		if(!index || peekToken().type != Token::Type::SQUARE_CLOSE) {
+			tokenProvider.popState();
+			return nullptr;
+		}
+		const Token& closeSquare = getToken(); // consume ']'
+
+		if(peekToken().type != Token::Type::EQUAL) { // an expression statement starting with "a[i]"
+			tokenProvider.popState();
+			return nullptr;
+		}
+		const Token& equals = getToken(); // consume '='
+
+		const ParseTree::ExpressionNode* expr = expression();
+		if(!expr)
+			throw std::runtime_error("Failed to parse Element Assignment: missing expression");
+
+		if(peekToken().type != Token::Type::SEMICOLON)
+			throw std::runtime_error("Failed to parse Element Assignment: missing semicolon");
+		const Token& semicolon = getToken(); // consume ';'
+
+		tokenProvider.yeetState();
+		return new ParseTree::ElementAssignmentStatement(name, openSquare, index, closeSquare, equals, expr, semicolon);
+	}
+
+	inline const ParseTree::FieldAssignmentStatement* fieldAssignment() {
+		tokenProvider.pushState();
+
+		if(peekToken().type != Token::Type::IDENTIFIER) {
+			tokenProvider.popState();
+			return nullptr;
+		}
+		const Token& name = getToken();
+
+		if(peekToken().type != Token::Type::DOT) {
+			tokenProvider.popState();
+			return nullptr;
+		}
+		const Token& dot = getToken(); // consume '.'
+
+		if(peekToken().type != Token::Type::IDENTIFIER)
+			throw std::runtime_error("Missing field name after '.'");
+		const Token& fieldName = getToken();
+
+		if(peekToken().type != Token::Type::EQUAL) { // an expression statement starting with "a.b"
+			tokenProvider.popState();
+			return nullptr;
+		}
+		const Token& equals = getToken(); // consume '='
+
+		const ParseTree::ExpressionNode* expr = expression();
+		if(!expr)
+			throw std::runtime_error("Failed to parse Field Assignment: missing expression");
+
+		if(peekToken().type != Token::Type::SEMICOLON)
+			throw std::runtime_error("Failed to parse Field Assignment: missing semicolon");
+		const Token& semicolon = getToken(); // consume ';'
+
+		tokenProvider.yeetState();
+		return new ParseTree::FieldAssignmentStatement(name, dot, fieldName, equals, expr, semicolon);
+	}
+
 	inline const ParseTree::IfStatement* ifStatement() {
 		tokenProvider.pushState();
 
@@ -287,7 +411,9 @@ public:
 		const Token& closeParen = getToken(); // consume ')'
 
 
+		loopDepth++;
 		const ParseTree::StatementNode* body = statement();
+		loopDepth--;
 		if(!body) {
 			tokenProvider.popState();
 			return nullptr;
@@ -301,15 +427,173 @@ public:
 		return new ParseTree::WhileStatement(whileToken, openParen, condition, closeParen, body);
 	}
 
-	inline const ParseTree::ArgumentsNode* argumentList() {
-		static constexpr auto isTypename = [](const Token& token) { const Token::Type type = token.type; return type == Token::Type::BOOL || type == Token::Type::INT || type == Token::Type::FLOAT || type == Token::Type::STRING; };
+	inline const ParseTree::ForStatement* forStatement() {
+		if(peekToken().type != Token::Type::FOR)
+			return nullptr;
+
+		const Token& forToken = getToken(); // consume 'for'
+
+		if(peekToken().type != Token::Type::PAREN_OPEN)
+			throw std::runtime_error("Missing '(' after 'for'");
+		const Token& openParen = getToken(); // consume '('
+
+
+		// init: declaration, assignment or empty (each including the first ';')
+		Token initSemicolon;
+		const ParseTree::StatementNode* init = variableDeclaration();
+		if(!init)
+			init = variableAssignment();
+		if(!init) {
+			if(peekToken().type != Token::Type::SEMICOLON)
+				throw std::runtime_error("Invalid initialization statement in for loop");
+			initSemicolon = getToken(); // consume ';'
+		}
+
+
+		const ParseTree::ExpressionNode* condition = expression(); // empty condition is allowed
+
+		if(peekToken().type != Token::Type::SEMICOLON)
+			throw std::runtime_error("Missing ';' after for loop condition");
+		const Token& conditionSemicolon = getToken(); // consume ';'
 
+
+		Token stepName, stepEquals;
+		const ParseTree::ExpressionNode* stepExpr = nullptr;
+		if(peekToken().type == Token::Type::IDENTIFIER) {
+			stepName = getToken(); // consume variable name
+
+			if(peekToken().type != Token::Type::EQUAL)
+				throw std::runtime_error("For loop step must be an assignment");
+			stepEquals = getToken(); // consume '='
+
+			stepExpr = expression();
+			if(!stepExpr)
+				throw std::runtime_error("Missing expression in for loop step");
+		}
+
+
+		if(peekToken().type != Token::Type::PAREN_CLOSE)
+			throw std::runtime_error("Missing ')' after for loop header");
+		const Token& closeParen = getToken(); // consume ')'
+
+
+		loopDepth++;
+		const ParseTree::StatementNode* body = statement();
+		loopDepth--;
+		if(!body)
+			throw std::runtime_error("Missing for loop body");
+
+		// Prevent block inside For-Statement from creating an additional Scope (the loop has its own scope)
+		if(body->type() == ParseTree::StatementNode::Type::BLOCK_STATEMENT)
+			dynamic_cast<const ParseTree::BlockStatement*>(body)->createScope = false;
+
+		return new ParseTree::ForStatement(forToken, openParen, init, initSemicolon, condition, conditionSemicolon, stepName, stepEquals, stepExpr, closeParen, body);
+	}
+
+	inline const ParseTree::SwitchStatement* switchStatement() {
+		if(peekToken().type != Token::Type::SWITCH)
+			return nullptr;
+
+		const Token& switchToken = getToken(); // consume 'switch'
+
+		if(peekToken().type != Token::Type::PAREN_OPEN)
+			throw std::runtime_error("Missing '(' after 'switch'");
+		const Token& openParen = getToken(); // consume '('
+
+		const ParseTree::ExpressionNode* value = expression();
+		if(!value)
+			throw std::runtime_error("Missing expression in switch statement");
+
+		if(peekToken().type != Token::Type::PAREN_CLOSE)
+			throw std::runtime_error("Missing ')' after switch expression");
+		const Token& closeParen = getToken(); // consume ')'
+
+		if(peekToken().type != Token::Type::BRACE_OPEN)
+			throw std::runtime_error("Missing '{' after switch header");
+		const Token& openBrace = getToken(); // consume '{'
+
+
+		std::vector<ParseTree::SwitchStatement::Section> sections;
+
+		switchDepth++;
+		while(peekToken().type == Token::Type::CASE || peekToken().type == Token::Type::DEFAULT) {
+			ParseTree::SwitchStatement::Section section;
+
+			while(peekToken().type == Token::Type::CASE || peekToken().type == Token::Type::DEFAULT) {
+				ParseTree::SwitchStatement::Label label;
+				label.keyword = getToken(); // consume 'case' / 'default'
+
+				if(!label.isDefault()) {
+					if(peekToken().type == Token::Type::MINUS)
+						label.sign = getToken(); // consume '-'
+
+					if(peekToken().type != Token::Type::INT_LITERAL)
+						throw std::runtime_error("Case label must be an integer constant");
+					label.value = getToken(); // consume value
+				}
+
+				if(peekToken().type != Token::Type::COLON)
+					throw std::runtime_error("Missing ':' after case label");
+				label.colon = getToken(); // consume ':'
+
+				section.labels.push_back(label);
+			}
+
+			while(const ParseTree::StatementNode* stm = statement())
+				section.statements.push_back(stm);
+
+			sections.push_back(section);
+		}
+		switchDepth--;
+
+		if(peekToken().type != Token::Type::BRACE_CLOSE)
+			throw std::runtime_error("Switch did not end with '}'");
+		const Token& closeBrace = getToken(); // consume '}'
+
+		return new ParseTree::SwitchStatement(switchToken, openParen, value, closeParen, openBrace, sections, closeBrace);
+	}
+
+	inline const ParseTree::BreakStatement* breakStatement() {
+		if(peekToken().type != Token::Type::BREAK)
+			return nullptr;
+
+		if(loopDepth == 0 && switchDepth == 0)
+			throw std::runtime_error("'break' statement not within a loop or switch");
+
+		const Token& breakToken = getToken(); // consume 'break'
+
+		if(peekToken().type != Token::Type::SEMICOLON)
+			throw std::runtime_error("Missing semicolon after 'break'");
+
+		const Token& semicolon = getToken(); // consume ';'
+
+		return new ParseTree::BreakStatement(breakToken, semicolon);
+	}
+
+	inline const ParseTree::ContinueStatement* continueStatement() {
+		if(peekToken().type != Token::Type::CONTINUE)
+			return nullptr;
+
+		if(loopDepth == 0)
+			throw std::runtime_error("'continue' statement not within a loop");
+
+		const Token& continueToken = getToken(); // consume 'continue'
+
+		if(peekToken().type != Token::Type::SEMICOLON)
+			throw std::runtime_error("Missing semicolon after 'continue'");
+
+		const Token& semicolon = getToken(); // consume ';'
+
+		return new ParseTree::ContinueStatement(continueToken, semicolon);
+	}
+
+	inline const ParseTree::ArgumentsNode* argumentList() {
 		std::vector<ParseTree::ArgumentsNode::Argument> args;
 		std::vector<Token> commas;
 
 		tokenProvider.pushState();
 
-		if(!isTypename(peekToken())) {
+		if(!isTypename(peekToken()) && peekToken().type != Token::Type::IDENTIFIER) {
 			tokenProvider.yeetState();
 			return new ParseTree::ArgumentsNode(args, commas);
 		}
@@ -317,11 +601,10 @@ public:
 		for(;;) {
 			ParseTree::ArgumentsNode::Argument arg;
 			
-			if(!isTypename(peekToken())) {
+			if(!typeName(arg.type)) { // consume argument type
 				tokenProvider.popState();
 				return nullptr;
 			}
-			arg.type = getToken(); // consume argument type
 
 			if(peekToken().type != Token::Type::IDENTIFIER) {
 				tokenProvider.popState();
@@ -341,15 +624,13 @@ public:
 	}
 
 	inline const ParseTree::FunctionDeclarationStatement* functionDeclaration() {
-		static constexpr auto isTypename = [](const Token& token) { const Token::Type type = token.type; return type == Token::Type::VOID || type == Token::Type::BOOL || type == Token::Type::INT || type == Token::Type::FLOAT || type == Token::Type::STRING; };
-
 		tokenProvider.pushState();
 
-		if(!isTypename(peekToken())) {
+		Token returnType;
+		if(!typeName(returnType, true)) { // consume typename
 			tokenProvider.popState();
 			return nullptr;
 		}
-		const Token& typeName = getToken(); // consume typename
 
 
 		if(peekToken().type != Token::Type::IDENTIFIER) {
@@ -380,7 +661,12 @@ public:
 		const Token& closeParen = getToken(); // consume ')'
 
 
+		const size_t outerLoopDepth = loopDepth, outerSwitchDepth = switchDepth; // loops and switches do not extend into function bodies
+		loopDepth = 0;
+		switchDepth = 0;
 		const ParseTree::StatementNode* body = statement();
+		loopDepth = outerLoopDepth;
+		switchDepth = outerSwitchDepth;
 		if(!body) {
 			tokenProvider.popState();
 			return nullptr;
@@ -391,7 +677,39 @@ public:
 			dynamic_cast<const ParseTree::BlockStatement*>(body)->createScope = false;
 
 		tokenProvider.yeetState();
-		return new ParseTree::FunctionDeclarationStatement(typeName, name, openParen, args, closeParen, body);
+		return new ParseTree::FunctionDeclarationStatement(returnType, name, openParen, args, closeParen, body);
+	}
+
+
+	inline const ParseTree::StructDeclarationStatement* structDeclaration() {
+		if(peekToken().type != Token::Type::STRUCT)
+			return nullptr;
+		const Token& structToken = getToken(); // consume 'struct'
+
+		if(peekToken().type != Token::Type::IDENTIFIER)
+			throw std::runtime_error("Missing struct name after 'struct'");
+		const Token& name = getToken();
+
+		if(peekToken().type != Token::Type::BRACE_OPEN)
+			throw std::runtime_error("Missing '{' after struct name \"" + name.value + "\"");
+		const Token& openBrace = getToken(); // consume '{'
+
+		std::vector<ParseTree::StructDeclarationStatement::Field> fields;
+		while(peekToken().type != Token::Type::BRACE_CLOSE) {
+			ParseTree::StructDeclarationStatement::Field field;
+			if(!typeName(field.type)) // consume field type
+				throw std::runtime_error("Missing field type in struct \"" + name.value + "\"");
+			if(peekToken().type != Token::Type::IDENTIFIER)
+				throw std::runtime_error("Missing field name in struct \"" + name.value + "\"");
+			field.name = getToken(); // consume field name
+			if(peekToken().type != Token::Type::SEMICOLON)
+				throw std::runtime_error("Missing ';' after field \"" + field.name.value + "\" in struct \"" + name.value + "\"");
+			field.semicolon = getToken(); // consume ';'
+			fields.push_back(field);
+		}
+		const Token& closeBrace = getToken(); // consume '}'
+
+		return new ParseTree::StructDeclarationStatement(structToken, name, openBrace, fields, closeBrace);
 	}
 
 
@@ -450,6 +768,32 @@ public:
 	}
 
 	inline const ParseTree::ExpressionNode* primaryExpression() {
+		const ParseTree::ExpressionNode* a = atomExpression();
+
+		// indexing and field access:
+		while(a && (peekToken().type == Token::Type::SQUARE_OPEN || peekToken().type == Token::Type::DOT)) {
+			if(peekToken().type == Token::Type::DOT) {
+				const Token& dot = getToken(); // consume '.'
+				if(peekToken().type != Token::Type::IDENTIFIER)
+					throw std::runtime_error("Missing field name after '.'");
+				a = new ParseTree::FieldExpressionNode(a, dot, getToken());
+				continue;
+			}
+
+			const Token& openSquare = getToken(); // consume '['
+			const ParseTree::ExpressionNode* index = expression();
+			if(!index)
+				throw std::runtime_error("Missing index expression after '['");
+			if(peekToken().type != Token::Type::SQUARE_CLOSE)
+				throw std::runtime_error("Missing ']' after index expression");
+			const Token& closeSquare = getToken(); // consume ']'
+			a = new ParseTree::IndexExpressionNode(a, openSquare, index, closeSquare);
+		}
+
+		return a;
+	}
+
+	inline const ParseTree::ExpressionNode* atomExpression() {
 		// group:
 		if(peekToken().type == Token::Type::PAREN_OPEN) {
 			const Token& openParen = getToken(); // consume '('
@@ -466,6 +810,10 @@ public:
 		if(const ParseTree::LiteralNode* n = literal())
 			return n;
 
+		// array allocation or literal:
+		if(const ParseTree::ArrayExpressionNode* array = arrayExpression())
+			return array;
+
 		// function call:
 		if(const ParseTree::FunctionCallExpressionNode* f = functionCall())
 			return f;
@@ -483,6 +831,56 @@ public:
 		return nullptr;
 	}
 
+	inline const ParseTree::ArrayExpressionNode* arrayExpression() {
+		// allocation "int[length]":
+		if(isTypename(peekToken())) {
+			tokenProvider.pushState();
+			const Token& type = getToken(); // consume typename
+
+			if(peekToken().type != Token::Type::SQUARE_OPEN) {
+				tokenProvider.popState();
+				return nullptr;
+			}
+			const Token& openSquare = getToken(); // consume '['
+
+			const ParseTree::ExpressionNode* length = expression();
+			if(!length)
+				throw std::runtime_error("Missing length in array allocation");
+
+			if(peekToken().type != Token::Type::SQUARE_CLOSE)
+				throw std::runtime_error("Missing ']' after array length");
+			const Token& closeSquare = getToken(); // consume ']'
+
+			tokenProvider.yeetState();
+			return new ParseTree::ArrayExpressionNode(type, openSquare, length, closeSquare);
+		}
+
+		// literal "[a, b, c]":
+		if(peekToken().type != Token::Type::SQUARE_OPEN)
+			return nullptr;
+		const Token& openSquare = getToken(); // consume '['
+
+		std::vector<const ParseTree::ExpressionNode*> elements;
+		std::vector<Token> commas;
+
+		for(;;) {
+			const ParseTree::ExpressionNode* element = expression();
+			if(!element)
+				throw std::runtime_error("Missing element in array literal");
+			elements.push_back(element);
+
+			if(peekToken().type != Token::Type::COMMA)
+				break;
+			commas.push_back(getToken()); // consume ','
+		}
+
+		if(peekToken().type != Token::Type::SQUARE_CLOSE)
+			throw std::runtime_error("Missing ']' at the end of array literal");
+		const Token& closeSquare = getToken(); // consume ']'
+
+		return new ParseTree::ArrayExpressionNode(openSquare, elements, commas, closeSquare);
+	}
+
 	inline const ParseTree::FunctionCallExpressionNode* functionCall() {
 		// static constexpr auto isTypename = [](const Token& token) { const Token::Type type = token.type; return type == Token::Type::BOOL || type == Token::Type::INT || type == Token::Type::FLOAT || type == Token::Type::STRING; };
 
@@ -0,0 +1,131 @@
+#pragma once
+
+
+#include <stdexcept>
+#include <utility>
+#include <ostream>
+#include <cstdint>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "AllocationCounter.hpp"
+
+
+// wall time, heap allocations and phase specific counters (tokens, nodes, ...) of the compile / run pipeline.
+// Usage:
+//   report.begin("lex");
+//   ImmediateLexer lexer(code);
+//   report.end().add("tokens", lexer.tokenCount());
+class PhaseReport {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	struct Phase {
+		std::string name;
+		double ms;
+		uint64_t allocations;
+		uint64_t bytes;
+		std::vector<std::pair<std::string, uint64_t>> counters;
+
+		inline Phase& add(const std::string& counter, const uint64_t value) {
+			counters.push_back({ counter, value });
+			return *this;
+		}
+	};
+
+private:
+	std::vector<Phase> phases_;
+
+	bool running;
+	std::string currentName;
+	Clock::time_point start;
+	uint64_t startAllocations, startBytes;
+
+public:
+	inline PhaseReport(): running(false), startAllocations(0), startBytes(0) {}
+
+	inline const std::vector<Phase>& phases() const { return phases_; }
+
+	inline void begin(const std::string& name) {
+		if(running)
+			throw std::runtime_error("PhaseReport::begin(): phase \"" + currentName + "\" is still running");
+
+		running = true;
+		currentName = name;
+		startAllocations = AllocationCounter::count;
+		startBytes = AllocationCounter::bytes;
+		start = Clock::now();
+	}
+
+	inline Phase& end() {
+		const Clock::time_point stop = Clock::now();
+
+		if(!running)
+			throw std::runtime_error("PhaseReport::end(): no phase is running");
+		running = false;
+
+		phases_.push_back({
+			currentName,
+			std::chrono::duration<double, std::milli>(stop - start).count(),
+			AllocationCounter::count - startAllocations,
+			AllocationCounter::bytes - startBytes,
+			{}
+		});
+		return phases_.back();
+	}
+
+	inline Phase total() const {
+		Phase res{ "total", 0, 0, 0, {} };
+		for(const Phase& phase : phases_) {
+			res.ms += phase.ms;
+			res.allocations += phase.allocations;
+			res.bytes += phase.bytes;
+		}
+		return res;
+	}
+
+	inline void print(std::ostream& console) const {
+		const auto row = [&](const Phase& phase) {
+			console << "  " << std::setw(10) << std::left << phase.name << std::right
+				<< std::setw(12) << std::fixed << std::setprecision(3) << phase.ms
+				<< std::setw(14) << phase.allocations
+				<< std::setw(14) << phase.bytes;
+			for(const auto& [counter, value] : phase.counters)
+				console << "  " << counter << "=" << value;
+			console << "\n";
+		};
+
+		console << "Phase Report:\n";
+		console << "  " << std::setw(10) << std::left << "phase" << std::right << std::setw(12) << "time ms" << std::setw(14) << "allocations" << std::setw(14) << "bytes" << "\n";
+		for(const Phase& phase : phases_)
+			row(phase);
+		row(total());
+
+		console.unsetf(std::ios::floatfield);
+		console << std::setprecision(6);
+	}
+
+	inline void printJSON(std::ostream& out) const {
+		const auto object = [&](const Phase& phase) {
+			out << "{\"name\":\"" << phase.name << "\",\"ms\":" << std::fixed << std::setprecision(6) << phase.ms
+				<< ",\"allocations\":" << phase.allocations << ",\"bytes\":" << phase.bytes;
+			for(const auto& [counter, value] : phase.counters)
+				out << ",\"" << counter << "\":" << value;
+			out << "}";
+		};
+
+		out << "{\"phases\":[";
+		for(size_t i = 0; i < phases_.size(); i++) {
+			if(i > 0) out << ",";
+			object(phases_[i]);
+		}
+		out << "],\"total\":";
+		object(total());
+		out << "}\n";
+
+		out.unsetf(std::ios::floatfield);
+		out << std::setprecision(6);
+	}
+};
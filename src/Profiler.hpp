@@ -0,0 +1,145 @@
+#pragma once
+
+
+#include <unordered_map>
+#include <algorithm>
+#include <stdexcept>
+#include <ostream>
+#include <cstdint>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+
+
+// Opt-in function profiler for the Interpreter (see Interpreter::setProfiler()).
+// Every script function call is an enter() / exit() pair, keyed by its FunctionDeclarationStatement.
+// Calls are recorded in a call tree (one node per distinct call stack), which gives exclusive time per stack
+// for folded-stack output, and in per-function totals (recursive calls only count once towards inclusive time).
+class Profiler {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	struct FunctionStats {
+		std::string name;
+		uint64_t calls = 0;
+		uint64_t inclusiveNs = 0;
+		uint64_t exclusiveNs = 0;
+		uint32_t active = 0; // number of frames of this function currently on the stack
+	};
+
+private:
+	struct CallNode {
+		const void* key;
+		FunctionStats* stats;
+		CallNode* parent;
+		std::vector<CallNode*> children;
+		uint64_t calls = 0;
+		uint64_t exclusiveNs = 0;
+	};
+
+	struct Frame {
+		CallNode* node;
+		Clock::time_point start;
+		uint64_t childNs; // inclusive time of the callees
+	};
+
+private:
+	std::unordered_map<const void*, FunctionStats> functions;
+	CallNode root;
+	std::vector<Frame> stack;
+
+public:
+	inline Profiler(): root{ nullptr, nullptr, nullptr, {} } {}
+	Profiler(const Profiler&) = delete;
+
+	inline ~Profiler() {
+		deleteChildren(&root);
+	}
+
+	inline void enter(const void* key, const std::string& name) {
+		CallNode* parent = stack.empty() ? &root : stack.back().node;
+		CallNode* node = nullptr;
+		for(CallNode* child : parent->children) // functions rarely have more than a handful of distinct callees
+			if(child->key == key) { node = child; break; }
+
+		if(!node) { // first call on this stack
+			FunctionStats& stats = functions[key];
+			if(stats.name.empty())
+				stats.name = name;
+			node = new CallNode{ key, &stats, parent, {} };
+			parent->children.push_back(node);
+		}
+
+		node->stats->active++;
+		stack.push_back({ node, Clock::now(), 0 });
+	}
+
+	inline void exit() {
+		if(stack.empty())
+			throw std::runtime_error("Profiler::exit(): no active frame");
+
+		const Frame frame = stack.back();
+		stack.pop_back();
+
+		const uint64_t elapsed = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - frame.start).count());
+		const uint64_t exclusive = elapsed > frame.childNs ? elapsed - frame.childNs : 0;
+
+		FunctionStats& stats = *frame.node->stats;
+		stats.calls++;
+		stats.exclusiveNs += exclusive;
+		if(--stats.active == 0)
+			stats.inclusiveNs += elapsed; // only the outermost frame of a recursion counts
+
+		frame.node->calls++;
+		frame.node->exclusiveNs += exclusive;
+
+		if(!stack.empty())
+			stack.back().childNs += elapsed;
+	}
+
+	inline std::vector<FunctionStats> stats() const {
+		std::vector<FunctionStats> res;
+		for(const auto& [key, stats] : functions)
+			res.push_back(stats);
+		std::sort(res.begin(), res.end(), [](const FunctionStats& a, const FunctionStats& b) { return a.exclusiveNs > b.exclusiveNs; });
+		return res;
+	}
+
+	// per-function table, sorted by exclusive time
+	inline void print(std::ostream& console) const {
+		console << "Profile:\n";
+		console << std::setw(24) << std::left << "  function" << std::setw(10) << std::right << "calls" << std::setw(16) << "inclusive ms" << std::setw(16) << "exclusive ms" << "\n";
+		for(const FunctionStats& s : stats())
+			console << "  " << std::setw(22) << std::left << s.name << std::setw(10) << std::right << s.calls
+				<< std::setw(16) << std::fixed << std::setprecision(3) << s.inclusiveNs / 1e6
+				<< std::setw(16) << s.exclusiveNs / 1e6 << "\n";
+		console.unsetf(std::ios::floatfield);
+		console << std::setprecision(6);
+	}
+
+	// one line per call stack: "outer;inner;innermost <exclusive ns>" (input format of flamegraph.pl / speedscope / inferno)
+	inline void writeFolded(std::ostream& out) const {
+		for(const CallNode* child : root.children)
+			writeFolded(out, child, "");
+	}
+
+private:
+	inline static void writeFolded(std::ostream& out, const CallNode* node, const std::string& prefix) {
+		const std::string path = prefix.empty() ? node->stats->name : prefix + ";" + node->stats->name;
+
+		if(node->exclusiveNs > 0)
+			out << path << " " << node->exclusiveNs << "\n";
+
+		for(const CallNode* child : node->children)
+			writeFolded(out, child, path);
+	}
+
+	inline static void deleteChildren(CallNode* node) {
+		for(CallNode* child : node->children) {
+			deleteChildren(child);
+			delete child;
+		}
+		node->children.clear();
+	}
+};
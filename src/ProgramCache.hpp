@@ -0,0 +1,131 @@
+#pragma once
+
+
+#include <filesystem>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <fstream>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "CompiledProgram.hpp"
+#include "ProgramImage.hpp"
+#include "MappedFile.hpp"
+#include "Builtins.hpp"
+
+
+// on-disk cache of compiled programs, so a process start can skip the lexer, parser, analyzer and inliner.
+// Entries are ProgramImages named after a hash of ProgramImage::version, the registered builtin signatures and the source.
+// compile() maps the entry and decodes it in place; missing, stale or unreadable entries are compiled and (re)written.
+// Entries are written to a temporary file and renamed, so several processes can share the directory.
+class ProgramCache {
+private:
+	std::filesystem::path directory_;
+	std::atomic<size_t> hits_;
+	std::atomic<size_t> misses_;
+
+public:
+	inline ProgramCache(const std::filesystem::path& directory): directory_(directory), hits_(0), misses_(0) {
+		std::filesystem::create_directories(directory_);
+	}
+
+	ProgramCache(const ProgramCache&) = delete;
+
+	inline const std::filesystem::path& directory() const { return directory_; }
+	inline size_t hits() const { return hits_; }
+	inline size_t misses() const { return misses_; }
+
+	// same as CompiledProgram::compile(), builtins has to outlive the returned program
+	inline std::shared_ptr<const CompiledProgram> compile(const std::string& source, const BuiltinRegistry* builtins = nullptr) {
+		const uint64_t k = key(source, builtins);
+		const std::filesystem::path file = path(k);
+
+		if(std::shared_ptr<const CompiledProgram> program = load(file, k, builtins); program && program->source() == normalized(source)) { // the source check rules out hash collisions
+			hits_++;
+			return program;
+		}
+
+		misses_++;
+		std::shared_ptr<const CompiledProgram> program = CompiledProgram::compile(source, builtins);
+		store(file, ProgramImage::write(*program, k));
+		return program;
+	}
+
+	// 64 bit FNV-1a over everything that influences the compilation
+	inline static uint64_t key(const std::string& source, const BuiltinRegistry* builtins) {
+		uint64_t hash = 0xcbf29ce484222325;
+		const auto add = [&](const std::string& s) {
+			for(const char c : s)
+				hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3;
+			hash = (hash ^ 0xFF) * 0x100000001b3; // separator, so ("ab", "c") and ("a", "bc") differ
+		};
+
+		add(std::to_string(ProgramImage::version));
+
+		if(builtins) {
+			std::vector<const Builtin*> sorted;
+			for(const auto& [name, builtin] : builtins->entries())
+				sorted.push_back(builtin);
+			std::sort(sorted.begin(), sorted.end(), [](const Builtin* a, const Builtin* b) { return a->name < b->name; });
+
+			for(const Builtin* builtin : sorted) {
+				add(builtin->name);
+				add(builtin->returnType);
+				for(const std::string& type : builtin->argTypes)
+					add(type);
+			}
+		}
+
+		add(source);
+		return hash;
+	}
+
+	inline std::filesystem::path path(const uint64_t key) const {
+		static constexpr const char* digits = "0123456789abcdef";
+		std::string name(16, '0');
+		for(size_t i = 0; i < 16; i++)
+			name[15 - i] = digits[(key >> (4 * i)) & 0xF];
+		return directory_ / std::filesystem::path(name + ".bccp");
+	}
+
+private:
+	inline static std::string normalized(const std::string& source) {
+		return source.ends_with('\n') ? source : source + "\n"; // as stored by CompiledProgram::compile()
+	}
+
+	inline static std::shared_ptr<const CompiledProgram> load(const std::filesystem::path& file, const uint64_t key, const BuiltinRegistry* builtins) {
+		std::error_code error;
+		if(!std::filesystem::exists(file, error))
+			return nullptr;
+
+		try {
+			MappedFile mapped(file);
+			return ProgramImage::read(mapped.data(), mapped.size(), key, builtins);
+		} catch(const std::exception&) {
+			return nullptr; // truncated or written by another version: compiled again and replaced
+		}
+	}
+
+	// failing to write the cache is not an error, the next run compiles again
+	inline static void store(const std::filesystem::path& file, const std::string& image) {
+		std::filesystem::path temp = file;
+		temp += ".tmp" + std::to_string(std::random_device()());
+
+		{
+			std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+			out.write(image.data(), static_cast<std::streamsize>(image.size()));
+			if(!out)
+				return;
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temp, file, error);
+		if(error)
+			std::filesystem::remove(temp, error);
+	}
+};
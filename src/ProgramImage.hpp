@@ -0,0 +1,909 @@
+#pragma once
+
+
+#include <unordered_map>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <variant>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "CompiledProgram.hpp"
+#include "ScopedSymbolTable.hpp"
+#include "Builtins.hpp"
+#include "Inliner.hpp"
+#include "AST.hpp"
+
+
+// binary image of a CompiledProgram: the source, the symbol tables, the analyzed and inlined AST and the inline report.
+// Layout (native byte order, counts and indices are u32, strings are length prefixed):
+//   header     magic, version, key
+//   source
+//   scopes     name, parent (parents come first)
+//   functions  the FunctionDeclarationStatements, created before everything else (their bodies are patched in at the end)
+//              so the FUNCTION symbols and the call nodes can refer to them
+//   structs    the StructDeclarationStatements (name and fields), for the TYPE symbols and the record and field nodes
+//   symbols    per scope
+//   nodes      all other nodes in post order, so children always refer to lower indices. Shared nodes are stored once.
+//   bodies, root, inline report
+//   checksum   64 bit FNV-1a of everything before it, so truncated or corrupted cache entries are rejected up front
+// read() rebuilds the nodes through their constructors and checks that every expression gets the type it had when
+// it was compiled. Malformed or mismatching images throw. Which bounds checks are elided and which loop bounds are
+// invariant is not stored but derived again by the SemanticAnalyzer, so an image can not switch off bounds checks.
+class ProgramImage {
+public:
+	static constexpr uint32_t magic = 0x50434342; // "BCCP"
+	static constexpr uint32_t version = 7; // bump whenever the AST or one of the front end passes changes
+	static constexpr uint32_t none = UINT32_MAX; // index of an absent node / scope
+
+	inline static std::string write(const CompiledProgram& program, const uint64_t key) {
+		return Writer(program, key).out;
+	}
+
+	// builtins has to provide every builtin the program was compiled with
+	inline static std::shared_ptr<const CompiledProgram> read(const char* data, const size_t size, const uint64_t key, const BuiltinRegistry* builtins) {
+		return Reader(data, size, builtins).read(key);
+	}
+
+	inline static uint64_t checksum(const char* data, const size_t size) {
+		uint64_t hash = 0xcbf29ce484222325;
+		for(size_t i = 0; i < size; i++)
+			hash = (hash ^ static_cast<uint8_t>(data[i])) * 0x100000001b3;
+		return hash;
+	}
+
+private:
+	enum class SymbolKind : uint8_t {
+		STRING, NODE, BUILTIN,
+	};
+
+	class Writer {
+	public:
+		std::string out;
+
+	private:
+		std::unordered_map<const AST::Node*, uint32_t> nodeIndex;
+		std::vector<const AST::FunctionDeclarationStatement*> functions;
+		std::vector<const AST::StructDeclarationStatement*> structs;
+		std::vector<const AST::Node*> nodes; // post order
+		std::unordered_map<const ScopedSymbolTable*, uint32_t> scopeIndex;
+		std::vector<const ScopedSymbolTable*> scopes;
+
+	public:
+		inline Writer(const CompiledProgram& program, const uint64_t key) {
+			collect(program.ast());
+			for(size_t i = 0; i < scopes.size(); i++) // functions and structs only reachable through a symbol
+				for(const auto& [name, symbol] : scopes[i]->entries())
+					if(std::holds_alternative<const AST::Node*>(symbol->type))
+						collect(std::get<const AST::Node*>(symbol->type));
+
+			uint32_t next = 0;
+			for(const AST::FunctionDeclarationStatement* function : functions)
+				nodeIndex[function] = next++;
+			for(const AST::StructDeclarationStatement* decl : structs)
+				nodeIndex[decl] = next++;
+			for(const AST::Node* node : nodes)
+				nodeIndex[node] = next++;
+
+			pod(magic);
+			pod(version);
+			pod(key);
+			string(program.source());
+
+			pod(static_cast<uint32_t>(scopes.size()));
+			for(const ScopedSymbolTable* scope : scopes) {
+				string(scope->name());
+				pod(scope->parent ? scopeIndex.at(scope->parent) : none);
+			}
+
+			pod(static_cast<uint32_t>(functions.size()));
+			for(const AST::FunctionDeclarationStatement* function : functions) {
+				header(function);
+				string(function->typeName);
+				span(function->typeSpan);
+				string(function->functionName);
+				span(function->nameSpan);
+				span(function->argsSpan);
+				pod(static_cast<uint32_t>(function->args.size()));
+				for(const AST::FunctionDeclarationStatement::Argument& arg : function->args) {
+					string(arg.type);
+					span(arg.typeSpan);
+					string(arg.name);
+					span(arg.nameSpan);
+				}
+			}
+
+			pod(static_cast<uint32_t>(structs.size()));
+			for(const AST::StructDeclarationStatement* decl : structs) {
+				header(decl);
+				string(decl->layout.name);
+				span(decl->nameSpan);
+				pod(static_cast<uint32_t>(decl->layout.fields.size()));
+				for(const StructLayout::Field& field : decl->layout.fields) {
+					string(field.name);
+					pod(field.type);
+				}
+			}
+
+			for(const ScopedSymbolTable* scope : scopes) {
+				pod(static_cast<uint32_t>(scope->entries().size()));
+				for(const auto& [name, symbol] : scope->entries())
+					writeSymbol(symbol);
+			}
+
+			pod(static_cast<uint32_t>(nodes.size()));
+			for(const AST::Node* node : nodes)
+				writeNode(node);
+
+			for(const AST::FunctionDeclarationStatement* function : functions)
+				index(function->body);
+			index(program.ast());
+
+			writeEntries(program.inlineReport().inlined);
+			writeEntries(program.inlineReport().skipped);
+			pod(checksum(out.data(), out.size()));
+		}
+
+	private:
+		inline void collectScope(const ScopedSymbolTable* scope) {
+			if(scopeIndex.contains(scope))
+				return;
+			if(scope->parent)
+				collectScope(scope->parent);
+			scopeIndex[scope] = static_cast<uint32_t>(scopes.size());
+			scopes.push_back(scope);
+		}
+
+		inline void collect(const AST::Node* node) {
+			if(nodeIndex.contains(node))
+				return;
+			nodeIndex[node] = none; // numbered once everything is collected
+
+			collectScope(&node->getScope());
+			node->forEachChild([&](const AST::Node* child) { collect(child); });
+			if(const AST::InlinedCallExpressionNode* inlined = dynamic_cast<const AST::InlinedCallExpressionNode*>(node))
+				collect(inlined->function);
+			if(const AST::RecordExpressionNode* record = dynamic_cast<const AST::RecordExpressionNode*>(node))
+				collect(record->declaration);
+			if(const AST::FieldExpressionNode* field = dynamic_cast<const AST::FieldExpressionNode*>(node))
+				collect(field->declaration);
+			if(const AST::FieldAssignmentStatement* assignment = dynamic_cast<const AST::FieldAssignmentStatement*>(node))
+				collect(assignment->declaration);
+
+			if(const AST::FunctionDeclarationStatement* function = dynamic_cast<const AST::FunctionDeclarationStatement*>(node))
+				functions.push_back(function);
+			else if(const AST::StructDeclarationStatement* decl = dynamic_cast<const AST::StructDeclarationStatement*>(node))
+				structs.push_back(decl);
+			else
+				nodes.push_back(node);
+		}
+
+		template<typename T>
+		inline void pod(const T& value) {
+			out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		inline void string(const std::string& s) {
+			pod(static_cast<uint32_t>(s.size()));
+			out += s;
+		}
+
+		inline void span(const Span& span) {
+			pod(static_cast<uint64_t>(span.start()));
+			pod(static_cast<uint64_t>(span.end()));
+		}
+
+		inline void index(const AST::Node* node) {
+			pod(node ? nodeIndex.at(node) : none);
+		}
+
+		template<typename T>
+		inline void indices(const std::vector<T>& list) {
+			pod(static_cast<uint32_t>(list.size()));
+			for(const AST::Node* node : list)
+				index(node);
+		}
+
+		inline void header(const AST::Node* node) {
+			pod(scopeIndex.at(&node->getScope()));
+			span(node->span());
+		}
+
+		inline void writeSymbol(const Symbol* symbol) {
+			pod(symbol->category);
+			string(symbol->name);
+
+			if(std::holds_alternative<const std::string>(symbol->type)) {
+				pod(SymbolKind::STRING);
+				string(std::get<const std::string>(symbol->type));
+			} else if(std::holds_alternative<const AST::Node*>(symbol->type)) {
+				pod(SymbolKind::NODE);
+				index(std::get<const AST::Node*>(symbol->type));
+			} else {
+				pod(SymbolKind::BUILTIN);
+				string(std::get<const Builtin*>(symbol->type)->name);
+			}
+		}
+
+		inline void writeEntries(const std::vector<InlineReport::Entry>& entries) {
+			pod(static_cast<uint32_t>(entries.size()));
+			for(const InlineReport::Entry& entry : entries) {
+				string(entry.caller);
+				string(entry.callee);
+				pod(static_cast<uint64_t>(entry.calleeSize));
+				span(entry.callSite);
+				string(entry.reason);
+			}
+		}
+
+		inline void writeNode(const AST::Node* node) {
+			pod(node->baseType());
+			if(node->baseType() == AST::Node::BaseType::EXPRESSION)
+				writeNode(dynamic_cast<const AST::ExpressionNode*>(node));
+			else
+				writeNode(dynamic_cast<const AST::StatementNode*>(node));
+		}
+
+		inline void writeNode(const AST::ExpressionNode* node) {
+			pod(node->type());
+			header(node);
+			string(node->evalType().type());
+
+			switch(node->type()) {
+				case AST::ExpressionNode::Type::LITERAL_EXPRESSION: {
+					const AST::LiteralNode* n = dynamic_cast<const AST::LiteralNode*>(node);
+					pod(n->type);
+					switch(n->type) {
+						case AST::LiteralNode::LiteralType::BOOL: pod(static_cast<uint8_t>(dynamic_cast<const AST::BoolLiteralNode*>(n)->value)); return;
+						case AST::LiteralNode::LiteralType::INT: pod(dynamic_cast<const AST::IntLiteralNode*>(n)->value); return;
+						case AST::LiteralNode::LiteralType::FLOAT: pod(dynamic_cast<const AST::FloatLiteralNode*>(n)->value); return;
+						case AST::LiteralNode::LiteralType::STRING: string(dynamic_cast<const AST::StringLiteralNode*>(n)->value); return;
+					}
+					break;
+				}
+
+				case AST::ExpressionNode::Type::VARIABLE_EXPRESSION:
+					string(dynamic_cast<const AST::IdentifierNode*>(node)->name);
+					return;
+
+				case AST::ExpressionNode::Type::UNARY_EXPRESSION: {
+					const AST::UnaryExpressionNode* n = dynamic_cast<const AST::UnaryExpressionNode*>(node);
+					string(n->opString());
+					index(n->a);
+					return;
+				}
+
+				case AST::ExpressionNode::Type::BINARY_EXPRESSION: {
+					const AST::BinaryExpressionNode* n = dynamic_cast<const AST::BinaryExpressionNode*>(node);
+					string(n->opString());
+					index(n->a);
+					index(n->b);
+					return;
+				}
+
+				case AST::ExpressionNode::Type::CALL_EXPRESSION: {
+					const AST::FunctionCallExpressionNode* n = dynamic_cast<const AST::FunctionCallExpressionNode*>(node);
+					string(n->name);
+					span(n->nameSpan);
+					indices(n->args);
+					return;
+				}
+
+				case AST::ExpressionNode::Type::INLINED_CALL_EXPRESSION: {
+					const AST::InlinedCallExpressionNode* n = dynamic_cast<const AST::InlinedCallExpressionNode*>(node);
+					index(n->function);
+					indices(n->bindings);
+					index(n->body);
+					span(n->nameSpan);
+					return;
+				}
+
+				case AST::ExpressionNode::Type::BUILTIN_CALL_EXPRESSION: {
+					const AST::BuiltinCallExpressionNode* n = dynamic_cast<const AST::BuiltinCallExpressionNode*>(node);
+					string(n->builtin->name);
+					span(n->nameSpan);
+					indices(n->args);
+					return;
+				}
+
+				case AST::ExpressionNode::Type::ARRAY_EXPRESSION: {
+					const AST::ArrayExpressionNode* n = dynamic_cast<const AST::ArrayExpressionNode*>(node);
+					string(n->elementType);
+					index(n->length);
+					indices(n->elements);
+					return;
+				}
+
+				case AST::ExpressionNode::Type::INDEX_EXPRESSION: {
+					const AST::IndexExpressionNode* n = dynamic_cast<const AST::IndexExpressionNode*>(node);
+					index(n->array);
+					index(n->index);
+					return;
+				}
+
+				case AST::ExpressionNode::Type::LENGTH_EXPRESSION:
+					index(dynamic_cast<const AST::LengthExpressionNode*>(node)->array);
+					return;
+
+				case AST::ExpressionNode::Type::RECORD_EXPRESSION:
+					index(dynamic_cast<const AST::RecordExpressionNode*>(node)->declaration);
+					return;
+
+				case AST::ExpressionNode::Type::FIELD_EXPRESSION: {
+					const AST::FieldExpressionNode* n = dynamic_cast<const AST::FieldExpressionNode*>(node);
+					index(n->object);
+					index(n->declaration);
+					string(n->fieldName);
+					return;
+				}
+
+				case AST::ExpressionNode::Type::CONCAT_EXPRESSION:
+					indices(dynamic_cast<const AST::ConcatExpressionNode*>(node)->parts);
+					return;
+			}
+
+			throw std::runtime_error("ProgramImage::write(): invalid expression Node type");
+		}
+
+		inline void writeNode(const AST::StatementNode* node) {
+			pod(node->type());
+			header(node);
+
+			switch(node->type()) {
+				case AST::StatementNode::Type::EXPRESSION_STATEMENT:
+					index(dynamic_cast<const AST::ExpressionStatement*>(node)->expr);
+					return;
+
+				case AST::StatementNode::Type::STATEMENT_LIST:
+					indices(dynamic_cast<const AST::StatementList*>(node)->statements);
+					return;
+
+				case AST::StatementNode::Type::RETURN_STATEMENT:
+					index(dynamic_cast<const AST::ReturnStatement*>(node)->expr);
+					return;
+
+				case AST::StatementNode::Type::IF_STATEMENT: {
+					const AST::IfStatement* n = dynamic_cast<const AST::IfStatement*>(node);
+					index(n->condition);
+					index(n->body);
+					return;
+				}
+
+				case AST::StatementNode::Type::WHILE_STATEMENT: {
+					const AST::WhileStatement* n = dynamic_cast<const AST::WhileStatement*>(node);
+					index(n->condition);
+					index(n->body);
+					return;
+				}
+
+				case AST::StatementNode::Type::FOR_STATEMENT: {
+					const AST::ForStatement* n = dynamic_cast<const AST::ForStatement*>(node);
+					index(n->init);
+					index(n->condition);
+					index(n->step);
+					index(n->body);
+					return;
+				}
+
+				case AST::StatementNode::Type::COUNTED_FOR_STATEMENT: {
+					const AST::CountedForStatement* n = dynamic_cast<const AST::CountedForStatement*>(node);
+					index(n->init);
+					index(n->bound);
+					pod(static_cast<uint8_t>(n->inclusive));
+					pod(n->stride);
+					index(n->body);
+					return;
+				}
+
+				case AST::StatementNode::Type::SWITCH_STATEMENT: {
+					const AST::SwitchStatement* n = dynamic_cast<const AST::SwitchStatement*>(node);
+					index(n->value);
+					indices(n->statements);
+					pod(static_cast<uint32_t>(n->labels.size()));
+					for(const AST::SwitchStatement::Label& label : n->labels) {
+						pod(label.value);
+						pod(static_cast<uint64_t>(label.target));
+					}
+					pod(static_cast<uint64_t>(n->defaultTarget));
+					return;
+				}
+
+				case AST::StatementNode::Type::BREAK_STATEMENT:
+				case AST::StatementNode::Type::CONTINUE_STATEMENT:
+					return;
+
+				case AST::StatementNode::Type::FUNCTION_DECLARATION_STATEMENT:
+					break; // stored in the function section
+
+				case AST::StatementNode::Type::VARIABLE_DECLARATION_STATEMENT: {
+					const AST::VariableDeclarationStatement* n = dynamic_cast<const AST::VariableDeclarationStatement*>(node);
+					string(n->typeName);
+					span(n->typeSpan);
+					string(n->varName);
+					span(n->nameSpan);
+					index(n->initialAssignment);
+					return;
+				}
+
+				case AST::StatementNode::Type::VARIABLE_ASSIGNMENT_STATEMENT: {
+					const AST::VariableAssignmentStatement* n = dynamic_cast<const AST::VariableAssignmentStatement*>(node);
+					string(n->varName);
+					span(n->nameSpan);
+					index(n->expr);
+					return;
+				}
+
+				case AST::StatementNode::Type::ELEMENT_ASSIGNMENT_STATEMENT: {
+					const AST::ElementAssignmentStatement* n = dynamic_cast<const AST::ElementAssignmentStatement*>(node);
+					string(n->varName);
+					span(n->nameSpan);
+					index(n->index);
+					index(n->expr);
+					return;
+				}
+
+				case AST::StatementNode::Type::FIELD_ASSIGNMENT_STATEMENT: {
+					const AST::FieldAssignmentStatement* n = dynamic_cast<const AST::FieldAssignmentStatement*>(node);
+					string(n->varName);
+					span(n->nameSpan);
+					index(n->declaration);
+					string(n->fieldName);
+					index(n->expr);
+					return;
+				}
+
+				case AST::StatementNode::Type::STRUCT_DECLARATION_STATEMENT:
+					break; // stored in the struct section
+			}
+
+			throw std::runtime_error("ProgramImage::write(): invalid statement Node type");
+		}
+	};
+
+	class Reader {
+	private:
+		const char* data;
+		const char* end;
+		const BuiltinRegistry* builtins;
+
+		std::vector<ScopedSymbolTable*> scopes;
+		std::vector<AST::FunctionDeclarationStatement*> functions;
+		std::vector<const AST::Node*> nodes; // functions and structs first
+
+	public:
+		inline Reader(const char* data, const size_t size, const BuiltinRegistry* builtins): data(data), end(data + size), builtins(builtins) {}
+
+		inline std::shared_ptr<const CompiledProgram> read(const uint64_t key) {
+			if(static_cast<size_t>(end - data) < sizeof(uint64_t))
+				throw malformed();
+			end -= sizeof(uint64_t);
+			uint64_t sum;
+			std::memcpy(&sum, end, sizeof(sum));
+			if(sum != checksum(data, static_cast<size_t>(end - data)))
+				throw std::runtime_error("ProgramImage::read(): checksum mismatch");
+
+			if(pod<uint32_t>() != magic || pod<uint32_t>() != version || pod<uint64_t>() != key)
+				throw std::runtime_error("ProgramImage::read(): image was written for another version or source");
+
+			std::shared_ptr<CompiledProgram> program(new CompiledProgram(string()));
+			ObjectPool::Activation activation(program->pool);
+
+			const uint32_t scopeCount = pod<uint32_t>();
+			for(uint32_t i = 0; i < scopeCount; i++) {
+				const std::string name = string();
+				const uint32_t parent = pod<uint32_t>();
+				if(parent != none && parent >= i)
+					throw malformed();
+				if((parent == none) != (i == 0)) // the first scope is the global scope, every other one has a parent
+					throw malformed();
+				scopes.push_back(new ScopedSymbolTable(name, parent == none ? nullptr : scopes[parent]));
+			}
+			if(scopes.empty())
+				throw malformed();
+			program->globalScope = scopes[0];
+
+			const uint32_t functionCount = pod<uint32_t>();
+			for(uint32_t i = 0; i < functionCount; i++) {
+				const ScopedSymbolTable* scope = readScope();
+				const Span span = readSpan();
+				const std::string typeName = string();
+				const Span typeSpan = readSpan();
+				const std::string functionName = string();
+				const Span nameSpan = readSpan();
+				const Span argsSpan = readSpan();
+
+				std::vector<AST::FunctionDeclarationStatement::Argument> args(count());
+				for(AST::FunctionDeclarationStatement::Argument& arg : args) {
+					arg.type = string();
+					arg.typeSpan = readSpan();
+					arg.name = string();
+					arg.nameSpan = readSpan();
+				}
+
+				functions.push_back(new AST::FunctionDeclarationStatement(scope, typeName, functionName, args, nullptr, typeSpan, nameSpan, argsSpan));
+				functions.back()->setSpan(span);
+				nodes.push_back(functions.back());
+			}
+
+			const uint32_t structCount = pod<uint32_t>();
+			for(uint32_t i = 0; i < structCount; i++) {
+				const ScopedSymbolTable* scope = readScope();
+				const Span span = readSpan();
+				StructLayout layout(string());
+				const Span nameSpan = readSpan();
+
+				for(uint32_t j = pod<uint32_t>(); j > 0; j--) {
+					const std::string name = string();
+					const StructLayout::FieldType type = pod<StructLayout::FieldType>();
+					if(type > StructLayout::FieldType::FLOAT)
+						throw malformed();
+					layout.add(name, StructLayout::typeName(type)); // recomputes the offsets
+				}
+
+				nodes.push_back(new AST::StructDeclarationStatement(scope, layout, nameSpan));
+				nodes.back()->setSpan(span);
+			}
+
+			for(ScopedSymbolTable* scope : scopes)
+				for(uint32_t i = pod<uint32_t>(); i > 0; i--)
+					scope->declare(readSymbol());
+
+			for(uint32_t i = pod<uint32_t>(); i > 0; i--)
+				nodes.push_back(readNode());
+
+			for(AST::FunctionDeclarationStatement* function : functions)
+				function->body = node<AST::StatementNode>();
+			program->ast_ = node<AST::Node>();
+			program->nodeCount_ = AST::Node::number(program->ast_);
+
+			readEntries(program->inlineReport_.inlined);
+			readEntries(program->inlineReport_.skipped);
+
+			if(data != end)
+				throw malformed();
+			return program;
+		}
+
+	private:
+		inline static std::runtime_error malformed() {
+			return std::runtime_error("ProgramImage::read(): malformed image");
+		}
+
+		template<typename T>
+		inline T pod() {
+			if(static_cast<size_t>(end - data) < sizeof(T))
+				throw malformed();
+			T value;
+			std::memcpy(&value, data, sizeof(T));
+			data += sizeof(T);
+			return value;
+		}
+
+		// length of a list; every element takes at least one byte, so a corrupted count fails before anything is allocated
+		inline uint32_t count() {
+			const uint32_t size = pod<uint32_t>();
+			if(static_cast<size_t>(end - data) < size)
+				throw malformed();
+			return size;
+		}
+
+		inline std::string string() {
+			const uint32_t size = pod<uint32_t>();
+			if(static_cast<size_t>(end - data) < size)
+				throw malformed();
+			std::string res(data, size);
+			data += size;
+			return res;
+		}
+
+		inline Span readSpan() {
+			const uint64_t start = pod<uint64_t>();
+			return Span(static_cast<size_t>(start), static_cast<size_t>(pod<uint64_t>()));
+		}
+
+		inline const ScopedSymbolTable* readScope() {
+			const uint32_t i = pod<uint32_t>();
+			if(i >= scopes.size())
+				throw malformed();
+			return scopes[i];
+		}
+
+		// node of type T with an index read from the image (nullptr if optional and absent)
+		template<typename T>
+		inline const T* node(const bool optional = false) {
+			const uint32_t i = pod<uint32_t>();
+			if(i == none && optional)
+				return nullptr;
+			if(i >= nodes.size())
+				throw malformed();
+			const T* res = dynamic_cast<const T*>(nodes[i]);
+			if(!res)
+				throw malformed();
+			return res;
+		}
+
+		template<typename T>
+		inline std::vector<const T*> nodeList() {
+			std::vector<const T*> res(count());
+			for(const T*& n : res)
+				n = node<T>();
+			return res;
+		}
+
+		inline const Builtin* builtin() {
+			const std::string name = string();
+			const Builtin* res = builtins ? builtins->lookup(name) : nullptr;
+			if(!res)
+				throw std::runtime_error("ProgramImage::read(): builtin \"" + name + "\" is not registered");
+			return res;
+		}
+
+		inline const Symbol* readSymbol() {
+			const Symbol::Category category = pod<Symbol::Category>();
+			if(category > Symbol::Category::BUILTIN)
+				throw malformed();
+			const std::string name = string();
+
+			switch(pod<SymbolKind>()) {
+				case SymbolKind::STRING:
+					return new Symbol(category, name, string());
+				case SymbolKind::NODE: {
+					const uint32_t i = pod<uint32_t>();
+					if(i >= nodes.size()) // only functions and structs are referenced by symbols
+						throw malformed();
+					return new Symbol(category, name, nodes[i]);
+				}
+				case SymbolKind::BUILTIN:
+					return new Symbol(category, name, builtin());
+			}
+			throw malformed();
+		}
+
+		inline void readEntries(std::vector<InlineReport::Entry>& entries) {
+			entries.resize(count());
+			for(InlineReport::Entry& entry : entries) {
+				entry.caller = string();
+				entry.callee = string();
+				entry.calleeSize = static_cast<size_t>(pod<uint64_t>());
+				entry.callSite = readSpan();
+				entry.reason = string();
+			}
+		}
+
+		// the node constructors resolve types and functions through the scope, so check the symbols they use first
+		inline static void require(const ScopedSymbolTable* scope, const std::string& name, const Symbol::Category category) {
+			const Symbol* symbol = scope->lookupRecursive(name);
+			if(!symbol || symbol->category != category)
+				throw malformed();
+		}
+
+		inline const AST::Node* readNode() {
+			const AST::Node::BaseType baseType = pod<AST::Node::BaseType>();
+			const AST::Node* res;
+			if(baseType == AST::Node::BaseType::EXPRESSION)
+				res = readExpression();
+			else if(baseType == AST::Node::BaseType::STATEMENT)
+				res = readStatement();
+			else
+				throw malformed();
+			return res;
+		}
+
+		inline const AST::ExpressionNode* readExpression() {
+			const AST::ExpressionNode::Type type = pod<AST::ExpressionNode::Type>();
+			const ScopedSymbolTable* scope = readScope();
+			const Span span = readSpan();
+			const std::string evalType = string();
+
+			const AST::ExpressionNode* res = readExpression(type, scope);
+			if(res->evalType().type() != evalType) // the symbols resolve differently than during the compilation
+				throw std::runtime_error("ProgramImage::read(): expression type mismatch");
+			res->setSpan(span);
+			return res;
+		}
+
+		inline const AST::ExpressionNode* readExpression(const AST::ExpressionNode::Type type, const ScopedSymbolTable* scope) {
+			switch(type) {
+				case AST::ExpressionNode::Type::LITERAL_EXPRESSION:
+					switch(pod<AST::LiteralNode::LiteralType>()) {
+						case AST::LiteralNode::LiteralType::BOOL: return new AST::BoolLiteralNode(scope, pod<uint8_t>() != 0);
+						case AST::LiteralNode::LiteralType::INT: return new AST::IntLiteralNode(scope, pod<int>());
+						case AST::LiteralNode::LiteralType::FLOAT: return new AST::FloatLiteralNode(scope, pod<float>());
+						case AST::LiteralNode::LiteralType::STRING: return new AST::StringLiteralNode(scope, string());
+					}
+					break;
+
+				case AST::ExpressionNode::Type::VARIABLE_EXPRESSION: {
+					const std::string name = string();
+					require(scope, name, Symbol::Category::VARIABLE);
+					return new AST::IdentifierNode(scope, name);
+				}
+
+				case AST::ExpressionNode::Type::UNARY_EXPRESSION: {
+					const std::string op = string();
+					return new AST::UnaryExpressionNode(scope, op, node<AST::ExpressionNode>());
+				}
+
+				case AST::ExpressionNode::Type::BINARY_EXPRESSION: {
+					const std::string op = string();
+					const AST::ExpressionNode* a = node<AST::ExpressionNode>();
+					const AST::ExpressionNode* b = node<AST::ExpressionNode>();
+					return new AST::BinaryExpressionNode(scope, a, op, b);
+				}
+
+				case AST::ExpressionNode::Type::CALL_EXPRESSION: {
+					const std::string name = string();
+					require(scope, name, Symbol::Category::FUNCTION);
+					const Span nameSpan = readSpan();
+					return new AST::FunctionCallExpressionNode(scope, name, nodeList<AST::ExpressionNode>(), nameSpan);
+				}
+
+				case AST::ExpressionNode::Type::INLINED_CALL_EXPRESSION: {
+					const AST::FunctionDeclarationStatement* function = node<AST::FunctionDeclarationStatement>();
+					const std::vector<const AST::VariableDeclarationStatement*> bindings = nodeList<AST::VariableDeclarationStatement>();
+					const AST::StatementNode* body = node<AST::StatementNode>();
+					return new AST::InlinedCallExpressionNode(scope, function, bindings, body, readSpan());
+				}
+
+				case AST::ExpressionNode::Type::BUILTIN_CALL_EXPRESSION: {
+					const Builtin* b = builtin();
+					const Span nameSpan = readSpan();
+					return new AST::BuiltinCallExpressionNode(scope, b, nodeList<AST::ExpressionNode>(), nameSpan);
+				}
+
+				case AST::ExpressionNode::Type::ARRAY_EXPRESSION: {
+					const std::string elementType = string();
+					const AST::ExpressionNode* length = node<AST::ExpressionNode>(true);
+					return new AST::ArrayExpressionNode(scope, elementType, length, nodeList<AST::ExpressionNode>());
+				}
+
+				case AST::ExpressionNode::Type::INDEX_EXPRESSION: {
+					const AST::ExpressionNode* array = node<AST::ExpressionNode>();
+					const AST::ExpressionNode* index = node<AST::ExpressionNode>();
+					if(!array->evalType().isArray())
+						throw malformed();
+					return new AST::IndexExpressionNode(scope, array, index);
+				}
+
+				case AST::ExpressionNode::Type::LENGTH_EXPRESSION:
+					return new AST::LengthExpressionNode(scope, node<AST::ExpressionNode>());
+
+				case AST::ExpressionNode::Type::RECORD_EXPRESSION:
+					return new AST::RecordExpressionNode(scope, node<AST::StructDeclarationStatement>());
+
+				case AST::ExpressionNode::Type::FIELD_EXPRESSION: {
+					const AST::ExpressionNode* object = node<AST::ExpressionNode>();
+					const AST::StructDeclarationStatement* declaration = node<AST::StructDeclarationStatement>();
+					if(object->evalType().type() != declaration->layout.name)
+						throw malformed();
+					return new AST::FieldExpressionNode(scope, object, declaration, string());
+				}
+
+				case AST::ExpressionNode::Type::CONCAT_EXPRESSION:
+					return new AST::ConcatExpressionNode(scope, nodeList<AST::ExpressionNode>());
+			}
+
+			throw malformed();
+		}
+
+		inline const AST::StatementNode* readStatement() {
+			const AST::StatementNode::Type type = pod<AST::StatementNode::Type>();
+			const ScopedSymbolTable* scope = readScope();
+			const Span span = readSpan();
+
+			const AST::StatementNode* res = readStatement(type, scope);
+			res->setSpan(span);
+			return res;
+		}
+
+		inline const AST::StatementNode* readStatement(const AST::StatementNode::Type type, const ScopedSymbolTable* scope) {
+			switch(type) {
+				case AST::StatementNode::Type::EXPRESSION_STATEMENT:
+					return new AST::ExpressionStatement(scope, node<AST::ExpressionNode>());
+
+				case AST::StatementNode::Type::STATEMENT_LIST:
+					return new AST::StatementList(scope, nodeList<AST::StatementNode>());
+
+				case AST::StatementNode::Type::RETURN_STATEMENT:
+					return new AST::ReturnStatement(scope, node<AST::ExpressionNode>());
+
+				case AST::StatementNode::Type::IF_STATEMENT: {
+					const AST::ExpressionNode* condition = node<AST::ExpressionNode>();
+					return new AST::IfStatement(scope, condition, node<AST::StatementNode>());
+				}
+
+				case AST::StatementNode::Type::WHILE_STATEMENT: {
+					const AST::ExpressionNode* condition = node<AST::ExpressionNode>();
+					return new AST::WhileStatement(scope, condition, node<AST::StatementNode>());
+				}
+
+				case AST::StatementNode::Type::FOR_STATEMENT: {
+					const AST::StatementNode* init = node<AST::StatementNode>(true);
+					const AST::ExpressionNode* condition = node<AST::ExpressionNode>(true);
+					const AST::VariableAssignmentStatement* step = node<AST::VariableAssignmentStatement>(true);
+					return new AST::ForStatement(scope, init, condition, step, node<AST::StatementNode>());
+				}
+
+				case AST::StatementNode::Type::COUNTED_FOR_STATEMENT: {
+					const AST::VariableDeclarationStatement* init = node<AST::VariableDeclarationStatement>();
+					const AST::ExpressionNode* bound = node<AST::ExpressionNode>();
+					const bool inclusive = pod<uint8_t>() != 0;
+					const int stride = pod<int>();
+					const AST::StatementNode* body = node<AST::StatementNode>();
+					if(!init->initialAssignment || init->typeName != "int" || bound->evalType().type() != "int" || stride <= 0)
+						throw malformed(); // the interpreter relies on what SemanticAnalyzer::countedFor() checked
+
+					const AST::CountedForStatement* loop = new AST::CountedForStatement(scope, init, bound, inclusive, stride, SemanticAnalyzer::isLoopInvariant(bound, body), body);
+					SemanticAnalyzer::elideBoundsChecks(loop);
+					return loop;
+				}
+
+				case AST::StatementNode::Type::SWITCH_STATEMENT: {
+					const AST::ExpressionNode* value = node<AST::ExpressionNode>();
+					const std::vector<const AST::StatementNode*> statements = nodeList<AST::StatementNode>();
+
+					std::vector<AST::SwitchStatement::Label> labels(count());
+					for(AST::SwitchStatement::Label& label : labels) {
+						label.value = pod<int>();
+						label.target = static_cast<size_t>(pod<uint64_t>());
+						if(label.target > statements.size())
+							throw malformed();
+					}
+
+					const size_t defaultTarget = static_cast<size_t>(pod<uint64_t>());
+					if(defaultTarget > statements.size())
+						throw malformed();
+					return new AST::SwitchStatement(scope, value, statements, labels, defaultTarget);
+				}
+
+				case AST::StatementNode::Type::BREAK_STATEMENT:
+					return new AST::BreakStatement(scope);
+
+				case AST::StatementNode::Type::CONTINUE_STATEMENT:
+					return new AST::ContinueStatement(scope);
+
+				case AST::StatementNode::Type::FUNCTION_DECLARATION_STATEMENT:
+					break; // only in the function section
+
+				case AST::StatementNode::Type::VARIABLE_DECLARATION_STATEMENT: {
+					const std::string typeName = string();
+					const Span typeSpan = readSpan();
+					const std::string varName = string();
+					const Span nameSpan = readSpan();
+					return new AST::VariableDeclarationStatement(scope, typeName, varName, node<AST::VariableAssignmentStatement>(true), typeSpan, nameSpan);
+				}
+
+				case AST::StatementNode::Type::VARIABLE_ASSIGNMENT_STATEMENT: {
+					const std::string varName = string();
+					const Span nameSpan = readSpan();
+					return new AST::VariableAssignmentStatement(scope, varName, node<AST::ExpressionNode>(), nameSpan);
+				}
+
+				case AST::StatementNode::Type::ELEMENT_ASSIGNMENT_STATEMENT: {
+					const std::string varName = string();
+					require(scope, varName, Symbol::Category::VARIABLE);
+					const Span nameSpan = readSpan();
+					const AST::ExpressionNode* index = node<AST::ExpressionNode>();
+					const AST::ExpressionNode* expr = node<AST::ExpressionNode>();
+					return new AST::ElementAssignmentStatement(scope, varName, index, expr, true, nameSpan);
+				}
+
+				case AST::StatementNode::Type::FIELD_ASSIGNMENT_STATEMENT: {
+					const std::string varName = string();
+					require(scope, varName, Symbol::Category::VARIABLE);
+					const Span nameSpan = readSpan();
+					const AST::StructDeclarationStatement* declaration = node<AST::StructDeclarationStatement>();
+					const std::string fieldName = string();
+					return new AST::FieldAssignmentStatement(scope, varName, declaration, fieldName, node<AST::ExpressionNode>(), nameSpan);
+				}
+
+				case AST::StatementNode::Type::STRUCT_DECLARATION_STATEMENT:
+					break; // only in the struct section
+			}
+
+			throw malformed();
+		}
+	};
+};
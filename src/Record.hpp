@@ -0,0 +1,96 @@
+#pragma once
+
+
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+// field layout of a script struct, computed once by the SemanticAnalyzer. Fields are packed in declaration order
+// without padding, field accesses in the AST carry their offset so they never look up a name at runtime.
+struct StructLayout {
+	enum class FieldType : uint8_t {
+		BOOL, INT, FLOAT,
+	};
+
+	struct Field {
+		std::string name;
+		FieldType type;
+		size_t offset;
+	};
+
+	std::string name;
+	std::vector<Field> fields;
+	size_t size = 0; // bytes of one record
+
+	inline StructLayout(const std::string& name): name(name) {}
+
+	// appends a field after the previous ones, type has to be "bool", "int" or "float"
+	inline void add(const std::string& fieldName, const std::string& type) {
+		if(field(fieldName))
+			throw std::runtime_error("Duplicate field \"" + fieldName + "\" in struct \"" + name + "\"");
+		const FieldType fieldType = fieldTypeOf(type);
+		fields.push_back({ fieldName, fieldType, size });
+		size += sizeOf(fieldType);
+	}
+
+	// nullptr if there is no such field
+	inline const Field* field(const std::string& fieldName) const {
+		for(const Field& f : fields)
+			if(f.name == fieldName)
+				return &f;
+		return nullptr;
+	}
+
+	inline static FieldType fieldTypeOf(const std::string& type) {
+		if(type == "bool") return FieldType::BOOL;
+		if(type == "int") return FieldType::INT;
+		if(type == "float") return FieldType::FLOAT;
+		throw std::runtime_error("Struct fields of type \"" + type + "\" are not supported, expected bool, int or float");
+	}
+
+	inline static const char* typeName(const FieldType type) {
+		switch(type) {
+			case FieldType::BOOL: return "bool";
+			case FieldType::INT: return "int";
+			case FieldType::FLOAT: return "float";
+		}
+		return "<INVALID>";
+	}
+
+	inline static size_t sizeOf(const FieldType type) {
+		switch(type) {
+			case FieldType::BOOL: return sizeof(bool);
+			case FieldType::INT: return sizeof(int);
+			case FieldType::FLOAT: return sizeof(float);
+		}
+		return 0;
+	}
+};
+
+// instance of a struct: the fields in one zero initialized block of layout->size bytes.
+// Fields are unaligned, so they are read and written with memcpy.
+struct Record {
+	const StructLayout* layout;
+	std::unique_ptr<unsigned char[]> bytes;
+
+	inline explicit Record(const StructLayout* layout): layout(layout), bytes(new unsigned char[layout->size]()) {}
+
+	template<typename T>
+	inline T load(const size_t offset) const {
+		T value;
+		std::memcpy(&value, bytes.get() + offset, sizeof(T));
+		return value;
+	}
+
+	template<typename T>
+	inline void store(const size_t offset, const T value) {
+		std::memcpy(bytes.get() + offset, &value, sizeof(T));
+	}
+};
+
+// records are reference values like arrays: copying a Value shares the fields
+using RecordRef = std::shared_ptr<Record>;
@@ -0,0 +1,231 @@
+#pragma once
+
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+
+#include "CompiledProgram.hpp"
+#include "Interpreter.hpp"
+#include "AllocationCounter.hpp"
+#include "Fiber.hpp"
+
+
+// thrown into a script that exceeded one of its Scheduler::Limits
+class ScriptLimitExceeded : public std::runtime_error {
+public:
+	inline ScriptLimitExceeded(const std::string& what): std::runtime_error(what) {}
+};
+
+
+// runs many scripts on a few OS threads. Every script runs on its own Fiber and yields back to the scheduler
+// after a slice of node evaluations; the ready scripts of a thread take turns round robin.
+// A script stays on the thread that started it (see Fiber), new scripts go to whichever thread picks them up first.
+// Its Interpreter and fiber stack are only created when it is started, so queued scripts cost next to nothing.
+class Scheduler {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	struct Limits {
+		uint64_t slice = 1000; // node evaluations per turn
+		uint64_t maxEvaluations = 0; // 0: unlimited
+		std::chrono::nanoseconds maxTime{ 0 }; // time spent running the script, 0: unlimited
+		uint64_t maxLiveBytes = 0; // heap bytes allocated and not yet freed by the script, 0: unlimited (needs BCC_ALLOCATION_COUNTER_IMPLEMENTATION)
+		uint32_t maxCallDepth = 1000; // nested script function calls, 0: unlimited. Has to fit into the Scheduler's stackSize
+	};
+
+	enum class Status : uint8_t {
+		WAITING, SUSPENDED, FINISHED, FAILED, LIMIT_EXCEEDED,
+	};
+
+	class Script {
+	private:
+		friend class Scheduler;
+
+		class NullStream: private std::streambuf, public std::ostream {
+		public:
+			inline NullStream(): std::ostream(this) {}
+		};
+
+		std::shared_ptr<const CompiledProgram> program;
+		Limits limits;
+		size_t stackSize;
+		NullStream null;
+		std::unique_ptr<Interpreter> interpreter_; // created by start(), kept after the script finished for its results
+		std::unique_ptr<Fiber> fiber;
+
+		Status status_;
+		std::string error_;
+		std::chrono::nanoseconds time_;
+		int64_t liveBytes_;
+		Clock::time_point sliceStart;
+		int64_t sliceLive;
+
+	public:
+		inline Script(std::shared_ptr<const CompiledProgram> program_, const Limits& limits, const size_t stackSize):
+			program(std::move(program_)), limits(limits), stackSize(stackSize), status_(Status::WAITING), time_(0), liveBytes_(0), sliceLive(0) {
+			if(limits.maxLiveBytes && !AllocationCounter::installed)
+				throw std::runtime_error("Scheduler::Script::Script(): maxLiveBytes requires a translation unit defining BCC_ALLOCATION_COUNTER_IMPLEMENTATION");
+		}
+
+		Script(const Script&) = delete;
+
+		inline Status status() const { return status_; }
+		inline const std::string& error() const { return error_; }
+		inline std::chrono::nanoseconds time() const { return time_; }
+		inline int64_t liveBytes() const { return liveBytes_; }
+		inline uint64_t evaluations() const { return interpreter_ ? interpreter_->evaluationCount() : 0; }
+
+		// e.g. to read globals() after the script finished. Only touch it while the Scheduler is not running.
+		inline Interpreter& interpreter() {
+			if(!interpreter_)
+				throw std::runtime_error("Scheduler::Script::interpreter(): the script was not started");
+			return *interpreter_;
+		}
+
+	private:
+		// called by the thread that takes the script from the queue, returns false if the script could not be started
+		inline bool start() {
+			try {
+				interpreter_ = std::make_unique<Interpreter>(program, null);
+				interpreter_->setTrace(TraceMode::NONE);
+				interpreter_->setMaxCallDepth(limits.maxCallDepth, [this] {
+					throw ScriptLimitExceeded("script exceeded " + std::to_string(limits.maxCallDepth) + " nested calls");
+				});
+				interpreter_->setYield(std::max<uint64_t>(1, limits.slice), [this] {
+					account();
+					checkLimits();
+					fiber->yield();
+					sliceStart = Clock::now(); // resumed, possibly much later
+					sliceLive = AllocationCounter::live;
+				});
+				fiber = std::make_unique<Fiber>([this] { interpreter_->run(); }, stackSize);
+			} catch(const std::exception& e) {
+				status_ = Status::FAILED;
+				error_ = e.what();
+				fiber.reset();
+				interpreter_.reset();
+				return false;
+			}
+			return true;
+		}
+
+		// the script's memory is what its slices allocated minus what they freed, the thread's other scripts do not count
+		inline void account() {
+			const Clock::time_point now = Clock::now();
+			time_ += now - sliceStart;
+			liveBytes_ += AllocationCounter::live - sliceLive;
+			sliceStart = now;
+			sliceLive = AllocationCounter::live;
+		}
+
+		inline void checkLimits() const {
+			if(limits.maxEvaluations && interpreter_->evaluationCount() > limits.maxEvaluations)
+				throw ScriptLimitExceeded("script exceeded " + std::to_string(limits.maxEvaluations) + " node evaluations");
+			if(limits.maxTime.count() && time_ > limits.maxTime)
+				throw ScriptLimitExceeded("script exceeded " + std::to_string(limits.maxTime.count()) + " ns");
+			if(limits.maxLiveBytes && liveBytes_ > static_cast<int64_t>(limits.maxLiveBytes))
+				throw ScriptLimitExceeded("script exceeded " + std::to_string(limits.maxLiveBytes) + " live bytes");
+		}
+
+		// runs one slice, returns false once the script is done
+		inline bool step() {
+			sliceStart = Clock::now();
+			sliceLive = AllocationCounter::live;
+
+			try {
+				fiber->resume();
+			} catch(const ScriptLimitExceeded& e) {
+				status_ = Status::LIMIT_EXCEEDED;
+				error_ = e.what();
+			} catch(const std::exception& e) {
+				status_ = Status::FAILED;
+				error_ = e.what();
+			}
+			account();
+
+			if(status_ == Status::FAILED || status_ == Status::LIMIT_EXCEEDED)
+				return false;
+			status_ = fiber->finished() ? Status::FINISHED : Status::SUSPENDED;
+			return status_ == Status::SUSPENDED;
+		}
+	};
+
+private:
+	size_t threads;
+	size_t stackSize;
+	size_t maxResident; // started but unfinished scripts per thread
+
+	std::mutex mutex;
+	std::deque<std::shared_ptr<Script>> waiting;
+
+public:
+	// the default stackSize holds the default Limits::maxCallDepth with room to spare (a call takes about 1.5 KB of stack,
+	// 3 KB in debug builds). Stack pages are only committed once a script uses them.
+	inline Scheduler(const size_t threads = std::max(1u, std::thread::hardware_concurrency()), const size_t stackSize = 8 * 1024 * 1024, const size_t maxResident = 64):
+		threads(std::max<size_t>(1, threads)), stackSize(stackSize), maxResident(std::max<size_t>(1, maxResident)) {}
+
+	Scheduler(const Scheduler&) = delete;
+
+	// queues a script, its results can be read from the returned Script once run() returned
+	inline std::shared_ptr<Script> submit(std::shared_ptr<const CompiledProgram> program, const Limits& limits) {
+		std::shared_ptr<Script> script = std::make_shared<Script>(std::move(program), limits, stackSize);
+		std::lock_guard<std::mutex> lock(mutex);
+		waiting.push_back(script);
+		return script;
+	}
+
+	inline std::shared_ptr<Script> submit(std::shared_ptr<const CompiledProgram> program) {
+		return submit(std::move(program), Limits());
+	}
+
+	// runs all submitted scripts to completion (or failure), returns when every thread ran out of work
+	inline void run() {
+		std::vector<std::thread> workers;
+		for(size_t i = 1; i < threads; i++)
+			workers.emplace_back([this] { work(); });
+		work();
+		for(std::thread& worker : workers)
+			worker.join();
+	}
+
+private:
+	inline std::shared_ptr<Script> take() {
+		std::lock_guard<std::mutex> lock(mutex);
+		if(waiting.empty())
+			return nullptr;
+		std::shared_ptr<Script> script = std::move(waiting.front());
+		waiting.pop_front();
+		return script;
+	}
+
+	inline void work() {
+		std::deque<std::shared_ptr<Script>> ready; // started on this thread
+
+		for(;;) {
+			if(ready.size() < maxResident)
+				while(std::shared_ptr<Script> script = take())
+					if(script->start()) {
+						ready.push_back(std::move(script));
+						break;
+					}
+
+			if(ready.empty())
+				return;
+
+			std::shared_ptr<Script> script = std::move(ready.front());
+			ready.pop_front();
+			if(script->step())
+				ready.push_back(std::move(script));
+			else
+				script->fiber.reset(); // frees the stack
+		}
+	}
+};
@@ -8,18 +8,23 @@
 #include <cstdint>
 #include <string>
 
+#include "ObjectPool.hpp"
+
 
 namespace AST { struct Node; };
+struct Builtin;
 
 struct Symbol {
 	enum class Category : uint8_t {
-		TYPE, VARIABLE, FUNCTION,
+		TYPE, VARIABLE, FUNCTION, BUILTIN,
 	} category;
-	using Type = std::variant<const std::string, const AST::Node*>;
+	using Type = std::variant<const std::string, const AST::Node*, const Builtin*>;
 	std::string name;
 	Type type;
-	inline Symbol(const Category category, const std::string& name, const std::string& type): category(category), name(name), type(type) {}
-	inline Symbol(const Category category, const std::string& name, const AST::Node* type): category(category), name(name), type(type) {}
+	inline Symbol(const Category category, const std::string& name, const std::string& type): category(category), name(name), type(type) { ObjectPool::adopt(this); }
+	inline Symbol(const Category category, const std::string& name, const AST::Node* type): category(category), name(name), type(type) { ObjectPool::adopt(this); }
+	inline Symbol(const Category category, const std::string& name, const Builtin* type): category(category), name(name), type(type) { ObjectPool::adopt(this); }
+	inline ~Symbol() { ObjectPool::forget(this); }
 };
 
 class ScopedSymbolTable {
@@ -28,12 +33,15 @@ private:
 	std::unordered_map<std::string, const Symbol*> symbols;
 
 public:
-	ScopedSymbolTable* parent;
+	const ScopedSymbolTable* parent;
 
 public:
-	inline ScopedSymbolTable(const std::string& scopeName, ScopedSymbolTable* parent = nullptr): scopeName(scopeName), parent(parent) {
+	inline ScopedSymbolTable(const std::string& scopeName, const ScopedSymbolTable* parent = nullptr): scopeName(scopeName), parent(parent) {
+		ObjectPool::adopt(this);
 	}
 
+	inline ~ScopedSymbolTable() { ObjectPool::forget(this); }
+
 	inline void declare(const Symbol *const sym) {
 		if(lookup(sym->name))
 			throw std::runtime_error("ScopedSymbolTable::declare(): Tried to redeclare symbol \"" + sym->name + "\"");
@@ -50,6 +58,9 @@ public:
 		symbols[sym->name] = sym;
 	}
 
+	inline const std::string& name() const { return scopeName; }
+	inline const std::unordered_map<std::string, const Symbol*>& entries() const { return symbols; } // symbols declared in this scope
+
 	inline const Symbol* lookup(const std::string& name) const {
 		return symbols.contains(name) ? symbols.at(name) : nullptr;
 	}
@@ -65,7 +76,7 @@ public:
 		console << "Symbol Table:\n";
 		for(const auto& [name, symbol] : symbols) {
 			console << name << ": ";
-			console << (symbol->category==Symbol::Category::TYPE ? "<Type>" : symbol->category==Symbol::Category::VARIABLE ? "<Variable>" : "<Function>");
+			console << (symbol->category==Symbol::Category::TYPE ? "<Type>" : symbol->category==Symbol::Category::VARIABLE ? "<Variable>" : symbol->category==Symbol::Category::BUILTIN ? "<Builtin>" : "<Function>");
 			console << " ";
 
 			if(std::holds_alternative<const std::string>(symbol->type))
@@ -74,6 +85,9 @@ public:
 			if(std::holds_alternative<const AST::Node*>(symbol->type))
 				console << "<AST::Node*>";
 
+			if(std::holds_alternative<const Builtin*>(symbol->type))
+				console << "<Builtin*>";
+
 			console << "\n";
 		}
 	}
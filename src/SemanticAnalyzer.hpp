@@ -3,6 +3,7 @@
 
 #include <stdexcept>
 #include <cstdint>
+#include <unordered_set>
 #include <vector>
 #include <string>
 
@@ -13,6 +14,8 @@
 
 class SemanticAnalyzer {
 private:
+	friend class ProgramImage; // re-derives the loop facts an image does not store
+
 public:
 	inline SemanticAnalyzer() {}
 
@@ -31,17 +34,23 @@ public:
 	inline static const AST::ExpressionNode* visit(const ParseTree::ExpressionNode* node, ScopedSymbolTable* scope) {
 		switch(node->type()) {
 		case ParseTree::ExpressionNode::Type::CALL_EXPRESSION:
-			return visit(dynamic_cast<const ParseTree::FunctionCallExpressionNode*>(node), scope);
+			return spanned(visit(dynamic_cast<const ParseTree::FunctionCallExpressionNode*>(node), scope), node->span());
 		case ParseTree::ExpressionNode::Type::GROUP_EXPRESSION:
-			return visit(dynamic_cast<const ParseTree::GroupExpressionNode*>(node), scope);
+			return spanned(visit(dynamic_cast<const ParseTree::GroupExpressionNode*>(node), scope), node->span());
 		case ParseTree::ExpressionNode::Type::UNARY_EXPRESSION:
-			return visit(dynamic_cast<const ParseTree::UnaryExpressionNode*>(node), scope);
+			return spanned(visit(dynamic_cast<const ParseTree::UnaryExpressionNode*>(node), scope), node->span());
 		case ParseTree::ExpressionNode::Type::BINARY_EXPRESSION:
-			return visit(dynamic_cast<const ParseTree::BinaryExpressionNode*>(node), scope);
+			return spanned(visit(dynamic_cast<const ParseTree::BinaryExpressionNode*>(node), scope), node->span());
 		case ParseTree::ExpressionNode::Type::VARIABLE_EXPRESSION:
-			return visit(dynamic_cast<const ParseTree::IdentifierNode*>(node), scope);
+			return spanned(visit(dynamic_cast<const ParseTree::IdentifierNode*>(node), scope), node->span());
 		case ParseTree::ExpressionNode::Type::LITERAL_EXPRESSION:
-			return visit(dynamic_cast<const ParseTree::LiteralNode*>(node), scope);
+			return spanned(visit(dynamic_cast<const ParseTree::LiteralNode*>(node), scope), node->span());
+		case ParseTree::ExpressionNode::Type::ARRAY_EXPRESSION:
+			return spanned(visit(dynamic_cast<const ParseTree::ArrayExpressionNode*>(node), scope), node->span());
+		case ParseTree::ExpressionNode::Type::INDEX_EXPRESSION:
+			return spanned(visit(dynamic_cast<const ParseTree::IndexExpressionNode*>(node), scope), node->span());
+		case ParseTree::ExpressionNode::Type::FIELD_EXPRESSION:
+			return spanned(visit(dynamic_cast<const ParseTree::FieldExpressionNode*>(node), scope), node->span());
 		}
 
 		// throw std::runtime_error("SemanticAnalyzer::visit(ExpressionNode): invalid expression Node type");
@@ -50,21 +59,35 @@ public:
 	inline static const AST::StatementNode* visit(const ParseTree::StatementNode* node, ScopedSymbolTable* scope) {
 		switch(node->type()) {
 		case ParseTree::StatementNode::Type::VARIABLE_DECLARATION:
-			return visit(dynamic_cast<const ParseTree::VariableDeclarationStatement*>(node), scope);
+			return spanned(visit(dynamic_cast<const ParseTree::VariableDeclarationStatement*>(node), scope), node->span());
 		case ParseTree::StatementNode::Type::VARIABLE_ASSIGNMENT:
-			return visit(dynamic_cast<const ParseTree::VariableAssignmentStatement*>(node), scope);
+			return spanned(visit(dynamic_cast<const ParseTree::VariableAssignmentStatement*>(node), scope), node->span());
+		case ParseTree::StatementNode::Type::ELEMENT_ASSIGNMENT:
+			return spanned(visit(dynamic_cast<const ParseTree::ElementAssignmentStatement*>(node), scope), node->span());
+		case ParseTree::StatementNode::Type::FIELD_ASSIGNMENT:
+			return spanned(visit(dynamic_cast<const ParseTree::FieldAssignmentStatement*>(node), scope), node->span());
 		case ParseTree::StatementNode::Type::EXPRESSION_STATEMENT:
-			return visit(dynamic_cast<const ParseTree::ExpressionStatement*>(node), scope);
+			return spanned(visit(dynamic_cast<const ParseTree::ExpressionStatement*>(node), scope), node->span());
 		case ParseTree::StatementNode::Type::BLOCK_STATEMENT:
-			return visit(dynamic_cast<const ParseTree::BlockStatement*>(node), scope);
+			return spanned(visit(dynamic_cast<const ParseTree::BlockStatement*>(node), scope), node->span());
 		case ParseTree::StatementNode::Type::RETURN_STATEMENT:
-			return visit(dynamic_cast<const ParseTree::ReturnStatement*>(node), scope);
+			return spanned(visit(dynamic_cast<const ParseTree::ReturnStatement*>(node), scope), node->span());
 		case ParseTree::StatementNode::Type::IF_STATEMENT:
-			return visit(dynamic_cast<const ParseTree::IfStatement*>(node), scope);
+			return spanned(visit(dynamic_cast<const ParseTree::IfStatement*>(node), scope), node->span());
 		case ParseTree::StatementNode::Type::WHILE_STATEMENT:
-			return visit(dynamic_cast<const ParseTree::WhileStatement*>(node), scope);
+			return spanned(visit(dynamic_cast<const ParseTree::WhileStatement*>(node), scope), node->span());
+		case ParseTree::StatementNode::Type::FOR_STATEMENT:
+			return spanned(visit(dynamic_cast<const ParseTree::ForStatement*>(node), scope), node->span());
+		case ParseTree::StatementNode::Type::SWITCH_STATEMENT:
+			return spanned(visit(dynamic_cast<const ParseTree::SwitchStatement*>(node), scope), node->span());
+		case ParseTree::StatementNode::Type::BREAK_STATEMENT:
+			return spanned(new AST::BreakStatement(scope), node->span());
+		case ParseTree::StatementNode::Type::CONTINUE_STATEMENT:
+			return spanned(new AST::ContinueStatement(scope), node->span());
 		case ParseTree::StatementNode::Type::FUNCTION_DECLARATION:
-			return visit(dynamic_cast<const ParseTree::FunctionDeclarationStatement*>(node), scope);
+			return spanned(visit(dynamic_cast<const ParseTree::FunctionDeclarationStatement*>(node), scope), node->span());
+		case ParseTree::StatementNode::Type::STRUCT_DECLARATION:
+			return spanned(visit(dynamic_cast<const ParseTree::StructDeclarationStatement*>(node), scope), node->span());
 		}
 
 		// throw std::runtime_error("SemanticAnalyzer::visit(StatementNode): invalid statement Node type");
@@ -74,18 +97,42 @@ public:
 	// Expressions:
 	inline static const AST::ExpressionNode* visit(const ParseTree::FunctionCallExpressionNode* node, ScopedSymbolTable* scope) {
 		const std::string& name = node->name.value;
+
+		std::vector<const AST::ExpressionNode*> astArgs;
+		for(const ParseTree::ExpressionNode* arg : node->args)
+			astArgs.push_back(visit(arg, scope));
+
+		// len() of an array is part of the language, other arguments go to a function or builtin of that name
+		if(name == "len" && astArgs.size() == 1 && astArgs[0]->evalType().isArray())
+			return new AST::LengthExpressionNode(scope, astArgs[0]);
+
 		if(!scope->lookupRecursive(name))
 			throw std::runtime_error("Tried to call unknown function \"" + name + "\"");
 
+		if(scope->lookupRecursive(name)->category == Symbol::Category::BUILTIN)
+			return visitBuiltinCall(astArgs, std::get<const Builtin*>(scope->lookupRecursive(name)->type), scope, node->name.span);
+
 		if(scope->lookupRecursive(name)->category != Symbol::Category::FUNCTION)
 			throw std::runtime_error("Symbol \"" + name + "\" in Function call expression does not refer to a function.");
-		
-		std::vector<const AST::ExpressionNode*> astArgs;
-		for(const ParseTree::ExpressionNode* arg : node->args)
-			astArgs.push_back(visit(arg, scope));
 
-		return new AST::FunctionCallExpressionNode(scope, name, astArgs);
+		const AST::FunctionDeclarationStatement* function = dynamic_cast<const AST::FunctionDeclarationStatement*>(std::get<const AST::Node*>(scope->lookupRecursive(name)->type));
+		for(size_t i = 0; i < astArgs.size() && i < function->args.size(); i++)
+			checkReferenceAssignment(function->args[i].type, astArgs[i]->evalType(), "argument " + std::to_string(i + 1) + " of \"" + name + "\"");
+
+		return new AST::FunctionCallExpressionNode(scope, name, astArgs, node->name.span);
+
+	}
+
+	inline static const AST::ExpressionNode* visitBuiltinCall(const std::vector<const AST::ExpressionNode*>& astArgs, const Builtin* builtin, ScopedSymbolTable* scope, const Span& nameSpan) {
+		if(astArgs.size() != builtin->argTypes.size())
+			throw std::runtime_error("Builtin \"" + builtin->name + "\" expects " + std::to_string(builtin->argTypes.size()) + " arguments, got " + std::to_string(astArgs.size()));
+
+		for(size_t i = 0; i < astArgs.size(); i++) {
+			if(!isImplicitlyConvertible(astArgs[i]->evalType(), EvalType(builtin->argTypes[i])))
+				throw std::runtime_error("Argument " + std::to_string(i + 1) + " of builtin \"" + builtin->name + "\": can not convert " + astArgs[i]->evalType().type() + " to " + builtin->argTypes[i]);
+		}
 
+		return new AST::BuiltinCallExpressionNode(scope, builtin, astArgs, nameSpan);
 	}
 
 	inline static const AST::ExpressionNode* visit(const ParseTree::GroupExpressionNode* node, ScopedSymbolTable* scope) {
@@ -93,17 +140,40 @@ public:
 	}
 
 	inline static const AST::ExpressionNode* visit(const ParseTree::UnaryExpressionNode* node, ScopedSymbolTable* scope) {
-		return new AST::UnaryExpressionNode(scope, node->op.value, visit(node->a, scope));
+		const AST::ExpressionNode* a = visit(node->a, scope);
+		if(!a->evalType().isPrimitive())
+			throw std::runtime_error("Unary operator " + node->op.value + " is not defined for arrays and structs");
+		return new AST::UnaryExpressionNode(scope, node->op.value, a);
 	}
 
 	inline static const AST::ExpressionNode* visit(const ParseTree::BinaryExpressionNode* node, ScopedSymbolTable* scope) {
-		return new AST::BinaryExpressionNode(scope, visit(node->a, scope), node->op.value, visit(node->b, scope));
+		const AST::ExpressionNode* a = visit(node->a, scope);
+		const AST::ExpressionNode* b = visit(node->b, scope);
+		if(node->op.value == "+" && a->evalType().type() == "string")
+			return concat(scope, a, b);
+		return new AST::BinaryExpressionNode(scope, a, node->op.value, b);
+	}
+
+	// string + x, extends the chain a already is (and appends the chain b is, appending is associative)
+	inline static const AST::ExpressionNode* concat(ScopedSymbolTable* scope, const AST::ExpressionNode* a, const AST::ExpressionNode* b) {
+		std::vector<const AST::ExpressionNode*> parts;
+		for(const AST::ExpressionNode* operand : { a, b }) {
+			if(const AST::ConcatExpressionNode* chain = dynamic_cast<const AST::ConcatExpressionNode*>(operand)) {
+				parts.insert(parts.end(), chain->parts.begin(), chain->parts.end());
+				delete chain;
+			} else {
+				parts.push_back(operand);
+			}
+		}
+		return new AST::ConcatExpressionNode(scope, parts);
 	}
 
 	inline static const AST::ExpressionNode* visit(const ParseTree::IdentifierNode* node, ScopedSymbolTable* scope) {
 		const std::string& name = node->name.value;
 		if(!scope->lookupRecursive(name))
 			throw std::runtime_error("Use of undeclared identifier \"" + name + "\"");
+		if(scope->lookupRecursive(name)->category != Symbol::Category::VARIABLE)
+			throw std::runtime_error("\"" + name + "\" is not a variable");
 		
 		return new AST::IdentifierNode(scope, name);
 	}
@@ -125,14 +195,65 @@ public:
 		throw std::runtime_error("Error generating literal AST Node: Token is not a known literal type");
 	}
 
+	inline static const AST::ExpressionNode* visit(const ParseTree::ArrayExpressionNode* node, ScopedSymbolTable* scope) {
+		static constexpr auto isElementType = [](const std::string& type) { return type == "bool" || type == "int" || type == "float"; };
+
+		if(!node->isLiteral()) {
+			const std::string& elementType = node->typeName.value;
+			if(!isElementType(elementType))
+				throw std::runtime_error("Arrays of type \"" + elementType + "\" are not supported");
+
+			const AST::ExpressionNode* length = visit(node->length, scope);
+			if(!isImplicitlyConvertible(length->evalType(), EvalType("int")))
+				throw std::runtime_error("Array length must be an int, got \"" + length->evalType().type() + "\"");
+
+			return new AST::ArrayExpressionNode(scope, elementType, length, {});
+		}
+
+		// the element type of a literal is the widest element type: bool < int < float
+		std::vector<const AST::ExpressionNode*> elements;
+		std::string elementType = "bool";
+		for(const ParseTree::ExpressionNode* element : node->elements) {
+			elements.push_back(visit(element, scope));
+
+			const std::string& type = elements.back()->evalType().type();
+			if(!isElementType(type))
+				throw std::runtime_error("Array literal element of type \"" + type + "\", expected bool, int or float");
+			if(type == "float" || (type == "int" && elementType == "bool"))
+				elementType = type;
+		}
+
+		return new AST::ArrayExpressionNode(scope, elementType, nullptr, elements);
+	}
+
+	inline static const AST::ExpressionNode* visit(const ParseTree::IndexExpressionNode* node, ScopedSymbolTable* scope) {
+		const AST::ExpressionNode* array = visit(node->array, scope);
+		if(!array->evalType().isArray())
+			throw std::runtime_error("Indexed expression is not an array, got \"" + array->evalType().type() + "\"");
+
+		const AST::ExpressionNode* index = visit(node->index, scope);
+		if(!isImplicitlyConvertible(index->evalType(), EvalType("int")))
+			throw std::runtime_error("Array index must be an int, got \"" + index->evalType().type() + "\"");
+
+		return new AST::IndexExpressionNode(scope, array, index);
+	}
+
+	inline static const AST::ExpressionNode* visit(const ParseTree::FieldExpressionNode* node, ScopedSymbolTable* scope) {
+		const AST::ExpressionNode* object = visit(node->object, scope);
+		const AST::StructDeclarationStatement* declaration = structOf(scope, object->evalType().type());
+		if(!declaration)
+			throw std::runtime_error("Field access \"." + node->fieldName.value + "\" on a value of type \"" + object->evalType().type() + "\", which is not a struct");
+
+		return new AST::FieldExpressionNode(scope, object, declaration, node->fieldName.value);
+	}
+
 
 	// Statments:
 	inline static const AST::StatementNode* visit(const ParseTree::VariableDeclarationStatement* node, ScopedSymbolTable* scope) {
 		const std::string& typeName = node->typeName.value;
 		const std::string& varName = node->varName.value;
 		
-		if(!scope->lookupRecursive(typeName))
-			throw std::runtime_error("Unknown typename \"" + typeName + "\" in declaration of \"" + varName + "\"");
+		checkTypename(scope, typeName, "declaration of \"" + varName + "\"");
 		if(scope->lookup(varName))
 			throw std::runtime_error("Redeclaration of symbol \"" + varName + "\" in variable declaration");
 
@@ -141,24 +262,77 @@ public:
 		scope->declare(new Symbol(Symbol::Category::VARIABLE, varName, typeName));
 		
 		if(!node->expr) {
-			return new AST::VariableDeclarationStatement(scope, typeName, varName);
+			const AST::StructDeclarationStatement* declaration = structOf(scope, typeName);
+			if(!declaration)
+				return new AST::VariableDeclarationStatement(scope, typeName, varName, node->typeName.span, node->varName.span);
+
+			// "Point p;" creates a new record
+			const AST::ExpressionNode* record = spanned(new AST::RecordExpressionNode(scope, declaration), node->span());
+			const AST::VariableAssignmentStatement* assignment = spanned(new AST::VariableAssignmentStatement(scope, varName, record, node->varName.span), node->span());
+			return new AST::VariableDeclarationStatement(scope, typeName, varName, assignment, node->typeName.span, node->varName.span);
 		}
 
 		const AST::ExpressionNode* expr = visit(node->expr, scope);
-		const AST::VariableAssignmentStatement* assignment = new AST::VariableAssignmentStatement(scope, varName, expr);
-		return new AST::VariableDeclarationStatement(scope, typeName, varName, assignment);
+		checkReferenceAssignment(typeName, expr->evalType(), "\"" + varName + "\"");
+		const AST::VariableAssignmentStatement* assignment = spanned(new AST::VariableAssignmentStatement(scope, varName, expr, node->varName.span), node->span());
+		return new AST::VariableDeclarationStatement(scope, typeName, varName, assignment, node->typeName.span, node->varName.span);
 	}
 
 	inline static const AST::StatementNode* visit(const ParseTree::VariableAssignmentStatement* node, ScopedSymbolTable* scope) {
 		const std::string& varName = node->varName.value;
 		
-		if(!scope->lookup(varName))
+		const Symbol* sym = scope->lookupRecursive(varName);
+		if(!sym || sym->category != Symbol::Category::VARIABLE)
 			throw std::runtime_error("Assignment to unknown variable \"" + varName + "\"");
 
 		// TODO: type checking (including implicit type conversions)
 
 		const AST::ExpressionNode* expr = visit(node->expr, scope);
-		const AST::VariableAssignmentStatement* assignment = new AST::VariableAssignmentStatement(scope, varName, expr);
+		checkReferenceAssignment(std::get<const std::string>(sym->type), expr->evalType(), "\"" + varName + "\"");
+		const AST::VariableAssignmentStatement* assignment = new AST::VariableAssignmentStatement(scope, varName, expr, node->varName.span);
+		return assignment;
+	}
+
+	inline static const AST::StatementNode* visit(const ParseTree::ElementAssignmentStatement* node, ScopedSymbolTable* scope) {
+		const std::string& varName = node->varName.value;
+
+		const Symbol* sym = scope->lookupRecursive(varName);
+		if(!sym || sym->category != Symbol::Category::VARIABLE)
+			throw std::runtime_error("Assignment to unknown variable \"" + varName + "\"");
+
+		const EvalType type(std::get<const std::string>(sym->type));
+		if(!type.isArray())
+			throw std::runtime_error("Element assignment to \"" + varName + "\", which is not an array");
+
+		const AST::ExpressionNode* index = visit(node->index, scope);
+		if(!isImplicitlyConvertible(index->evalType(), EvalType("int")))
+			throw std::runtime_error("Array index must be an int, got \"" + index->evalType().type() + "\"");
+
+		const AST::ExpressionNode* expr = visit(node->expr, scope);
+		if(!isImplicitlyConvertible(expr->evalType(), type.elementType()))
+			throw std::runtime_error("Can not assign " + expr->evalType().type() + " to an element of \"" + varName + "\" (" + type.type() + ")");
+
+		return new AST::ElementAssignmentStatement(scope, varName, index, expr, true, node->varName.span);
+	}
+
+	inline static const AST::StatementNode* visit(const ParseTree::FieldAssignmentStatement* node, ScopedSymbolTable* scope) {
+		const std::string& varName = node->varName.value;
+
+		const Symbol* sym = scope->lookupRecursive(varName);
+		if(!sym || sym->category != Symbol::Category::VARIABLE)
+			throw std::runtime_error("Assignment to unknown variable \"" + varName + "\"");
+
+		const std::string& type = std::get<const std::string>(sym->type);
+		const AST::StructDeclarationStatement* declaration = structOf(scope, type);
+		if(!declaration)
+			throw std::runtime_error("Field assignment to \"" + varName + "\", which is not a struct");
+
+		const AST::ExpressionNode* expr = visit(node->expr, scope);
+		const AST::FieldAssignmentStatement* assignment = new AST::FieldAssignmentStatement(scope, varName, declaration, node->fieldName.value, expr, Span(node->varName.span, node->fieldName.span));
+		const std::string fieldType = StructLayout::typeName(assignment->fieldType);
+		if(!isImplicitlyConvertible(expr->evalType(), EvalType(fieldType)))
+			throw std::runtime_error("Can not assign " + expr->evalType().type() + " to field \"" + varName + "." + node->fieldName.value + "\" (" + fieldType + ")");
+
 		return assignment;
 	}
 
@@ -189,25 +363,91 @@ public:
 		return new AST::WhileStatement(scope, visit(node->condition, scope), visit(node->body, scope));
 	}
 
+	inline static const AST::StatementNode* visit(const ParseTree::ForStatement* node, ScopedSymbolTable* scope) {
+		ScopedSymbolTable* localScope = new ScopedSymbolTable("Local For Scope", scope);
+
+		const AST::StatementNode* init = node->init ? visit(node->init, localScope) : nullptr;
+		const AST::ExpressionNode* condition = node->condition ? visit(node->condition, localScope) : nullptr;
+
+		const AST::VariableAssignmentStatement* step = nullptr;
+		if(node->stepExpr) {
+			const std::string& varName = node->stepName.value;
+
+			const Symbol* sym = localScope->lookupRecursive(varName);
+			if(!sym || sym->category != Symbol::Category::VARIABLE)
+				throw std::runtime_error("Assignment to unknown variable \"" + varName + "\" in for loop step");
+
+			step = spanned(new AST::VariableAssignmentStatement(localScope, varName, visit(node->stepExpr, localScope), node->stepName.span), Span(node->stepName.span, node->stepExpr->span()));
+		}
+
+		const AST::StatementNode* body = visit(node->body, localScope);
+
+		if(const AST::StatementNode* counted = countedFor(localScope, init, condition, step, body)) {
+			elideBoundsChecks(dynamic_cast<const AST::CountedForStatement*>(counted));
+			return counted;
+		}
+
+		return new AST::ForStatement(localScope, init, condition, step, body);
+	}
+
+	inline static const AST::StatementNode* visit(const ParseTree::SwitchStatement* node, ScopedSymbolTable* scope) {
+		const AST::ExpressionNode* value = visit(node->value, scope);
+		if(value->evalType().type() != "int")
+			throw std::runtime_error("Switch value must be of type int, got \"" + value->evalType().type() + "\"");
+
+		// the case sections share the enclosing scope (like the bodies of if and while statements)
+		std::vector<const AST::StatementNode*> statements;
+		std::vector<AST::SwitchStatement::Label> labels;
+		std::unordered_set<int> seen;
+		size_t defaultTarget = static_cast<size_t>(-1);
+
+		for(const ParseTree::SwitchStatement::Section& section : node->sections) {
+			for(const ParseTree::SwitchStatement::Label& label : section.labels) {
+				if(label.isDefault()) {
+					if(defaultTarget != static_cast<size_t>(-1))
+						throw std::runtime_error("Multiple default labels in one switch statement");
+					defaultTarget = statements.size();
+					continue;
+				}
+
+				const int labelValue = std::stoi((label.isNegative() ? "-" : "") + label.value.value);
+				if(!seen.insert(labelValue).second)
+					throw std::runtime_error("Duplicate case value " + std::to_string(labelValue) + " in switch statement");
+
+				labels.push_back({ labelValue, statements.size() });
+			}
+
+			for(const ParseTree::StatementNode* statement : section.statements)
+				statements.push_back(visit(statement, scope));
+		}
+
+		if(defaultTarget == static_cast<size_t>(-1))
+			defaultTarget = statements.size(); // no default: skip the whole body
+
+		return new AST::SwitchStatement(scope, value, statements, labels, defaultTarget);
+	}
+
 	inline static const AST::StatementNode* visit(const ParseTree::FunctionDeclarationStatement* node, ScopedSymbolTable* scope) {
 		const std::string& typeName = node->typeName.value;
 		const std::string& functionName = node->functionName.value;
 		
-		if(!scope->lookupRecursive(typeName))
-			throw std::runtime_error("Error declaring function: Unknown return type \"" + typeName + "\"");
+		checkTypename(scope, typeName, "return type of \"" + functionName + "\"");
 		if(scope->lookup(functionName))
 			throw std::runtime_error("Error declaring function: Redeclaration of symbol \"" + functionName + "\"");
 		
 		ScopedSymbolTable* localScope = new ScopedSymbolTable("Local Function Scope", scope);
 
 		std::vector<AST::FunctionDeclarationStatement::Argument> astArgs;
-		for(const ParseTree::ArgumentsNode::Argument& arg : node->args->args)
-			astArgs.push_back({ arg.type.value, arg.name.value });
+		for(const ParseTree::ArgumentsNode::Argument& arg : node->args->args) {
+			checkTypename(scope, arg.type.value, "argument \"" + arg.name.value + "\" of \"" + functionName + "\"");
+			astArgs.push_back({ arg.type.value, arg.name.value, arg.type.span, arg.name.span });
+		}
 	
 		for(const AST::FunctionDeclarationStatement::Argument& arg : astArgs)
 			localScope->declare(new Symbol(Symbol::Category::VARIABLE, arg.name, arg.type));
 
-		AST::FunctionDeclarationStatement* decl = new AST::FunctionDeclarationStatement(localScope, node->typeName.value, node->functionName.value, astArgs, nullptr);
+		AST::FunctionDeclarationStatement* decl = new AST::FunctionDeclarationStatement(localScope, node->typeName.value, node->functionName.value, astArgs, nullptr,
+			node->typeName.span, node->functionName.span, Span(node->openParen.span, node->closeParen.span));
 		scope->declare(new Symbol(Symbol::Category::FUNCTION, functionName, decl));
 
 		const AST::StatementNode* body = visit(node->body, localScope);
@@ -218,12 +458,177 @@ public:
 		return decl;
 	}
 
+	// the layout is fixed here, struct names have to be unique among the visible symbols
+	inline static const AST::StatementNode* visit(const ParseTree::StructDeclarationStatement* node, ScopedSymbolTable* scope) {
+		const std::string& name = node->name.value;
+		if(scope->lookupRecursive(name))
+			throw std::runtime_error("Error declaring struct: Redeclaration of symbol \"" + name + "\"");
+
+		StructLayout layout(name);
+		for(const ParseTree::StructDeclarationStatement::Field& field : node->fields)
+			layout.add(field.name.value, field.type.value);
+
+		const AST::StructDeclarationStatement* decl = new AST::StructDeclarationStatement(scope, layout, node->name.span);
+		scope->declare(new Symbol(Symbol::Category::TYPE, name, static_cast<const AST::Node*>(decl)));
+		return decl;
+	}
+
 	inline static const AST::StatementList* visit(const ParseTree::Program* node, ScopedSymbolTable* scope) {
 		std::vector<const AST::StatementNode*> astStatements;
 
 		for(const ParseTree::StatementNode* statement : node->statements)
 			astStatements.push_back(visit(statement, scope));
 		
-		return new AST::StatementList(scope, astStatements);
+		return spanned(new AST::StatementList(scope, astStatements), node->span());
+	}
+
+private:
+	// arrays and structs are only assigned to variables of the same type (scalars still convert at runtime)
+	inline static void checkReferenceAssignment(const std::string& type, const EvalType& value, const std::string& target) {
+		if((!EvalType(type).isPrimitive() || !value.isPrimitive()) && type != value.type())
+			throw std::runtime_error("Can not assign " + value.type() + " to " + target + " of type " + type);
+	}
+
+	inline static void checkTypename(const ScopedSymbolTable* scope, const std::string& typeName, const std::string& context) {
+		const Symbol* sym = scope->lookupRecursive(typeName);
+		if(!sym || sym->category != Symbol::Category::TYPE)
+			throw std::runtime_error("Unknown typename \"" + typeName + "\" in " + context);
+	}
+
+	// declaration of the struct named type, nullptr for every other type
+	inline static const AST::StructDeclarationStatement* structOf(const ScopedSymbolTable* scope, const std::string& type) {
+		const Symbol* sym = scope->lookupRecursive(type);
+		if(!sym || sym->category != Symbol::Category::TYPE || !std::holds_alternative<const AST::Node*>(sym->type))
+			return nullptr;
+		return dynamic_cast<const AST::StructDeclarationStatement*>(std::get<const AST::Node*>(sym->type));
+	}
+
+	// AST nodes take the source span of the ParseTree node they were generated from
+	template<typename T>
+	inline static T* spanned(T* node, const Span& span) {
+		node->setSpan(span);
+		return node;
+	}
+
+	// true if a variable named name is assigned or (re)declared anywhere inside node
+	inline static bool writes(const AST::Node* node, const std::string& name) {
+		if(const AST::VariableAssignmentStatement* assignment = dynamic_cast<const AST::VariableAssignmentStatement*>(node))
+			if(assignment->varName == name) return true;
+		if(const AST::VariableDeclarationStatement* decl = dynamic_cast<const AST::VariableDeclarationStatement*>(node))
+			if(decl->varName == name) return true;
+
+		bool found = false;
+		node->forEachChild([&](const AST::Node* child) { found = found || writes(child, name); });
+		return found;
+	}
+
+	inline static bool containsCall(const AST::Node* node) {
+		if(dynamic_cast<const AST::FunctionCallExpressionNode*>(node))
+			return true;
+		bool found = false;
+		node->forEachChild([&](const AST::Node* child) { found = found || containsCall(child); });
+		return found;
+	}
+
+	// calls resolve names dynamically, so a callee can write variables the caller's body never mentions. Impure builtins are
+	// treated the same way. Inlined calls need no check: writes() scans their copied bodies like any other statement
+	inline static bool mayWriteUnseen(const AST::Node* node) {
+		if(dynamic_cast<const AST::FunctionCallExpressionNode*>(node))
+			return true;
+		if(const AST::BuiltinCallExpressionNode* call = dynamic_cast<const AST::BuiltinCallExpressionNode*>(node))
+			if(!call->builtin->pure) return true;
+		bool found = false;
+		node->forEachChild([&](const AST::Node* child) { found = found || mayWriteUnseen(child); });
+		return found;
+	}
+
+	// true if expr only consists of literals, operators and variables that body does not write
+	inline static bool isLoopInvariant(const AST::ExpressionNode* expr, const AST::StatementNode* body) {
+		switch(expr->type()) {
+			case AST::ExpressionNode::Type::LITERAL_EXPRESSION:
+				return true;
+			case AST::ExpressionNode::Type::VARIABLE_EXPRESSION:
+				return !writes(body, dynamic_cast<const AST::IdentifierNode*>(expr)->name) && !mayWriteUnseen(body);
+			case AST::ExpressionNode::Type::UNARY_EXPRESSION:
+				return isLoopInvariant(dynamic_cast<const AST::UnaryExpressionNode*>(expr)->a, body);
+			case AST::ExpressionNode::Type::BINARY_EXPRESSION:
+				return isLoopInvariant(dynamic_cast<const AST::BinaryExpressionNode*>(expr)->a, body)
+					&& isLoopInvariant(dynamic_cast<const AST::BinaryExpressionNode*>(expr)->b, body);
+			case AST::ExpressionNode::Type::LENGTH_EXPRESSION:
+				return isLoopInvariant(dynamic_cast<const AST::LengthExpressionNode*>(expr)->array, body); // element assignments keep the length
+			default:
+				return false;
+		}
+	}
+
+	// recognizes "for(int i = start; i < bound; i = i + stride)" (or "<=") whose body does not write i
+	inline static const AST::StatementNode* countedFor(const ScopedSymbolTable* scope, const AST::StatementNode* init, const AST::ExpressionNode* condition, const AST::VariableAssignmentStatement* step, const AST::StatementNode* body) {
+		using Op = AST::BinaryExpressionNode::Operation;
+
+		const AST::VariableDeclarationStatement* decl = dynamic_cast<const AST::VariableDeclarationStatement*>(init);
+		if(!decl || decl->typeName != "int" || !decl->initialAssignment || !isImplicitlyConvertible(decl->initialAssignment->expr->evalType(), EvalType("int")))
+			return nullptr;
+
+		const std::string& var = decl->varName;
+
+		const AST::BinaryExpressionNode* cond = dynamic_cast<const AST::BinaryExpressionNode*>(condition);
+		if(!cond || (cond->op != Op::COMP_LT && cond->op != Op::COMP_LE) || cond->b->evalType().type() != "int")
+			return nullptr;
+
+		const AST::IdentifierNode* condVar = dynamic_cast<const AST::IdentifierNode*>(cond->a);
+		if(!condVar || condVar->name != var)
+			return nullptr;
+
+		if(!step || step->varName != var)
+			return nullptr;
+
+		const AST::BinaryExpressionNode* increment = dynamic_cast<const AST::BinaryExpressionNode*>(step->expr);
+		if(!increment || increment->op != Op::PLUS)
+			return nullptr;
+
+		const AST::IdentifierNode* incrementVar = dynamic_cast<const AST::IdentifierNode*>(increment->a);
+		const AST::IntLiteralNode* stride = dynamic_cast<const AST::IntLiteralNode*>(increment->b);
+		if(!incrementVar || incrementVar->name != var || !stride || stride->value <= 0)
+			return nullptr;
+
+		if(writes(body, var))
+			return nullptr;
+
+		return new AST::CountedForStatement(scope, decl, cond->b, cond->op == Op::COMP_LE, stride->value, isLoopInvariant(cond->b, body), body);
+	}
+
+	// in "for(int i = start; i < len(a); i = i + stride)" with a literal start >= 0, a[i] is in bounds as long as the body
+	// neither writes i nor a. The body must not call functions either: a callee assigning a global of the same name
+	// would write the caller's variable (calls resolve names dynamically). i is checked again here because ProgramImage
+	// runs this on inlined loops, where countedFor() did not see the bodies of the inlined calls.
+	inline static void elideBoundsChecks(const AST::CountedForStatement* loop) {
+		const AST::IntLiteralNode* start = dynamic_cast<const AST::IntLiteralNode*>(loop->init->initialAssignment->expr);
+		const AST::LengthExpressionNode* bound = dynamic_cast<const AST::LengthExpressionNode*>(loop->bound);
+		if(!start || start->value < 0 || !bound || loop->inclusive)
+			return;
+
+		const AST::IdentifierNode* array = dynamic_cast<const AST::IdentifierNode*>(bound->array);
+		if(!array || writes(loop->body, array->name) || writes(loop->body, loop->init->varName) || containsCall(loop->body))
+			return;
+
+		uncheck(loop->body, array->name, loop->init->varName);
+	}
+
+	inline static void uncheck(const AST::Node* node, const std::string& array, const std::string& counter) {
+		const auto isCounter = [&](const AST::ExpressionNode* index) {
+			const AST::IdentifierNode* id = dynamic_cast<const AST::IdentifierNode*>(index);
+			return id && id->name == counter;
+		};
+
+		if(const AST::IndexExpressionNode* n = dynamic_cast<const AST::IndexExpressionNode*>(node)) {
+			const AST::IdentifierNode* id = dynamic_cast<const AST::IdentifierNode*>(n->array);
+			if(id && id->name == array && isCounter(n->index))
+				n->checked = false;
+		} else if(const AST::ElementAssignmentStatement* n = dynamic_cast<const AST::ElementAssignmentStatement*>(node)) {
+			if(n->varName == array && isCounter(n->index))
+				n->checked = false;
+		}
+
+		node->forEachChild([&](const AST::Node* child) { uncheck(child, array, counter); });
 	}
-};
+};
\ No newline at end of file
@@ -0,0 +1,119 @@
+#pragma once
+
+
+#include <unordered_map>
+#include <iostream>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <mutex>
+#include <list>
+
+#include "CompiledProgram.hpp"
+#include "Builtins.hpp"
+
+
+// in-process LRU cache from source text to CompiledProgram, for hosts that evaluate the same snippets over and over.
+// The cache is bounded by the summed CompiledProgram::footprint() of its entries; the least recently used entries are
+// evicted first. A program larger than the whole budget is compiled and returned but not cached.
+// Returned programs stay valid after eviction (shared ownership). All members are thread safe.
+class SnippetCache {
+public:
+	struct Stats {
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;
+		size_t entries = 0;
+		size_t bytes = 0; // summed footprint of the cached programs
+
+		inline double hitRate() const { return hits + misses ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0; }
+
+		inline void print(std::ostream& console) const {
+			console << "Snippet Cache: " << entries << " entries, " << bytes << " bytes, " << hits << " hits, " << misses << " misses (" << hitRate() * 100.0 << "% hit rate), " << evictions << " evictions\n";
+		}
+	};
+
+private:
+	struct Entry {
+		std::string source;
+		std::shared_ptr<const CompiledProgram> program;
+		size_t bytes;
+	};
+
+	const BuiltinRegistry* builtins;
+	size_t maxBytes;
+
+	mutable std::mutex mutex;
+	std::list<Entry> entries; // most recently used first
+	std::unordered_map<std::string, std::list<Entry>::iterator> index; // keyed by source
+	Stats stats_;
+
+public:
+	// builtins (optional) are declared in every compiled program and have to outlive the cache and its programs
+	inline SnippetCache(const size_t maxBytes, const BuiltinRegistry* builtins = nullptr): builtins(builtins), maxBytes(maxBytes) {}
+
+	SnippetCache(const SnippetCache&) = delete;
+
+	// compiled program of source, compiled on a miss. Compile errors are thrown and nothing is cached.
+	inline std::shared_ptr<const CompiledProgram> get(const std::string& source) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if(const auto it = index.find(source); it != index.end()) {
+				entries.splice(entries.begin(), entries, it->second);
+				stats_.hits++;
+				return it->second->program;
+			}
+			stats_.misses++;
+		}
+
+		// compiled without holding the lock, concurrent misses of the same source may compile it twice
+		std::shared_ptr<const CompiledProgram> program = CompiledProgram::compile(source, builtins);
+		const size_t bytes = program->footprint() + 2 * source.capacity(); // plus the entry's and the index's copy of the key
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if(bytes > maxBytes || index.contains(source))
+			return program;
+
+		entries.push_front({ source, program, bytes });
+		index[source] = entries.begin();
+		stats_.bytes += bytes;
+		evict();
+		return program;
+	}
+
+	inline void clear() {
+		std::lock_guard<std::mutex> lock(mutex);
+		entries.clear();
+		index.clear();
+		stats_.bytes = 0;
+	}
+
+	inline void setMaxBytes(const size_t bytes) {
+		std::lock_guard<std::mutex> lock(mutex);
+		maxBytes = bytes;
+		evict();
+	}
+
+	inline Stats stats() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		Stats res = stats_;
+		res.entries = entries.size();
+		return res;
+	}
+
+	inline void resetStats() {
+		std::lock_guard<std::mutex> lock(mutex);
+		stats_.hits = stats_.misses = stats_.evictions = 0;
+	}
+
+private:
+	inline void evict() {
+		while(stats_.bytes > maxBytes && !entries.empty()) {
+			const Entry& last = entries.back();
+			stats_.bytes -= last.bytes;
+			stats_.evictions++;
+			index.erase(last.source);
+			entries.pop_back();
+		}
+	}
+};
@@ -24,13 +24,13 @@ public:
 
 struct Token {
 	enum class Type : uint8_t {
-		VOID, RETURN, IF, WHILE, FOR, DO, SWITCH, CASE, BREAK, CONTINUE,
+		VOID, RETURN, IF, WHILE, FOR, DO, SWITCH, CASE, DEFAULT, BREAK, CONTINUE, STRUCT,
 		
 		BOOL, FLOAT, INT, STRING,
 
 		BOOL_LITERAL, INT_LITERAL, FLOAT_LITERAL, STRING_LITERAL,
 
-		SEMICOLON, COMMA, DOT, EQUAL, PLUS, MINUS, MUL, DIV, PAREN_OPEN, PAREN_CLOSE, BRACE_OPEN, BRACE_CLOSE, SQUARE_OPEN, SQUARE_CLOSE,
+		SEMICOLON, COLON, COMMA, DOT, EQUAL, PLUS, MINUS, MUL, DIV, PAREN_OPEN, PAREN_CLOSE, BRACE_OPEN, BRACE_CLOSE, SQUARE_OPEN, SQUARE_CLOSE,
 		COMP_EQ, COMP_NE, COMP_GT, COMP_LT, COMP_GE, COMP_LE,
 
 		IDENTIFIER,
@@ -78,7 +78,8 @@ struct TokenDefinition {
 	const Token::Type type;
 };
 
-const thread_local TokenDefinition tokenDefinitions[] {
+// compiled once per process, matching only reads the regexes so all threads share them
+inline const TokenDefinition tokenDefinitions[] {
 	// keywords:
 	{ std::regex("(return)\\W"), Token::Type::RETURN },
 	{ std::regex("(if)\\W"), Token::Type::IF },
@@ -87,8 +88,10 @@ const thread_local TokenDefinition tokenDefinitions[] {
 	{ std::regex("(do)\\W"), Token::Type::DO },
 	{ std::regex("(switch)\\W"), Token::Type::SWITCH },
 	{ std::regex("(case)\\W"), Token::Type::CASE },
+	{ std::regex("(default)\\W"), Token::Type::DEFAULT },
 	{ std::regex("(break)\\W"), Token::Type::BREAK },
 	{ std::regex("(continue)\\W"), Token::Type::CONTINUE },
+	{ std::regex("(struct)\\W"), Token::Type::STRUCT },
 
 	// types:
 	{ std::regex("(void)\\W"), Token::Type::VOID },
@@ -105,6 +108,7 @@ const thread_local TokenDefinition tokenDefinitions[] {
 
 	// operators / symbols:
 	{ std::regex("(;)"), Token::Type::SEMICOLON },
+	{ std::regex("(:)"), Token::Type::COLON },
 	{ std::regex("(,)"), Token::Type::COMMA },
 	{ std::regex("(\\.)"), Token::Type::DOT },
 	{ std::regex("(=)[^=]"), Token::Type::EQUAL },
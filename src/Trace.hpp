@@ -0,0 +1,259 @@
+#pragma once
+
+
+#include <unordered_map>
+#include <stdexcept>
+#include <ostream>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <bit>
+
+#include "AST.hpp"
+#include "Value.hpp"
+
+
+// TEXT: formatted trace on the Interpreter's console (default)
+// BINARY: fixed-size events into a TraceBuffer, decoded offline by TraceDecoder
+// NONE: no trace
+enum class TraceMode : uint8_t {
+	TEXT, BINARY, NONE,
+};
+
+
+struct TraceEvent {
+	enum class Kind : uint8_t {
+		ENTER, EXIT, LEAF, // LEAF: node without traced children (literals, identifiers, break, ...)
+	};
+
+	enum class Tag : uint8_t {
+		NONE, VOID, BOOL, INT, FLOAT, STRING, ARRAY, RECORD,
+	};
+
+	uint64_t timestamp; // ns since the TraceBuffer was created
+	uint64_t payload; // bool / int / float bits, length of strings and arrays, size of records
+	uint32_t node; // AST::Node::id()
+	Kind kind;
+	Tag tag;
+
+	inline static TraceEvent make(const uint64_t timestamp, const Kind kind, const AST::Node* node, const Value& value) {
+		TraceEvent res{ timestamp, 0, node->id(), kind, Tag::NONE };
+		if(value.isVoid()) res.tag = Tag::VOID;
+		else if(value.is<bool>()) { res.tag = Tag::BOOL; res.payload = value.get<bool>(); }
+		else if(value.is<int>()) { res.tag = Tag::INT; res.payload = static_cast<uint64_t>(static_cast<int64_t>(value.get<int>())); }
+		else if(value.is<float>()) { res.tag = Tag::FLOAT; res.payload = std::bit_cast<uint32_t>(value.get<float>()); }
+		else if(value.is<std::string>()) { res.tag = Tag::STRING; res.payload = value.get<std::string>().size(); }
+		else if(value.isArray()) { res.tag = Tag::ARRAY; res.payload = value.length(); }
+		else if(value.isRecord()) { res.tag = Tag::RECORD; res.payload = value.get<RecordRef>()->layout->size; }
+		return res;
+	}
+
+	// same format as Value::toString(), except that only the length of strings and arrays (size of records) is recorded
+	inline std::string valueString() const {
+		switch(tag) {
+			case Tag::NONE: return "<NO VALUE>";
+			case Tag::VOID: return "<VOID>";
+			case Tag::BOOL: return payload ? "true" : "false";
+			case Tag::INT: return Value(static_cast<int>(static_cast<int64_t>(payload))).toString();
+			case Tag::FLOAT: return Value(std::bit_cast<float>(static_cast<uint32_t>(payload))).toString();
+			case Tag::STRING: return "<string>(" + std::to_string(payload) + " chars)";
+			case Tag::ARRAY: return "<array>(" + std::to_string(payload) + " elements)";
+			case Tag::RECORD: return "<record>(" + std::to_string(payload) + " bytes)";
+		}
+		return "<INVALID>";
+	}
+};
+static_assert(sizeof(TraceEvent) == 24);
+
+
+// single producer ring buffer, one per interpreting thread: push() never locks or allocates, the oldest events are overwritten.
+class TraceBuffer {
+public:
+	using Clock = std::chrono::steady_clock;
+
+private:
+	// seqlock per slot: seq is 2 * i + 1 while event i is written and 2 * i + 2 once it is complete, so snapshot() can tell
+	// the event it expects from a torn or newer one. The event is stored as relaxed atomic words to keep the racing read defined
+	struct Slot {
+		std::atomic<uint64_t> seq{ 0 };
+		std::atomic<uint64_t> words[3];
+	};
+
+	std::vector<Slot> slots;
+	uint64_t mask;
+	std::atomic<uint64_t> head; // number of events pushed so far
+	Clock::time_point start;
+
+public:
+	// capacity is rounded up to a power of two
+	inline TraceBuffer(const size_t capacity = 1 << 16): slots(std::bit_ceil(std::max<size_t>(capacity, 2))), mask(slots.size() - 1), head(0), start(Clock::now()) {}
+	TraceBuffer(const TraceBuffer&) = delete;
+
+	inline size_t capacity() const { return slots.size(); }
+	inline uint64_t pushed() const { return head.load(std::memory_order_acquire); }
+
+	inline void push(const TraceEvent::Kind kind, const AST::Node* node, const Value& value = Value()) {
+		const uint64_t timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+		const uint64_t h = head.load(std::memory_order_relaxed);
+		const TraceEvent event = TraceEvent::make(timestamp, kind, node, value);
+
+		Slot& slot = slots[h & mask];
+		slot.seq.store(2 * h + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.words[0].store(event.timestamp, std::memory_order_relaxed);
+		slot.words[1].store(event.payload, std::memory_order_relaxed);
+		slot.words[2].store(event.node | static_cast<uint64_t>(event.kind) << 32 | static_cast<uint64_t>(event.tag) << 40, std::memory_order_relaxed);
+		slot.seq.store(2 * h + 2, std::memory_order_release);
+
+		head.store(h + 1, std::memory_order_release);
+	}
+
+	// the retained events, oldest first. May run concurrently with push(): events overwritten while copying are dropped.
+	inline std::vector<TraceEvent> snapshot() const {
+		const uint64_t end = head.load(std::memory_order_acquire);
+		const uint64_t begin = end > slots.size() ? end - slots.size() : 0;
+
+		std::vector<TraceEvent> res;
+		res.reserve(end - begin);
+		for(uint64_t i = begin; i < end; i++) {
+			const Slot& slot = slots[i & mask];
+			const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+			if(seq != 2 * i + 2)
+				continue; // being written or already overwritten
+
+			const uint64_t timestamp = slot.words[0].load(std::memory_order_relaxed);
+			const uint64_t payload = slot.words[1].load(std::memory_order_relaxed);
+			const uint64_t packed = slot.words[2].load(std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if(slot.seq.load(std::memory_order_relaxed) != seq)
+				continue; // overwritten while copying
+
+			res.push_back({ timestamp, payload, static_cast<uint32_t>(packed), static_cast<TraceEvent::Kind>(packed >> 32 & 0xFF), static_cast<TraceEvent::Tag>(packed >> 40 & 0xFF) });
+		}
+
+		return res;
+	}
+
+	inline void clear() {
+		head.store(0, std::memory_order_release);
+	}
+};
+
+
+namespace TraceFormat {
+	// tag name and detail of a node in the human readable trace
+	inline std::pair<const char*, std::string> label(const AST::Node* node) {
+		if(node->baseType() == AST::Node::BaseType::EXPRESSION) {
+			switch(dynamic_cast<const AST::ExpressionNode*>(node)->type()) {
+				case AST::ExpressionNode::Type::LITERAL_EXPRESSION: return { "LiteralExpression", "" };
+				case AST::ExpressionNode::Type::VARIABLE_EXPRESSION: return { "VariableExpression", "\"" + dynamic_cast<const AST::IdentifierNode*>(node)->name + "\"" };
+				case AST::ExpressionNode::Type::UNARY_EXPRESSION: return { "UnaryExpression", dynamic_cast<const AST::UnaryExpressionNode*>(node)->opString() };
+				case AST::ExpressionNode::Type::BINARY_EXPRESSION: return { "BinaryExpression", dynamic_cast<const AST::BinaryExpressionNode*>(node)->opString() };
+				case AST::ExpressionNode::Type::CALL_EXPRESSION: return { "FunctionCall", "\"" + dynamic_cast<const AST::FunctionCallExpressionNode*>(node)->name + "\"" };
+				case AST::ExpressionNode::Type::INLINED_CALL_EXPRESSION: return { "InlinedCall", "\"" + dynamic_cast<const AST::InlinedCallExpressionNode*>(node)->name + "\"" };
+				case AST::ExpressionNode::Type::BUILTIN_CALL_EXPRESSION: return { "BuiltinCall", "\"" + dynamic_cast<const AST::BuiltinCallExpressionNode*>(node)->builtin->name + "\"" };
+				case AST::ExpressionNode::Type::ARRAY_EXPRESSION: return { "ArrayExpression", dynamic_cast<const AST::ExpressionNode*>(node)->evalType().type() };
+				case AST::ExpressionNode::Type::INDEX_EXPRESSION: return { "IndexExpression", dynamic_cast<const AST::IndexExpressionNode*>(node)->checked ? "" : "unchecked" };
+				case AST::ExpressionNode::Type::LENGTH_EXPRESSION: return { "LengthExpression", "" };
+				case AST::ExpressionNode::Type::RECORD_EXPRESSION: return { "RecordExpression", dynamic_cast<const AST::ExpressionNode*>(node)->evalType().type() };
+				case AST::ExpressionNode::Type::FIELD_EXPRESSION: return { "FieldExpression", "\"" + dynamic_cast<const AST::FieldExpressionNode*>(node)->fieldName + "\"" };
+				case AST::ExpressionNode::Type::CONCAT_EXPRESSION: return { "ConcatExpression", std::to_string(dynamic_cast<const AST::ConcatExpressionNode*>(node)->parts.size()) + " parts" };
+			}
+		} else {
+			switch(dynamic_cast<const AST::StatementNode*>(node)->type()) {
+				case AST::StatementNode::Type::EXPRESSION_STATEMENT: return { "ExpressionStatement", "" };
+				case AST::StatementNode::Type::STATEMENT_LIST: return { "StatementList", "" };
+				case AST::StatementNode::Type::RETURN_STATEMENT: return { "ReturnStatement", "" };
+				case AST::StatementNode::Type::IF_STATEMENT: return { "IfStatement", "" };
+				case AST::StatementNode::Type::WHILE_STATEMENT: return { "WhileStatement", "" };
+				case AST::StatementNode::Type::FOR_STATEMENT: return { "ForStatement", "" };
+				case AST::StatementNode::Type::COUNTED_FOR_STATEMENT: return { "CountedForStatement", "\"" + dynamic_cast<const AST::CountedForStatement*>(node)->init->varName + "\"" };
+				case AST::StatementNode::Type::SWITCH_STATEMENT: return { "SwitchStatement", "" };
+				case AST::StatementNode::Type::BREAK_STATEMENT: return { "BreakStatement", "" };
+				case AST::StatementNode::Type::CONTINUE_STATEMENT: return { "ContinueStatement", "" };
+				case AST::StatementNode::Type::FUNCTION_DECLARATION_STATEMENT: return { "FunctionDeclaration", "" };
+				case AST::StatementNode::Type::VARIABLE_DECLARATION_STATEMENT: return { "VariableDeclaration", "" };
+				case AST::StatementNode::Type::VARIABLE_ASSIGNMENT_STATEMENT: return { "VariableAssignment", "\"" + dynamic_cast<const AST::VariableAssignmentStatement*>(node)->varName + "\"" };
+				case AST::StatementNode::Type::ELEMENT_ASSIGNMENT_STATEMENT: return { "ElementAssignment", "\"" + dynamic_cast<const AST::ElementAssignmentStatement*>(node)->varName + "\"" };
+				case AST::StatementNode::Type::FIELD_ASSIGNMENT_STATEMENT: { const AST::FieldAssignmentStatement* n = dynamic_cast<const AST::FieldAssignmentStatement*>(node); return { "FieldAssignment", "\"" + n->varName + "." + n->fieldName + "\"" }; }
+				case AST::StatementNode::Type::STRUCT_DECLARATION_STATEMENT: return { "StructDeclaration", "\"" + dynamic_cast<const AST::StructDeclarationStatement*>(node)->layout.name + "\"" };
+			}
+		}
+		throw std::runtime_error("TraceFormat::label(): invalid Node type");
+	}
+
+	// one line of the text trace, `value` is only printed for expressions
+	inline void write(std::ostream& console, const std::string& indent, const TraceEvent::Kind kind, const AST::Node* node, const std::string& value) {
+		const bool expression = node->baseType() == AST::Node::BaseType::EXPRESSION;
+		auto [name, detail] = label(node);
+		if(expression && dynamic_cast<const AST::ExpressionNode*>(node)->type() == AST::ExpressionNode::Type::LITERAL_EXPRESSION)
+			detail = value;
+
+		console << indent;
+		switch(kind) {
+			case TraceEvent::Kind::ENTER:
+				console << "<" << name << (detail.empty() ? "" : " ") << detail << (expression ? ">:\n" : ">\n");
+				return;
+			case TraceEvent::Kind::EXIT:
+				console << "</" << name << ">";
+				break;
+			case TraceEvent::Kind::LEAF:
+				console << "<" << name << (detail.empty() ? "" : " ") << detail << "/>";
+				if(dynamic_cast<const AST::FunctionDeclarationStatement*>(node))
+					console << " (skipping)";
+				break;
+		}
+		if(expression)
+			console << " => " << value;
+		console << "\n";
+	}
+}
+
+
+// turns the events of a TraceBuffer back into the text trace of TraceMode::TEXT.
+// Only string lengths are recorded, and the variable tables the text trace prints after calls are not part of the events.
+class TraceDecoder {
+private:
+	std::unordered_map<uint32_t, const AST::Node*> nodes; // by AST::Node::id()
+
+public:
+	// `ast` must be the tree that was interpreted (after inlining)
+	inline TraceDecoder(const AST::Node* ast) {
+		collect(ast);
+	}
+
+	inline void decode(const std::vector<TraceEvent>& events, std::ostream& out, const bool timestamps = false) const {
+		std::string indent;
+
+		for(const TraceEvent& event : events) {
+			const auto it = nodes.find(event.node);
+			if(it == nodes.end())
+				throw std::runtime_error("TraceDecoder::decode(): unknown node id " + std::to_string(event.node));
+
+			if(event.kind == TraceEvent::Kind::EXIT && indent.size() >= 2) // the ENTER may have been overwritten in the ring
+				indent.resize(indent.size() - 2);
+
+			if(timestamps)
+				out << "[" << event.timestamp << "] ";
+
+			const AST::Node* node = it->second;
+			const AST::LiteralNode* literal = dynamic_cast<const AST::LiteralNode*>(node);
+			const std::string value = literal && event.tag == TraceEvent::Tag::STRING
+				? Value(dynamic_cast<const AST::StringLiteralNode*>(literal)->value).toString() // string literals can be recovered from the tree
+				: event.valueString();
+			TraceFormat::write(out, indent, event.kind, node, value);
+
+			if(event.kind == TraceEvent::Kind::ENTER)
+				indent += "  ";
+		}
+	}
+
+private:
+	inline void collect(const AST::Node* node) {
+		nodes[node->id()] = node;
+		node->forEachChild([&](const AST::Node* child) { collect(child); });
+	}
+};
@@ -15,6 +15,13 @@ private:
 public:
 	inline EvalType(const std::string& type): type_(type) {}
 	inline const std::string& type() const { return type_; }
+
+	// "bool[]", "int[]" and "float[]", arrays only convert to their own type
+	inline bool isArray() const { return type_.ends_with("[]"); }
+	inline EvalType elementType() const { return EvalType(type_.substr(0, type_.size() - 2)); }
+
+	// everything else is an array or a struct (named like its declaration), both only convert to their own type
+	inline bool isPrimitive() const { return type_ == "bool" || type_ == "int" || type_ == "float" || type_ == "string" || type_ == "void"; }
 };
 
 inline bool isImplicitlyConvertible(const EvalType& src, const EvalType& dst) {
@@ -33,6 +40,9 @@ inline bool isImplicitlyConvertible(const EvalType& src, const EvalType& dst) {
 }
 
 inline EvalType binaryExpressionType(const EvalType& a, const std::string_view op, const EvalType& b) {
+	if(!a.isPrimitive() || !b.isPrimitive())
+		throw std::runtime_error("binaryExpressionType(): operator " + std::string(op) + " is not defined for arrays and structs");
+
 	static const std::vector<std::string> logic_ops { "&&", "||", "==", "!=", "<", ">", "<=", ">=" };
 
 	for(const std::string& op_cur : logic_ops) {
@@ -0,0 +1,343 @@
+#pragma once
+
+
+#include <type_traits>
+#include <stdexcept>
+#include <concepts>
+#include <charconv>
+#include <variant>
+#include <memory>
+#include <string>
+
+#include "InterpreterStats.hpp"
+#include "Record.hpp"
+
+
+// numbers as script strings: ints in decimal, floats as the shortest text that reads back as the same float
+// ("0.1", "1e+20"). Digits are written by std::to_chars straight into the destination, no temporary strings.
+namespace NumberFormat {
+	static constexpr size_t maxChars = 16; // enough for any int and for the shortest text of any float
+
+	template<typename T>
+	inline char* write(char* first, const T v) { return std::to_chars(first, first + maxChars, v).ptr; }
+
+	template<typename T>
+	inline void append(std::string& out, const T v) {
+		const size_t size = out.size();
+		out.resize(size + maxChars);
+		out.resize(write(out.data() + size, v) - out.data());
+	}
+
+	template<typename T>
+	inline std::string toString(const T v) {
+		char buffer[maxChars];
+		return std::string(buffer, write(buffer, v));
+	}
+}
+
+inline std::string operator+(const std::string& a, const int v) { std::string res; res.reserve(a.size() + NumberFormat::maxChars); res += a; NumberFormat::append(res, v); return res; }
+inline std::string operator+(const std::string& a, const float v) { std::string res; res.reserve(a.size() + NumberFormat::maxChars); res += a; NumberFormat::append(res, v); return res; }
+inline std::string operator+(const std::string& a, const bool b) { return a + (b ? "true" : "false"); }
+
+
+// string [- * /] [bool float int string]  =>  string  <exception>
+#define STRING_OP_DEFINE_TYPE(OP, T) \
+	inline std::string OP(const std::string& a, const T& b) { throw std::runtime_error("Tried to execute placeholder string-operation std::string " #OP " " #T); }
+#define STRING_OP_DEFINE(OP) \
+	STRING_OP_DEFINE_TYPE(OP, bool) \
+	STRING_OP_DEFINE_TYPE(OP, float) \
+	STRING_OP_DEFINE_TYPE(OP, int) \
+	STRING_OP_DEFINE_TYPE(OP, std::string)
+STRING_OP_DEFINE(operator-)
+STRING_OP_DEFINE(operator*)
+STRING_OP_DEFINE(operator/)
+#undef STRING_OP_DEFINE_TYPE
+#undef STRING_OP_DEFINE
+
+
+// string [== != > < >= <=] [bool float int string]  =>  bool  <exception>
+#define STRING_OP_DEFINE_TYPE(OP, T) \
+	inline bool OP(const std::string& a, const T& b) { throw std::runtime_error("Tried to execute placeholder string-operation std::string " #OP " " #T); }
+#define STRING_OP_DEFINE(OP) \
+	STRING_OP_DEFINE_TYPE(OP, bool) \
+	STRING_OP_DEFINE_TYPE(OP, float) \
+	STRING_OP_DEFINE_TYPE(OP, int)
+STRING_OP_DEFINE(operator==)
+STRING_OP_DEFINE(operator!=)
+STRING_OP_DEFINE(operator>)
+STRING_OP_DEFINE(operator<)
+STRING_OP_DEFINE(operator>=)
+STRING_OP_DEFINE(operator<=)
+#undef STRING_OP_DEFINE_TYPE
+#undef STRING_OP_DEFINE
+
+
+// T [+ - * /] string  =>  string  <string [+ - * /] T>  (arithmetic T only, see below)
+#define STRING_OP_CORRECT(OP_NAME, OP) \
+	template<typename T> \
+		requires ( \
+			std::is_arithmetic_v<T> && \
+			requires (T a, const std::string& b) { \
+				{b OP a} -> std::convertible_to<std::string>; \
+			} \
+		)  \
+	inline std::string OP_NAME(const T& a, const std::string& b) { return b OP a; }
+STRING_OP_CORRECT(operator+, +)
+STRING_OP_CORRECT(operator-, -)
+STRING_OP_CORRECT(operator*, *)
+STRING_OP_CORRECT(operator/, /)
+#undef STRING_OP_CORRECT
+
+// T [== != > < >= <=] string  =>  bool  <string [== != > < >= <=] T>  ||  <exception>
+// Only for arithmetic T: for any other T, "counter > 0" with e.g. a std::atomic would match as well as the built-in
+// comparison (0 converts to std::string through const char*) and be ambiguous.
+#define STRING_OP_CORRECT(OP_NAME, OP) \
+	template<typename T> \
+		requires ( \
+			std::is_arithmetic_v<T> && \
+			requires (T a, const std::string& b) {{b OP a} -> std::convertible_to<bool>; } \
+		)  \
+	inline bool OP_NAME(const T& a, const std::string& b) { return b OP a; } \
+	template<typename T> \
+		requires ( \
+			std::is_arithmetic_v<T> && \
+			!requires (T a, const std::string& b) {{b OP a} -> std::convertible_to<bool>; } \
+		)  \
+	inline bool OP_NAME(const T& a, const std::string& b) { throw std::runtime_error("Tried to execute placeholder string-operation std::string " #OP " " "UnknownType!!1!"); }
+STRING_OP_CORRECT(operator==, ==)
+STRING_OP_CORRECT(operator!=, !=)
+STRING_OP_CORRECT(operator>, >)
+STRING_OP_CORRECT(operator<, <)
+STRING_OP_CORRECT(operator>=, >=)
+STRING_OP_CORRECT(operator<=, <=)
+#undef STRING_OP_CORRECT
+
+
+// elements of a script array (bool[], int[], float[]): unboxed, in one contiguous block, the length is fixed at creation
+template<typename T>
+struct Array {
+	size_t size;
+	std::unique_ptr<T[]> data;
+
+	inline explicit Array(const size_t size): size(size), data(new T[size]()) {}
+};
+
+// arrays are reference values: copying a Value shares the elements
+template<typename T>
+using ArrayRef = std::shared_ptr<Array<T>>;
+
+// characters of a script string. Strings are immutable, so copying a Value shares them and operators build new ones.
+using StringRef = std::shared_ptr<const std::string>;
+
+
+struct Value {
+private:
+	struct VoidT {};
+	std::variant<std::monostate, VoidT, bool, int, float, StringRef, ArrayRef<bool>, ArrayRef<int>, ArrayRef<float>, RecordRef> value; // std::monostate -> no value
+
+public:
+	inline Value(void): value{} {}
+	inline Value(const bool b): value(b) {}
+	inline Value(const int b): value(b) {}
+	inline Value(const float b): value(b) {}
+	inline Value(const std::string& b): value(std::make_shared<const std::string>(b)) { BCC_STATS_COUNT(stringAllocations); }
+	inline Value(std::string&& b): value(std::make_shared<const std::string>(std::move(b))) { BCC_STATS_COUNT(stringAllocations); }
+	inline Value(const char* b): Value(std::string(b)) {} // not bool
+	inline Value(const StringRef& b): value(b) {}
+	template<typename T>
+	inline Value(const ArrayRef<T>& b): value(b) {}
+	inline Value(const RecordRef& b): value(b) {}
+	inline static Value Void() { return { VoidT() }; }
+
+#ifdef BCC_INTERPRETER_STATS
+	inline Value(const Value& other): value(other.value) { BCC_STATS_COUNT(valueCopies); }
+	inline Value(Value&& other) = default;
+	inline Value& operator=(const Value& other) { value = other.value; BCC_STATS_COUNT(valueCopies); return *this; }
+	inline Value& operator=(Value&& other) = default;
+#endif
+	inline static Value defaultOf(const std::string& type) {
+		if(type == "bool") return Value(false);
+		if(type == "int") return Value(0);
+		if(type == "float") return Value(0.f);
+		if(type == "string") return Value(std::string());
+		if(type == "bool[]") return Value(std::make_shared<Array<bool>>(0));
+		if(type == "int[]") return Value(std::make_shared<Array<int>>(0));
+		if(type == "float[]") return Value(std::make_shared<Array<float>>(0));
+		throw std::runtime_error("Value::defaultOf(): no default value for type \"" + type + "\"");
+	}
+
+private:
+	inline Value(const VoidT& v): value(v) {}
+
+public:
+	// T = std::string reads the shared characters in place
+	template<typename T>
+	inline bool is() const {
+		if constexpr(std::is_same_v<T, std::string>) return std::holds_alternative<StringRef>(value);
+		else return std::holds_alternative<T>(value);
+	}
+	inline bool isEmpty() const { return is<std::monostate>(); }
+	inline bool isVoid() const { return is<VoidT>(); }
+	inline bool isConvertibleToBool() const { return is<bool>() || is<int>(); }
+	inline bool isArray() const { return is<ArrayRef<bool>>() || is<ArrayRef<int>>() || is<ArrayRef<float>>(); }
+	inline bool isRecord() const { return is<RecordRef>(); }
+
+	template<typename T>
+	inline std::conditional_t<std::is_same_v<T, std::string>, const std::string&, T> get() const {
+		if constexpr(std::is_same_v<T, std::string>) return *std::get<StringRef>(value);
+		else return std::get<T>(value);
+	}
+
+	// nullptr if the value is not a T, reads arrays without copying the reference
+	template<typename T>
+	inline const T* getIf() const { return std::get_if<T>(&value); }
+
+	inline size_t length() const {
+		if(is<ArrayRef<bool>>()) return get<ArrayRef<bool>>()->size;
+		if(is<ArrayRef<int>>()) return get<ArrayRef<int>>()->size;
+		if(is<ArrayRef<float>>()) return get<ArrayRef<float>>()->size;
+		throw std::runtime_error("Value::length(): " + toString() + " is not an array");
+	}
+
+	template<typename T>
+	inline T to() const;
+
+	template<>
+	inline bool to<bool>() const {
+		if(is<bool>()) return get<bool>();
+		if(is<int>()) return get<int>();
+		throw std::runtime_error("Value::convert: Tried to convert non-bool-converible Value to bool");
+	}
+
+	template<>
+	inline int to<int>() const {
+		if(is<bool>()) return get<bool>();
+		if(is<int>()) return get<int>();
+		throw std::runtime_error("Value::convert: Tried to convert non-int-converible Value to int");
+	}
+
+	template<>
+	inline float to<float>() const {
+		if(is<bool>()) return get<bool>();
+		if(is<int>()) return get<int>();
+		if(is<float>()) return get<float>();
+		throw std::runtime_error("Value::convert: Tried to convert non-float-converible Value to float");
+	}
+
+	template<>
+	inline std::string to<std::string>() const {
+		if(is<bool>()) return get<bool>() ? "true" : "false";
+		if(is<int>()) return NumberFormat::toString(get<int>());
+		if(is<float>()) return NumberFormat::toString(get<float>());
+		if(is<std::string>()) return get<std::string>();
+		throw std::runtime_error("Value::convert: Tried to convert non-string-converible Value to string");
+	}
+
+	// appends to<std::string>() to out without creating it as a temporary
+	inline void appendTo(std::string& out) const {
+		if(is<std::string>()) out += get<std::string>();
+		else if(is<bool>()) out += get<bool>() ? "true" : "false";
+		else if(is<int>()) NumberFormat::append(out, get<int>());
+		else if(is<float>()) NumberFormat::append(out, get<float>());
+		else throw std::runtime_error("Value::convert: Tried to convert non-string-converible Value to string");
+	}
+
+	template<>
+	inline ArrayRef<bool> to<ArrayRef<bool>>() const {
+		if(is<ArrayRef<bool>>()) return get<ArrayRef<bool>>();
+		throw std::runtime_error("Value::convert: Tried to convert " + toString() + " to bool[]");
+	}
+
+	template<>
+	inline ArrayRef<int> to<ArrayRef<int>>() const {
+		if(is<ArrayRef<int>>()) return get<ArrayRef<int>>();
+		throw std::runtime_error("Value::convert: Tried to convert " + toString() + " to int[]");
+	}
+
+	template<>
+	inline ArrayRef<float> to<ArrayRef<float>>() const {
+		if(is<ArrayRef<float>>()) return get<ArrayRef<float>>();
+		throw std::runtime_error("Value::convert: Tried to convert " + toString() + " to float[]");
+	}
+
+	// this value converted to the script type named type ("void" only accepts void values)
+	inline Value as(const std::string& type) const {
+		if(type == "bool") return Value(to<bool>());
+		if(type == "int") return Value(to<int>());
+		if(type == "float") return Value(to<float>());
+		if(type == "string") return is<std::string>() ? *this : Value(to<std::string>());
+		if(type == "void" && isVoid()) return *this;
+		if((type == "bool[]" && is<ArrayRef<bool>>()) || (type == "int[]" && is<ArrayRef<int>>()) || (type == "float[]" && is<ArrayRef<float>>())) return *this;
+		if(isRecord() && get<RecordRef>()->layout->name == type) return *this;
+		throw std::runtime_error("Value::as(): cannot convert " + toString() + " to \"" + type + "\"");
+	}
+
+	inline std::string toString() const {
+		if(isEmpty()) return "<NO VALUE>";
+		if(isVoid()) return "<VOID>";
+		if(is<bool>()) return (get<bool>() ? "true" : "false");
+		if(is<int>()) return "<int>" + NumberFormat::toString(get<int>());
+		if(is<float>()) return "<float>" + NumberFormat::toString(get<float>());
+		if(is<std::string>()) return "<string>\"" + get<std::string>() + "\"";
+		if(is<ArrayRef<bool>>()) return arrayString("bool", *get<ArrayRef<bool>>());
+		if(is<ArrayRef<int>>()) return arrayString("int", *get<ArrayRef<int>>());
+		if(is<ArrayRef<float>>()) return arrayString("float", *get<ArrayRef<float>>());
+		if(isRecord()) return recordString(*get<RecordRef>());
+		throw std::runtime_error("Error printing interpreter value: unknown variant type");
+	}
+
+private:
+	// the first elements only, traces print every value
+	template<typename T>
+	inline static std::string arrayString(const std::string& type, const Array<T>& array) {
+		static constexpr size_t shown = 8;
+		std::string res = "<" + type + "[" + std::to_string(array.size) + "]>{";
+		for(size_t i = 0; i < array.size && i < shown; i++)
+			res += std::string(i ? ", " : "") + array.data[i]; // string operator+ above
+		return res + (array.size > shown ? ", ...}" : "}");
+	}
+
+	inline static std::string recordString(const Record& record) {
+		std::string res = "<" + record.layout->name + ">{";
+		for(const StructLayout::Field& field : record.layout->fields) {
+			res += std::string(&field == &record.layout->fields.front() ? "" : ", ") + field.name + ": ";
+			switch(field.type) {
+				case StructLayout::FieldType::BOOL: res = res + record.load<bool>(field.offset); break;
+				case StructLayout::FieldType::INT: res = res + record.load<int>(field.offset); break;
+				case StructLayout::FieldType::FLOAT: res = res + record.load<float>(field.offset); break;
+			}
+		}
+		return res + "}";
+	}
+
+public:
+	#define typeCaseAB(TA, OP, TB) \
+		if(is<TA>() && other.is<TB>()) return get<TA>() OP other.get<TB>();
+	#define typeCaseA(TA, OP) \
+		typeCaseAB(TA, OP, bool) \
+		typeCaseAB(TA, OP, int) \
+		typeCaseAB(TA, OP, float) \
+		typeCaseAB(TA, OP, std::string)
+	#define opImpl(OP_NAME, OP) \
+		inline Value OP_NAME(const Value& other) const { \
+			BCC_STATS_COUNT(valueOperations); \
+			typeCaseA(bool, OP) \
+			typeCaseA(int, OP) \
+			typeCaseA(float, OP) \
+			typeCaseA(std::string, OP) \
+			throw std::runtime_error("Error executing Interpreter::Value::" #OP_NAME "(): unsipported types " + toString() + ", " + other.toString()); \
+		}
+	opImpl(operator+, +)
+	opImpl(operator-, -)
+	opImpl(operator*, *)
+	opImpl(operator/, /)
+	opImpl(operator==, ==)
+	opImpl(operator!=, !=)
+	opImpl(operator>, >)
+	opImpl(operator<, <)
+	opImpl(operator>=, >=)
+	opImpl(operator<=, <=)
+	#undef opImpl
+	#undef typeCaseA
+	#undef typeCaseAB
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+
+// fork-join thread pool: every worker owns a deque, forks push to the back of the forking thread's deque,
+// idle threads steal from the front of the other deques. join() runs queued tasks while waiting,
+// so nested fork / join never blocks a worker. Threads outside the pool share one submission deque.
+class WorkStealingPool {
+public:
+	class Task {
+	private:
+		friend class WorkStealingPool;
+		std::function<void()> function;
+		std::atomic<bool> done;
+		std::exception_ptr error;
+
+	public:
+		inline Task(std::function<void()> function): function(std::move(function)), done(false) {}
+		Task(const Task&) = delete;
+	};
+
+private:
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Task*> tasks;
+	};
+
+	std::vector<std::unique_ptr<Queue>> queues; // [0]: threads outside the pool, [i + 1]: worker i
+	std::vector<std::thread> workers;
+	std::atomic<size_t> pending; // forked tasks not yet started
+	std::atomic<bool> stopping;
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+
+	inline static thread_local const WorkStealingPool* currentPool = nullptr;
+	inline static thread_local size_t currentQueue = 0;
+
+public:
+	inline WorkStealingPool(const size_t threads = std::max(1u, std::thread::hardware_concurrency())): pending(0), stopping(false) {
+		for(size_t i = 0; i <= threads; i++)
+			queues.push_back(std::make_unique<Queue>());
+		for(size_t i = 0; i < threads; i++)
+			workers.emplace_back([this, i] { work(i + 1); });
+	}
+
+	WorkStealingPool(const WorkStealingPool&) = delete;
+
+	inline ~WorkStealingPool() {
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for(std::thread& worker : workers)
+			worker.join();
+	}
+
+	inline size_t threadCount() const { return workers.size(); }
+	inline size_t pendingCount() const { return pending.load(std::memory_order_relaxed); }
+
+	// queues the task, it has to stay alive until join() returned
+	inline void fork(Task* task) {
+		Queue& queue = *queues[ownQueue()];
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.tasks.push_back(task);
+		}
+		pending++;
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		wake.notify_one();
+	}
+
+	// waits for the task, executing queued tasks meanwhile. Rethrows an exception thrown by the task.
+	inline void join(Task* task) {
+		const size_t own = ownQueue();
+		while(!task->done.load(std::memory_order_acquire))
+			if(!runOne(own))
+				std::this_thread::yield();
+
+		if(task->error)
+			std::rethrow_exception(task->error);
+	}
+
+private:
+	inline size_t ownQueue() const {
+		return currentPool == this ? currentQueue : 0;
+	}
+
+	inline void work(const size_t index) {
+		currentPool = this;
+		currentQueue = index;
+
+		while(!stopping) {
+			if(runOne(index))
+				continue;
+
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			wake.wait(lock, [&] { return stopping || pending.load() > 0; });
+		}
+	}
+
+	// runs the newest task of the own deque, or steals the oldest task of another one
+	inline bool runOne(const size_t own) {
+		Task* task = pop(*queues[own], true);
+		for(size_t i = 1; !task && i < queues.size(); i++)
+			task = pop(*queues[(own + i) % queues.size()], false);
+
+		if(!task)
+			return false;
+
+		pending--;
+		try {
+			task->function();
+		} catch(...) {
+			task->error = std::current_exception();
+		}
+		task->done.store(true, std::memory_order_release);
+		return true;
+	}
+
+	inline static Task* pop(Queue& queue, const bool back) {
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if(queue.tasks.empty())
+			return nullptr;
+
+		Task* task = back ? queue.tasks.back() : queue.tasks.front();
+		if(back)
+			queue.tasks.pop_back();
+		else
+			queue.tasks.pop_front();
+		return task;
+	}
+};
@@ -0,0 +1,204 @@
+#include <filesystem>
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "CompiledProgram.hpp"
+#include "ProgramImage.hpp"
+#include "ProgramCache.hpp"
+#include "Interpreter.hpp"
+#include "Builtins.hpp"
+
+
+// bcc_image_test [--corpus dir]
+//
+// Writes every script of the corpus (*.bcc) plus a sample using structs, arrays, loops and switch
+// to a ProgramImage, reads it back and checks that
+// - the decoded program prints the same AST and runs to the same output as a direct compile
+// - every truncated image and every image with a flipped byte is rejected
+// - images with a flipped byte and a recomputed checksum are rejected or decoded, never crash the reader
+// - a ProgramCache entry is reused, and compiled again once it was corrupted
+// Exit code 1 if a check failed.
+
+#ifndef BCC_TEST_CORPUS
+#define BCC_TEST_CORPUS "bench/scripts"
+#endif
+
+
+struct Script {
+	std::string name;
+	std::string source;
+};
+
+constexpr const char* sample = R"(
+struct Point { int x; float y; }
+Point make(int x) { Point p; p.x = x; p.y = x * 0.5; return p; }
+int[] a = [1, 2, 3, 4];
+int s = 0;
+for(int i = 0; i < len(a); i = i + 1) { a[i] = a[i] * 2; s = s + a[i]; }
+Point q = make(s);
+string label = "";
+switch(s) { case 20: label = "twenty"; break; default: label = "other"; }
+int n = 0;
+while(n < 3) n = n + 1;
+while(n > 0) { n = n - 1; if(n == 1) continue; }
+string text = label + " " + q.y + " " + len(label);
+)";
+
+size_t failures = 0;
+
+inline void check(const bool ok, const std::string& what) {
+	if(!ok) {
+		std::cout << "FAIL: " << what << "\n";
+		failures++;
+	}
+}
+
+inline std::vector<Script> loadCorpus(const std::filesystem::path& dir) {
+	std::vector<Script> res;
+
+	if(std::filesystem::is_directory(dir)) {
+		for(const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(dir)) {
+			if(entry.path().extension().string() != ".bcc")
+				continue;
+
+			std::ifstream file(entry.path(), std::ios::binary);
+			std::stringstream ss;
+			ss << file.rdbuf();
+			res.push_back({ entry.path().stem().string(), ss.str() + "\n" }); // the lexer needs a character after the last token
+		}
+	} else {
+		std::cout << "FAIL: corpus directory \"" << dir.string() << "\" not found\n";
+		failures++;
+	}
+
+	std::sort(res.begin(), res.end(), [](const Script& a, const Script& b) { return a.name < b.name; });
+	res.push_back({ "sample", sample });
+	return res;
+}
+
+inline std::string printed(const CompiledProgram& program) {
+	std::ostringstream out;
+	program.ast()->print(out, "", true);
+	return out.str();
+}
+
+// trace and final global variables
+inline std::string output(const std::shared_ptr<const CompiledProgram>& program) {
+	std::ostringstream out;
+	Interpreter interpreter(program, out);
+	interpreter.run();
+	return out.str();
+}
+
+inline bool rejected(const std::string& image, const uint64_t key, const BuiltinRegistry& builtins) {
+	try {
+		ProgramImage::read(image.data(), image.size(), key, &builtins);
+		return false;
+	} catch(const std::exception&) {
+		return true;
+	}
+}
+
+inline void testRoundTrip(const Script& script, const BuiltinRegistry& builtins) {
+	const uint64_t key = ProgramCache::key(script.source, &builtins);
+	const std::shared_ptr<const CompiledProgram> direct = CompiledProgram::compile(script.source, &builtins);
+	const std::string image = ProgramImage::write(*direct, key);
+
+	const std::shared_ptr<const CompiledProgram> decoded = ProgramImage::read(image.data(), image.size(), key, &builtins);
+	check(printed(*decoded) == printed(*direct), script.name + ": decoded AST differs");
+	check(output(decoded) == output(direct), script.name + ": decoded program runs differently");
+	check(rejected(image, key + 1, builtins), script.name + ": image accepted for another key");
+
+	size_t truncations = 0, flips = 0;
+	for(size_t size = 0; size < image.size(); size++)
+		truncations += !rejected(image.substr(0, size), key, builtins);
+	for(size_t i = 0; i < image.size(); i++) {
+		std::string corrupted = image;
+		corrupted[i] ^= static_cast<char>(1 << (i % 8));
+		flips += !rejected(corrupted, key, builtins);
+	}
+	check(truncations == 0, script.name + ": " + std::to_string(truncations) + " truncated images accepted");
+	check(flips == 0, script.name + ": " + std::to_string(flips) + " images with a flipped byte accepted");
+
+	// past the checksum the reader has to validate the structure on its own
+	const size_t payload = image.size() - sizeof(uint64_t);
+	for(size_t i = 0; i < payload; i++) {
+		std::string corrupted = image;
+		corrupted[i] ^= static_cast<char>(1 << (i % 8));
+		const uint64_t sum = ProgramImage::checksum(corrupted.data(), payload);
+		std::memcpy(corrupted.data() + payload, &sum, sizeof(sum));
+
+		try {
+			const std::shared_ptr<const CompiledProgram> program = ProgramImage::read(corrupted.data(), corrupted.size(), key, &builtins);
+			printed(*program);
+		} catch(const std::exception&) {}
+	}
+}
+
+inline void testCache(const Script& script, const BuiltinRegistry& builtins) {
+	const std::filesystem::path dir = std::filesystem::temp_directory_path() / std::filesystem::path("bcc_image_test");
+	std::filesystem::remove_all(dir);
+
+	{
+		ProgramCache cache(dir);
+		const std::string expected = output(cache.compile(script.source, &builtins));
+		check(output(cache.compile(script.source, &builtins)) == expected, "cache: cached program runs differently");
+		check(cache.misses() == 1 && cache.hits() == 1, "cache: entry not reused");
+
+		const std::filesystem::path file = cache.path(ProgramCache::key(script.source, &builtins));
+		const size_t size = std::filesystem::file_size(file);
+		{
+			std::fstream f(file, std::ios::in | std::ios::out | std::ios::binary);
+			f.seekg(static_cast<std::streamoff>(size / 2));
+			const char c = static_cast<char>(f.get());
+			f.seekp(static_cast<std::streamoff>(size / 2));
+			f.put(static_cast<char>(~c));
+		}
+
+		check(output(cache.compile(script.source, &builtins)) == expected, "cache: corrupted entry runs differently");
+		check(cache.misses() == 2, "cache: corrupted entry not compiled again");
+		cache.compile(script.source, &builtins);
+		check(cache.hits() == 2, "cache: rewritten entry not reused");
+	}
+
+	std::filesystem::remove_all(dir);
+}
+
+int main(int argc, char** argv) {
+	std::string corpus = BCC_TEST_CORPUS;
+	for(int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		if(arg == "--corpus" && i + 1 < argc) corpus = argv[++i];
+		else {
+			std::cerr << "usage: bcc_image_test [--corpus dir]\n";
+			return 1;
+		}
+	}
+
+	BuiltinRegistry builtins;
+	builtins.addStandardLibrary();
+
+	const std::vector<Script> scripts = loadCorpus(corpus);
+	for(const Script& script : scripts) {
+		try {
+			testRoundTrip(script, builtins);
+		} catch(const std::exception& e) {
+			check(false, script.name + ": " + e.what());
+		}
+	}
+
+	try {
+		testCache(scripts.back(), builtins);
+	} catch(const std::exception& e) {
+		check(false, std::string("cache: ") + e.what());
+	}
+
+	std::cout << scripts.size() << " scripts, " << failures << " failures\n";
+	return failures ? 1 : 0;
+}